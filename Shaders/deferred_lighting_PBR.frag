@@ -1,7 +1,32 @@
 #version 410 core
 
+// Variant switches (see ShaderPermutations): DIR_LIGHT, CLUSTERED, LIGHT_VOLUMES, POINT_VOLUME, SPOT_VOLUME,
+// SHADOWS, QUALITY
+#define QUALITY_LOW 0
+#define QUALITY_MEDIUM 1
+#define QUALITY_HIGH 2
+#ifndef QUALITY
+#define QUALITY QUALITY_HIGH
+#endif
+
+// Light-volume path (see DeferredRenderer::renderLightVolumes): the point and spot lights are drawn as
+// instanced volumes, one light per fragment, and a full-screen LIGHT_VOLUMES pass adds the ambient and
+// directional lights. All of them are summed in linear HDR and tonemapped once by tonemap.frag
+#if defined(POINT_VOLUME) || defined(SPOT_VOLUME)
+#define VOLUME_PASS
+#endif
+#if defined(VOLUME_PASS) || defined(LIGHT_VOLUMES)
+#define LINEAR_OUTPUT
+#endif
+
 // Input from vertex shader
+#ifdef VOLUME_PASS
+flat in int LightIndex;
+uniform vec2 screenSize;
+vec2 TexCoord;  // Of this pixel in the G-buffer
+#else
 in vec2 TexCoord;
+#endif
 
 // Output final color
 out vec4 FragColor;
@@ -16,23 +41,51 @@ uniform sampler2D gAO;
 // Camera position
 uniform vec3 viewPos;
 
-// Light uniforms - using a more reasonable limit that fits within OpenGL constraints
-uniform vec3 lightPositions[64];
-uniform vec3 lightColors[64];
-uniform int numLights;
+// Light buffers (see LightManager): one block of `stride` texels per stream, light i at texel i of each
+// Point lights: position (w: influence radius), color
+uniform samplerBuffer pointLights;
+uniform int pointLightCount;
+uniform int pointLightStride;
+
+// Spotlights: position (w: influence radius), direction (w: outer cutoff), color (w: inner cutoff)
+uniform samplerBuffer spotLights;
+uniform int spotLightCount;
+uniform int spotLightStride;
+
+// Directional lights: direction, color
+#ifdef DIR_LIGHT
+uniform samplerBuffer dirLights;
+uniform int dirLightCount;
+uniform int dirLightStride;
+#endif
 
-// Spotlight uniforms
-uniform vec3 spotLightPositions[64];
-uniform vec3 spotLightDirections[64];
-uniform vec3 spotLightColors[64];
-uniform float spotLightInnerCutoffs[64];
-uniform float spotLightOuterCutoffs[64];
-uniform int numSpotLights;
+// Light clusters (see LightClusters): the view is split into tiles on screen and exponential depth slices.
+// Each cluster's texel holds where its point light indices start in clusterLightIndices, followed by its
+// spotlight indices, and how many of each it has
+#ifdef CLUSTERED
+uniform usamplerBuffer clusterTable;          // (first index, point lights, spotlights, unused)
+uniform usamplerBuffer clusterLightIndices;
+uniform ivec3 clusterGrid;                    // Tiles across, tiles down, depth slices
+uniform vec2 clusterTileSize;                 // In pixels
+uniform float clusterSliceScale;              // Slice of a view depth d: log(d) * scale + bias
+uniform float clusterSliceBias;
+uniform mat4 view;
+#endif
 
-// Directional light uniforms
-uniform vec3 dirLightDirection;
-uniform vec3 dirLightColor;
-uniform bool hasDirLight;
+// Shadow maps (see ShadowAtlas): tiles of one depth atlas. Each map's matrix takes a world position to its
+// tile's [0, 1] square and depth, and its rect places that square in the atlas (offset, size). Cascades of the
+// first directional light come finest first; spotlights' maps are found through a table indexed by light slot
+#ifdef SHADOWS
+#define MAX_CASCADES 4
+uniform sampler2DShadow shadowAtlas;
+uniform int cascadeCount;
+uniform mat4 cascadeMatrices[MAX_CASCADES];
+uniform vec4 cascadeRects[MAX_CASCADES];
+uniform float cascadeTexelSizes[MAX_CASCADES];        // World units
+// Five texels per spotlight slot: rect offset and size with world units per unit of distance in w (size 0
+// when it has no map), then the four columns of its matrix
+uniform samplerBuffer spotShadows;
+#endif
 
 // PBR constants
 const float PI = 3.14159265359;
@@ -76,19 +129,93 @@ vec3 fresnelSchlick(float cosTheta, vec3 F0)
     return F0 + (1.0 - F0) * pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }
 
+// Inverse-square falloff, faded to zero at the light's influence radius so lights can be culled beyond it
+float attenuate(float distance, float radius)
+{
+    float x = distance / max(radius, 0.0001);
+    float window = clamp(1.0 - x * x * x * x, 0.0, 1.0);
+    return window * window / max(distance * distance, 0.0001);
+}
+
+#ifdef SHADOWS
+// Fraction of light reaching a point at a tile position (xy in [0, 1], depth in z). The atlas compares and
+// filters bilinearly, so each tap is already a 2x2 percentage-closer filter
+float sampleShadowTile(vec3 tilePos, vec4 rect)
+{
+    vec2 texel = 1.0 / vec2(textureSize(shadowAtlas, 0));
+    vec2 uv = rect.xy + tilePos.xy * rect.zw;
+    // Keep the filter off the neighbouring tiles
+    vec2 lo = rect.xy + texel * 1.5;
+    vec2 hi = rect.xy + rect.zw - texel * 1.5;
+#if QUALITY == QUALITY_HIGH
+    float lit = 0.0;
+    for(int i = 0; i < 4; ++i)
+    {
+        vec2 offset = (vec2(i & 1, i >> 1) - 0.5) * texel;
+        lit += texture(shadowAtlas, vec3(clamp(uv + offset, lo, hi), tilePos.z));
+    }
+    return lit * 0.25;
+#else
+    return texture(shadowAtlas, vec3(clamp(uv, lo, hi), tilePos.z));
+#endif
+}
+
+// The finest cascade that covers the point; lit beyond them. The point is pushed out along its normal by a
+// texel or so, so surfaces don't shadow themselves
+float directionalShadow(vec3 FragPos, vec3 N)
+{
+    for(int i = 0; i < cascadeCount; ++i)
+    {
+        vec3 tilePos = (cascadeMatrices[i] * vec4(FragPos + N * cascadeTexelSizes[i] * 1.5, 1.0)).xyz;
+        if (all(greaterThan(tilePos, vec3(0.0))) && all(lessThan(tilePos, vec3(1.0)))) {
+            return sampleShadowTile(tilePos, cascadeRects[i]);
+        }
+    }
+    return 1.0;
+}
+
+// Lit unless the spotlight in this slot has a map that says otherwise
+float spotShadow(int light, vec3 FragPos, vec3 N, float distance)
+{
+    int base = light * 5;
+    vec4 tile = texelFetch(spotShadows, base);
+    if (tile.z == 0.0) {
+        return 1.0;
+    }
+    mat4 matrix = mat4(texelFetch(spotShadows, base + 1), texelFetch(spotShadows, base + 2),
+                       texelFetch(spotShadows, base + 3), texelFetch(spotShadows, base + 4));
+    vec4 clip = matrix * vec4(FragPos + N * tile.w * distance * 1.5, 1.0);
+    vec3 tilePos = clip.xyz / clip.w;
+    if (clip.w <= 0.0 || any(lessThan(tilePos, vec3(0.0))) || any(greaterThan(tilePos, vec3(1.0)))) {
+        return 1.0;
+    }
+    return sampleShadowTile(tilePos, vec4(tile.xy, tile.zz));
+}
+#endif
+
 // Calculate PBR lighting contribution for a given light direction and radiance
 vec3 calculatePBRContribution(vec3 L, vec3 radiance, vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec3 F0)
 {
     vec3 H = normalize(V + L);
     
+#if QUALITY == QUALITY_LOW
+    // Lambert with Schlick Fresnel only
+    vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+    vec3 specular = vec3(0.0);
+#else
     // Cook-Torrance BRDF
     float NDF = DistributionGGX(N, H, roughness);   
-    float G   = GeometrySmith(N, V, L, roughness);      
     vec3 F    = fresnelSchlick(max(dot(H, V), 0.0), F0);
-           
+#if QUALITY == QUALITY_HIGH
+    float G   = GeometrySmith(N, V, L, roughness);      
     vec3 numerator    = NDF * G * F; 
     float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
     vec3 specular = numerator / denominator;
+#else
+    // Implicit geometry term: G = NdotL * NdotV cancels the denominator
+    vec3 specular = NDF * F * 0.25;
+#endif
+#endif
     
     // Energy conservation
     vec3 kS = F;
@@ -101,11 +228,55 @@ vec3 calculatePBRContribution(vec3 L, vec3 radiance, vec3 N, vec3 V, vec3 albedo
     // Return outgoing radiance
     return (kD * albedo / PI + specular) * radiance * NdotL;
 }
+vec3 shadePointLight(int i, vec3 FragPos, vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec3 F0)
+{
+    vec4 positionRadius = texelFetch(pointLights, i);
+    vec3 lightColor = texelFetch(pointLights, pointLightStride + i).rgb;
+    vec3 L = normalize(positionRadius.xyz - FragPos);
+    float distance = length(positionRadius.xyz - FragPos);
+    vec3 radiance = lightColor * attenuate(distance, positionRadius.w);
+    
+    return calculatePBRContribution(L, radiance, N, V, albedo, metallic, roughness, F0);
+}
+
+vec3 shadeSpotLight(int i, vec3 FragPos, vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec3 F0)
+{
+    vec4 positionRadius = texelFetch(spotLights, i);
+    vec4 directionOuter = texelFetch(spotLights, spotLightStride + i);
+    vec4 colorInner = texelFetch(spotLights, 2 * spotLightStride + i);
+    vec3 L = normalize(positionRadius.xyz - FragPos);
+    float distance = length(positionRadius.xyz - FragPos);
+    
+    // Calculate spotlight intensity based on angle
+    float theta = dot(-L, directionOuter.xyz);
+    float epsilon = colorInner.w - directionOuter.w;
+    float intensity = clamp((theta - directionOuter.w) / max(epsilon, 0.0001), 0.0, 1.0);
+    
+    vec3 radiance = colorInner.rgb * attenuate(distance, positionRadius.w) * intensity;
+#ifdef SHADOWS
+    if (intensity > 0.0) {
+        radiance *= spotShadow(i, FragPos, N, distance);
+    }
+#endif
+    
+    return calculatePBRContribution(L, radiance, N, V, albedo, metallic, roughness, F0);
+}
+
 void main() {
+#ifdef VOLUME_PASS
+    TexCoord = gl_FragCoord.xy / screenSize;
+#endif
+
+    // Background: nothing was drawn here, so there is nothing to light
+    vec4 albedoCoverage = texture(gAlbedo, TexCoord);
+    if (albedoCoverage.a == 0.0) {
+        discard;
+    }
+
     // Read data from G-Buffer
     vec3 FragPos = texture(gPosition, TexCoord).rgb;
     vec3 N = texture(gNormal, TexCoord).rgb;
-    vec3 albedo = texture(gAlbedo, TexCoord).rgb;
+    vec3 albedo = albedoCoverage.rgb;
     vec2 MetallicRoughness = texture(gMetallicRoughness, TexCoord).rg;
     float metallic = MetallicRoughness.x;
     float roughness = MetallicRoughness.y;
@@ -124,87 +295,79 @@ void main() {
         // Calculate lighting contribution
     vec3 Lo = vec3(0.0);
     
+#if defined(POINT_VOLUME)
+    Lo += shadePointLight(LightIndex, FragPos, N, V, albedo, metallic, roughness, F0);
+#elif defined(SPOT_VOLUME)
+    Lo += shadeSpotLight(LightIndex, FragPos, N, V, albedo, metallic, roughness, F0);
+#elif defined(LIGHT_VOLUMES)
+    // Point and spot lights are drawn as volumes
+#elif defined(CLUSTERED)
+    // Only the lights whose influence reaches this pixel's cluster
+    float viewDepth = -(view * vec4(FragPos, 1.0)).z;
+    ivec3 clusterCoord = ivec3(ivec2(gl_FragCoord.xy / clusterTileSize),
+                               int(log(max(viewDepth, 0.0001)) * clusterSliceScale + clusterSliceBias));
+    clusterCoord = clamp(clusterCoord, ivec3(0), clusterGrid - 1);
+    uvec4 cluster = texelFetch(clusterTable,
+                               (clusterCoord.z * clusterGrid.y + clusterCoord.y) * clusterGrid.x + clusterCoord.x);
+    for(uint i = 0u; i < cluster.y; ++i)
+    {
+        int light = int(texelFetch(clusterLightIndices, int(cluster.x + i)).r);
+        Lo += shadePointLight(light, FragPos, N, V, albedo, metallic, roughness, F0);
+    }
+    for(uint i = 0u; i < cluster.z; ++i)
+    {
+        int light = int(texelFetch(clusterLightIndices, int(cluster.x + cluster.y + i)).r);
+        Lo += shadeSpotLight(light, FragPos, N, V, albedo, metallic, roughness, F0);
+    }
+#else
     // Point lights
-    for(int i = 0; i < numLights; ++i) 
+    for(int i = 0; i < pointLightCount; ++i) 
     {
-        vec3 L = normalize(lightPositions[i] - FragPos);
-        float distance = length(lightPositions[i] - FragPos);
-        float attenuation = 1.0 / (distance * distance);
-        vec3 radiance = lightColors[i] * attenuation;
-        
-        Lo += calculatePBRContribution(L, radiance, N, V, albedo, metallic, roughness, F0);
+        Lo += shadePointLight(i, FragPos, N, V, albedo, metallic, roughness, F0);
     }
     
     // Spotlights
-    for(int i = 0; i < numSpotLights; ++i) 
+    for(int i = 0; i < spotLightCount; ++i) 
     {
-        vec3 L = normalize(spotLightPositions[i] - FragPos);
-        float distance = length(spotLightPositions[i] - FragPos);
-        float attenuation = 1.0 / (distance * distance);
-        
-        // Calculate spotlight intensity based on angle
-        float theta = dot(-L, spotLightDirections[i]);
-        float epsilon = spotLightInnerCutoffs[i] - spotLightOuterCutoffs[i];
-        float intensity = clamp((theta - spotLightOuterCutoffs[i]) / epsilon, 0.0, 1.0);
-        
-        vec3 radiance = spotLightColors[i] * attenuation * intensity;
-        
-        Lo += calculatePBRContribution(L, radiance, N, V, albedo, metallic, roughness, F0);
+        Lo += shadeSpotLight(i, FragPos, N, V, albedo, metallic, roughness, F0);
     }
+#endif
     
-    // Directional light
-    if (hasDirLight) {
-        vec3 L = normalize(-dirLightDirection); // Directional light points in the opposite direction
-        vec3 radiance = dirLightColor; // No attenuation for directional lights
+    // Directional lights
+#ifdef DIR_LIGHT
+    for(int i = 0; i < dirLightCount; ++i)
+    {
+        vec3 L = normalize(-texelFetch(dirLights, i).xyz); // Directional light points in the opposite direction
+        vec3 radiance = texelFetch(dirLights, dirLightStride + i).rgb; // No attenuation for directional lights
+#ifdef SHADOWS
+        if (i == 0) {
+            radiance *= directionalShadow(FragPos, N);  // Only the first has cascades
+        }
+#endif
         
         Lo += calculatePBRContribution(L, radiance, N, V, albedo, metallic, roughness, F0);
     }
+#endif
     
+#ifdef VOLUME_PASS
+    // Ambient is added once, by the full-screen pass
+    vec3 color = Lo;
+#else
     // Ambient lighting (note that in PBR we typically use an HDR environment map)
     vec3 ambient = vec3(0.03) * albedo * ao;
     
     vec3 color = ambient + Lo;
+#endif
 
+#ifdef LINEAR_OUTPUT
+    // Added up by blending; tonemapped once all lights are in
+    FragColor = vec4(color, 1.0);
+#else
     // HDR tonemapping
     color = color / (color + vec3(1.0));
     // Gamma correction
     color = pow(color, vec3(1.0/2.2)); 
 
-    vec3 result = vec3(0.0);
-
-    // Loop through all point lights
-    for (int i = 0; i < numLights; i++) {
-        vec3 lightVector = lightPositions[i] - FragPos;
-        float distance = length(lightVector);
-        
-        // Calculate attenuation using the light's parameters
-        float attenuation = 1.0;
-        
-        
-        // Calculate the direction from fragment to light
-        vec3 lightDir = normalize(lightVector);
-        
-        // Calculate diffuse lighting
-        float diff = max(dot(N, lightDir), 0.0);
-        vec3 diffuse = vec3(0.0);
-        
-        // Calculate ambient lighting
-        vec3 ambient = 0.1 * lightColors[i];
-        
-        // Calculate Blinn-Phong specular lighting
-        vec3 viewDir = normalize(viewPos - FragPos);
-        vec3 halfwayDir = normalize(lightDir + viewDir);
-        float spec = pow(max(dot(N, halfwayDir), 0.0), 32);
-        
-        // Get specular intensity - either from texture or default value
-        float specularIntensity;
-        specularIntensity = 0.5; // Default specular intensity for vertex-colored objects
-
-        vec3 specular = spec * specularIntensity * lightColors[i];
-        
-        // Add this light's contribution (only lighting, no base color)
-        result += (ambient + diffuse + specular) * attenuation;
-    }
-
     FragColor = vec4(color, 1.0);
+#endif
 }
\ No newline at end of file
@@ -26,7 +26,8 @@ void main() {
     vec3 N = normalize(Normal);
     if (texture(normal0, TexCoord).a > 0.1) {
         // Use the TBN matrix from vertex shader for normal mapping
-        N = normalize(TBN * (texture(normal0, TexCoord).rgb * 2.0 - 1.0));
+        vec2 xy = texture(normal0, TexCoord).rg * 2.0 - 1.0;
+        N = normalize(TBN * vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0))));
     }
     gNormal = vec4(N, 1.0);
     
@@ -1,9 +1,9 @@
 #version 410 core
-layout (location = 0) in vec3 aPos;
+layout (location = 0) in vec4 aPos;  // w: tangent handedness (packed vertices only)
 layout (location = 1) in vec3 aColor;
 layout (location = 2) in vec2 aTexCoord;
-layout (location = 3) in vec3 aNormal;
-layout (location = 4) in vec3 aTangent;
+layout (location = 3) in vec3 aNormal;  // Octahedral xy when packed
+layout (location = 4) in vec3 aTangent;  // Octahedral xy when packed
 layout (location = 5) in vec3 aBitangent;
 
 out vec3 FragPos;
@@ -15,16 +15,41 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Packed (quantized) vertices: position = positionOffset + aPos.xyz * positionScale
+uniform bool packedVertices;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (n.z < 0.0) {
+        vec2 signs = vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(e.yx)) * signs;
+    }
+    return normalize(n);
+}
+
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    vec3 position = aPos.xyz;
+    vec3 normal = aNormal;
+    vec3 tangent = aTangent;
+    vec3 bitangent = aBitangent;
+    if (packedVertices) {
+        position = positionOffset + aPos.xyz * positionScale;
+        normal = octDecode(aNormal.xy);
+        tangent = octDecode(aTangent.xy);
+        bitangent = cross(normal, tangent) * (aPos.w * 2.0 - 1.0);
+    }
+
+    FragPos = vec3(model * vec4(position, 1.0));
     mat3 normalMatrix = mat3(transpose(inverse(model)));
-    vec3 T = normalize(normalMatrix * aTangent);
-    vec3 B = normalize(normalMatrix * aBitangent);
-    vec3 N = normalize(normalMatrix * aNormal);
+    vec3 T = normalize(normalMatrix * tangent);
+    vec3 B = normalize(normalMatrix * bitangent);
+    vec3 N = normalize(normalMatrix * normal);
     TBN = mat3(T, B, N);
     Normal = N; // Pass the normal to fragment shader
 
     TexCoord = aTexCoord;
-    
+
     gl_Position = projection * view * vec4(FragPos, 1.0);
-}
\ No newline at end of file
+}
@@ -1,5 +1,18 @@
 #version 410 core
 
+// Variant switches (see ShaderPermutations): NORMAL_MAP, ORM_MAP, MATERIAL_ARRAY, QUALITY
+#define QUALITY_LOW 0
+#define QUALITY_MEDIUM 1
+#define QUALITY_HIGH 2
+#ifndef QUALITY
+#define QUALITY QUALITY_HIGH
+#endif
+
+// Low quality skips normal mapping
+#if defined(NORMAL_MAP) && QUALITY > QUALITY_LOW
+#define USE_NORMAL_MAP
+#endif
+
 // Inputs from vertex shader
 in vec3 FragPos;
 in vec3 Normal;
@@ -14,35 +27,72 @@ layout (location = 3) out vec4 gMetallicRoughness;
 layout (location = 4) out vec4 gAO;
 
 // Texture samplers - using the names that Mesh class sets
+#ifdef MATERIAL_ARRAY
+// Pooled materials (MaterialPool): this draw's maps are one layer of each array
+uniform sampler2DArray albedoArray;
+uniform sampler2DArray normalArray;
+uniform sampler2DArray ormArray; // Packed: R = AO, G = roughness, B = metallic
+uniform int materialLayer;
+#else
 uniform sampler2D albedoMap;
 uniform sampler2D normalMap;
+#ifdef ORM_MAP
+uniform sampler2D ormMap; // Packed: R = AO, G = roughness, B = metallic
+#else
 uniform sampler2D metallicMap;
 uniform sampler2D roughnessMap;
 uniform sampler2D aoMap;
+#endif
+#endif
 
-vec3 getNormalFromMap()
+vec3 getNormalFromMap(vec2 encoded)
 {
-    vec3 tangentNormal = texture(normalMap, TexCoord).xyz * 2.0 - 1.0;
+    // Only XY are needed (baked normal maps are two-channel BC5); Z points out of the surface
+    vec2 xy = encoded * 2.0 - 1.0;
+    vec3 tangentNormal = vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
     return normalize(TBN * tangentNormal);
 }
 
 void main() {
     // Output 1: World position
     gPosition = vec4(FragPos, 1.0);
-    gAlbedo = vec4(pow(texture(albedoMap, TexCoord).rgb, vec3(2.2)), 1.0); // Gamma correction
 
+#ifdef MATERIAL_ARRAY
+    vec3 layerCoord = vec3(TexCoord, float(materialLayer));
+    gAlbedo = vec4(texture(albedoArray, layerCoord).rgb, 1.0); // sRGB texture: already linear
+    vec3 orm = texture(ormArray, layerCoord).rgb;
+    float ao = orm.r;
+    float roughness = orm.g;
+    float metallic = orm.b;
+
+#ifdef USE_NORMAL_MAP
+    // Unloaded pool layers hold a flat normal
+    vec3 N = getNormalFromMap(texture(normalArray, layerCoord).rg);
+#else
+    vec3 N = normalize(Normal);
+#endif
+#else
+    gAlbedo = vec4(texture(albedoMap, TexCoord).rgb, 1.0); // sRGB texture: already linear
+
+#ifdef ORM_MAP
+    vec3 orm = texture(ormMap, TexCoord).rgb;
+    float ao = orm.r;
+    float roughness = orm.g;
+    float metallic = orm.b;
+#else
     float ao = texture(aoMap, TexCoord).r;
+    float metallic = texture(metallicMap, TexCoord).r;
+    float roughness = texture(roughnessMap, TexCoord).r;
+#endif
     
     // Output 2: World normal (with normal mapping)
-    vec3 N;
-    if (textureSize(normalMap, 0).x > 1) {
-        N = getNormalFromMap();
-    } else {
-        N = normalize(Normal);
-    }
+#ifdef USE_NORMAL_MAP
+    vec3 N = getNormalFromMap(texture(normalMap, TexCoord).rg);
+#else
+    vec3 N = normalize(Normal);
+#endif
+#endif
     gNormal = vec4(N, 0.0);
-    float metallic = texture(metallicMap, TexCoord).r;
-    float roughness = texture(roughnessMap, TexCoord).r;
     gMetallicRoughness = vec4(metallic, roughness, 0.0, 1.0);
     gAO = vec4(ao, ao, ao, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#version 410 core
+
+// Variant switches (see ShaderPermutations): POINT_VOLUME draws a sphere around each point light,
+// SPOT_VOLUME a cone along each spotlight, or a sphere around it when its cone is wider than 45 degrees; one
+// instance per light slot of the LightManager buffers
+layout (location = 0) in vec3 aPos;  // Unit sphere, or cone with its apex at the origin and a unit base at z = 1
+
+flat out int LightIndex;
+
+uniform mat4 view;
+uniform mat4 projection;
+
+// Light buffers (see LightManager and deferred_lighting_PBR.frag)
+uniform samplerBuffer pointLights;
+uniform samplerBuffer spotLights;
+uniform int spotLightStride;
+uniform bool spotSpheres;  // Spotlights are drawn with the sphere mesh: this draw is for the wide ones
+
+void main() {
+    LightIndex = gl_InstanceID;
+
+#ifdef SPOT_VOLUME
+    vec4 positionRadius = texelFetch(spotLights, gl_InstanceID);
+    vec4 directionOuter = texelFetch(spotLights, spotLightStride + gl_InstanceID);
+
+    // Wide spots are bounded by the sphere of their influence radius, like a point light: a cone that wide
+    // would be larger, and past 90 degrees not bound the light at all. Each spot collapses its instance in the
+    // draw of the mesh it doesn't use
+    float cosOuter = directionOuter.w;
+    bool wide = cosOuter < 0.70710678;
+    if (wide != spotSpheres) {
+        gl_Position = vec4(0.0, 0.0, 0.0, 1.0);
+        return;
+    }
+    vec3 worldPos = positionRadius.xyz + aPos * positionRadius.w;
+    if (!wide) {
+        // Long enough for the influence radius and as wide as the outer cone
+        float tanOuter = sqrt(1.0 - cosOuter * cosOuter) / cosOuter;
+        vec3 forward = normalize(directionOuter.xyz);
+        vec3 up = abs(forward.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0);
+        vec3 right = normalize(cross(up, forward));
+        up = cross(forward, right);
+        vec3 local = vec3(aPos.xy * tanOuter, aPos.z) * positionRadius.w;
+        worldPos = positionRadius.xyz + right * local.x + up * local.y + forward * local.z;
+    }
+#else
+    vec4 positionRadius = texelFetch(pointLights, gl_InstanceID);
+    vec3 worldPos = positionRadius.xyz + aPos * positionRadius.w;
+#endif
+
+    gl_Position = projection * view * vec4(worldPos, 1.0);
+}
@@ -0,0 +1,6 @@
+#version 410 core
+
+// Stencil pass of the light volumes (see DeferredRenderer::renderLightVolumes): only the depth test's
+// outcome is used, so there is nothing to shade
+void main() {
+}
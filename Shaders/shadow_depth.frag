@@ -0,0 +1,5 @@
+#version 410 core
+
+// Shadow map tiles (see ShadowAtlas): only depth is written
+void main() {
+}
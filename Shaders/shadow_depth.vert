@@ -0,0 +1,15 @@
+#version 410 core
+layout (location = 0) in vec4 aPos;  // w: tangent handedness (packed vertices only)
+
+uniform mat4 model;
+uniform mat4 lightViewProjection;
+
+// Packed (quantized) vertices: position = positionOffset + aPos.xyz * positionScale
+uniform bool packedVertices;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+void main() {
+    vec3 position = packedVertices ? positionOffset + aPos.xyz * positionScale : aPos.xyz;
+    gl_Position = lightViewProjection * model * vec4(position, 1.0);
+}
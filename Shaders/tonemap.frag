@@ -0,0 +1,23 @@
+#version 410 core
+
+// Resolve of the light-volume path: tonemaps the summed linear light to the screen
+in vec2 TexCoord;
+
+out vec4 FragColor;
+
+uniform sampler2D lightAccumulation;
+
+void main() {
+    // Alpha stays zero where no geometry was lit; the screen keeps its clear color there
+    vec4 light = texture(lightAccumulation, TexCoord);
+    if (light.a == 0.0) {
+        discard;
+    }
+
+    // HDR tonemapping
+    vec3 color = light.rgb / (light.rgb + vec3(1.0));
+    // Gamma correction
+    color = pow(color, vec3(1.0/2.2));
+
+    FragColor = vec4(color, 1.0);
+}
@@ -11,11 +11,7 @@ public:
 
     // Getters and setters for direction
     glm::vec3 getDirection() const { return direction; }
-    void setDirection(const glm::vec3& dir) { direction = glm::normalize(dir); }
-
-    // Override virtual methods
-    void updateShaderUniforms(class Shader& shader, int lightIndex) const override;
-    std::string getLightType() const override { return "DirectionalLight"; }
+    void setDirection(const glm::vec3& dir) { direction = glm::normalize(dir); changed(); }
 
     // Directional light specific methods
     glm::vec3 getNormalizedDirection() const { return glm::normalize(direction); }
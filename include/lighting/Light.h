@@ -2,6 +2,14 @@
 #include <glm/glm.hpp>
 #include <string>
 
+class LightManager;
+
+enum class LightType {
+    Point,
+    Spot,
+    Directional
+};
+
 class Light {
 protected:
     glm::vec3 position;
@@ -10,9 +18,17 @@ protected:
     std::string name;
     bool isActive;
 
+    // Pass a change to the shading data on to the manager, if the light has been added to one
+    void changed();
+
 public:
-    Light(const glm::vec3& pos, const glm::vec3& col, float intens = 1.0f, const std::string& lightName = "Light");
-    virtual ~Light() = default;
+    Light(LightType lightType, const glm::vec3& pos, const glm::vec3& col, float intens = 1.0f,
+          const std::string& lightName = "Light");
+    virtual ~Light();
+
+    // A light belongs to at most one manager, which keeps its slot
+    Light(const Light&) = delete;
+    Light& operator=(const Light&) = delete;
 
     // Getters
     glm::vec3 getPosition() const { return position; }
@@ -20,18 +36,24 @@ public:
     float getIntensity() const { return intensity; }
     std::string getName() const { return name; }
     bool getIsActive() const { return isActive; }
+    LightType getType() const { return type; }
 
     // Setters
-    void setPosition(const glm::vec3& pos) { position = pos; }
-    void setColor(const glm::vec3& col) { color = col; }
-    void setIntensity(float intens) { intensity = intens; }
+    void setPosition(const glm::vec3& pos) { position = pos; changed(); }
+    void setColor(const glm::vec3& col) { color = col; changed(); }
+    void setIntensity(float intens) { intensity = intens; changed(); }
     void setName(const std::string& lightName) { name = lightName; }
-    void setIsActive(bool active) { isActive = active; }
+    void setIsActive(bool active) { isActive = active; changed(); }
 
-    // Virtual methods that derived classes must implement
-    virtual void updateShaderUniforms(class Shader& shader, int lightIndex) const = 0;
-    virtual std::string getLightType() const = 0;
+    std::string getLightType() const;
     
     // Common utility methods
     glm::vec3 getEffectiveColor() const { return color * intensity; }
-}; 
\ No newline at end of file
+
+private:
+    friend class LightManager;
+
+    LightType type;
+    LightManager* manager = nullptr;
+    int slot = -1;  // Index in the manager's arrays for the type
+};
@@ -0,0 +1,89 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class LightManager;
+class Shader;
+
+// Counters of the last build
+struct LightClusterStats {
+    int clusters = 0;
+    size_t lightIndices = 0;     // Sum over clusters of the lights assigned to them
+    int maxClusterLights = 0;    // Most lights any one cluster got
+    double buildMs = 0.0;        // CPU assignment and upload
+};
+
+// Clustered light assignment: the view frustum is split into a grid of froxels (screen tiles by exponential
+// depth slices) and each point and spot light is listed in the clusters its influence sphere overlaps, so
+// the lighting shader only loops over the lights of its pixel's cluster. The lists are rebuilt on worker
+// threads every frame and uploaded as two texture buffers: a table of (first index, point light count,
+// spotlight count) per cluster and the light indices themselves (see deferred_lighting_PBR.frag)
+class LightClusters {
+public:
+    explicit LightClusters(int tilesX = 16, int tilesY = 9, int slices = 24);
+
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    // Assign the manager's lights for this view and upload the lists. projection must be a symmetric
+    // perspective projection with the given near and far planes
+    void build(const LightManager& lights, const glm::mat4& view, const glm::mat4& projection, float nearPlane,
+               float farPlane, int viewportWidth, int viewportHeight);
+
+    // Bind the cluster table and index buffers to firstUnit and the unit after it, and set the shader's
+    // cluster uniforms. The shader must be in use
+    void bind(const Shader& shader, int firstUnit) const;
+
+    const LightClusterStats& getStats() const { return stats; }
+
+    // Release the buffers (needs the GL context)
+    void destroy();
+
+private:
+    // A light's influence sphere in view space and the depth slices it overlaps, [z0, z1); empty when it's out
+    // of view
+    struct ClusterRange {
+        glm::vec3 center{0.0f};
+        float radius = 0.0f;
+        int z0 = 0, z1 = 0;
+    };
+
+    // Tiles a sphere's part within one depth slice covers, [x0, x1) by [y0, y1)
+    struct TileRect {
+        int x0 = 0, x1 = 0;
+        int y0 = 0, y1 = 0;
+    };
+
+    glm::ivec3 grid;
+    glm::mat4 view{1.0f};
+    glm::vec2 projectionScale{1.0f};  // projection[0][0] and [1][1]
+    glm::vec2 tileSize{1.0f};
+    float sliceScale = 0.0f;
+    float sliceBias = 0.0f;
+    std::vector<float> sliceDepths;   // View depth where each slice starts, and where the last one ends
+
+    std::vector<ClusterRange> pointRanges;
+    std::vector<ClusterRange> spotRanges;
+    std::vector<glm::uvec4> table;    // Per cluster: first index, point lights, spotlights, unused
+    std::vector<uint32_t> indices;
+
+    GLuint tableBuffer = 0;
+    GLuint tableTexture = 0;
+    GLuint indexBuffer = 0;
+    GLuint indexTexture = 0;
+
+    LightClusterStats stats;
+
+    int clusterIndex(int x, int y, int z) const { return (z * grid.y + y) * grid.x + x; }
+
+    // Overlapped slices of the first count spheres (center and radius in w, world space)
+    void computeRanges(const std::vector<glm::vec4>& bounds, size_t count, std::vector<ClusterRange>& ranges,
+                       unsigned threadCount) const;
+
+    // Screen tiles of a sphere's slab between the slice's depths; false if it's off screen
+    bool tilesInSlice(const ClusterRange& range, int slice, TileRect& rect) const;
+
+    void upload();
+};
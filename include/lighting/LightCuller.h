@@ -0,0 +1,57 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include "lighting/Light.h"
+
+class Frustum;
+class LightManager;
+
+// Counters of the last cull, over point and spot lights
+struct LightCullStats {
+    int considered = 0;
+    int frustumCulled = 0;  // Influence doesn't reach the view (or the light is off)
+    int budgetDropped = 0;  // In view but outside the budget; fading out or gone
+    int fading = 0;         // Shaded at part strength, fading in or out
+    int shaded = 0;
+    double cullMs = 0.0;
+};
+
+// Chooses the point and spot lights to shade each frame. Lights whose influence sphere (or the sphere around
+// a spotlight's cone) is outside the view frustum can't light anything on screen and are dropped at once.
+// The rest are ranked by an estimate of their contribution, brightness times the fraction of the screen
+// their influence covers, and only the top `budget` are kept. Lights entering or leaving the budget fade
+// over fadeSeconds instead of popping, and kept lights rank a little higher (hysteresis) so lights near the
+// cut don't flicker. The result goes to the LightManager as per-light fades
+class LightCuller {
+public:
+    explicit LightCuller(int budget = 256, float fadeSeconds = 0.25f, float hysteresis = 0.15f);
+
+    void setBudget(int lights) { budget = lights; }
+    int getBudget() const { return budget; }
+
+    // Disabled, every light is shaded at full strength
+    void setEnabled(bool enable) { enabled = enable; }
+
+    // Update the manager's fades for this frame's view. fovY is in radians
+    void cull(LightManager& lights, const Frustum& frustum, const glm::vec3& cameraPosition, float fovY,
+              float viewportHeight, float deltaTime);
+
+    const LightCullStats& getStats() const { return stats; }
+
+private:
+    struct Candidate {
+        LightType type;
+        int slot;
+        float importance;
+    };
+
+    int budget;
+    float fadeSeconds;
+    float hysteresis;
+    bool enabled = true;
+
+    std::vector<Candidate> candidates;
+    std::vector<float> targets[2];  // Fade each point / spot light slot is heading for
+    std::vector<float> fades[2];
+    LightCullStats stats;
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <vector>
+#include "lighting/Light.h"
+
+class Shader;
+
+// Upload counters
+struct LightManagerStats {
+    size_t lights = 0;
+    size_t bytesUploaded = 0;  // By the last upload()
+    size_t lightsUploaded = 0; // Slots covered by the last upload's changed ranges
+};
+
+// Shading data of every added light in structure-of-arrays form, one array per attribute and light type, and
+// a copy of it in texture buffers for the lighting shader (see the layout in deferred_lighting_PBR.frag).
+// Lights report their own changes through their setters, and upload() sends only the range of slots that
+// changed since the last one. There is no cap on the number of lights: the buffers grow as lights are added.
+// Each light also has a fade (see setFades) that scales its color, and only the slots at the front whose fade
+// isn't zero are shaded
+class LightManager {
+public:
+    LightManager();
+    ~LightManager();
+
+    LightManager(const LightManager&) = delete;
+    LightManager& operator=(const LightManager&) = delete;
+
+    // Start tracking a light; it's removed again when destroyed. Lights stay owned by the caller
+    void add(Light& light);
+    void remove(Light& light);
+
+    // Copy a light's current values into its slot (called by the light's setters)
+    void update(const Light& light);
+
+    int getPointLightCount() const { return lights[(int)LightType::Point].count(); }
+    int getSpotLightCount() const { return lights[(int)LightType::Spot].count(); }
+    int getDirectionalLightCount() const { return lights[(int)LightType::Directional].count(); }
+
+    // Lights of a type the shaders loop over: slots [0, count) all have a fade above zero
+    int getShadedCount(LightType type) const { return lights[(int)type].shaded; }
+
+    // Light in a slot, and its fade
+    const Light& getLight(LightType type, int slot) const { return *lights[(int)type].owners[slot]; }
+    float getFade(LightType type, int slot) const { return lights[(int)type].fades[slot]; }
+
+    // Give each slot of a type a new fade in [0, 1] (fades[i] for slot i), then move the lights faded to zero
+    // behind the rest so they're no longer shaded. Lights keep their fade until it's set again; new ones
+    // start at 1
+    void setFades(LightType type, const std::vector<float>& fades);
+
+    // Bounding sphere of each point or spot light by slot: position, and influence radius in w (see
+    // influenceRadius). The radius ignores the light's fade
+    const std::vector<glm::vec4>& getBounds(LightType type) const { return lights[(int)type].streams[0]; }
+
+    // Color a light is shaded with, before its fade: its color as set, or black while it's inactive. Intensity
+    // isn't applied, as with the renderer's original lights. Radii and culling importance use this too
+    static glm::vec3 shadedColor(const Light& light);
+
+    // Distance at which a light of this color, shaded with inverse-square falloff, falls below 5/256, where 8-bit
+    // output can't show it; the shader fades lights out up to there
+    static float influenceRadius(const glm::vec3& color);
+
+    // Send the changed ranges to the GPU, reallocating the buffers first if they've outgrown them. Call once per
+    // frame before binding
+    void upload();
+
+    // Bind the point, spot and directional light buffers to firstUnit and the two units after it, and set the
+    // shader's light uniforms (counting only the shaded lights). The shader must be in use
+    void bind(const Shader& shader, int firstUnit) const;
+
+    const LightManagerStats& getStats() const { return stats; }
+
+    // Release the buffers (needs the GL context)
+    void destroy();
+
+private:
+    // The lights of one type: an array per attribute (a "stream") of one vec4 per light, and their GPU copy
+    // with the streams one after another, `capacity` texels apart
+    struct LightArrays {
+        int streamCount = 0;
+        std::vector<glm::vec4> streams[3];
+        std::vector<Light*> owners;  // Light in each slot
+        std::vector<float> fades;    // Scale of each slot's color
+        int shaded = 0;              // Slots at the front with a fade above zero
+        int dirtyBegin = 0;          // Slots changed since the last upload
+        int dirtyEnd = 0;
+
+        GLuint buffer = 0;
+        GLuint texture = 0;
+        int capacity = 0;
+
+        int count() const { return (int)owners.size(); }
+        void markDirty(int slot);
+    };
+
+    LightArrays lights[3];  // By LightType
+    LightManagerStats stats;
+
+    // Fill a slot's streams from its light
+    static void write(LightArrays& arrays, int slot);
+
+    // Exchange two slots' lights
+    static void swapSlots(LightArrays& arrays, int a, int b);
+};
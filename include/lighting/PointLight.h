@@ -18,13 +18,9 @@ public:
     float getQuadratic() const { return quadratic; }
 
     // Setters for attenuation parameters
-    void setConstant(float c) { constant = c; }
-    void setLinear(float l) { linear = l; }
-    void setQuadratic(float q) { quadratic = q; }
-
-    // Override virtual methods
-    void updateShaderUniforms(class Shader& shader, int lightIndex) const override;
-    std::string getLightType() const override { return "PointLight"; }
+    void setConstant(float c) { constant = c; changed(); }
+    void setLinear(float l) { linear = l; changed(); }
+    void setQuadratic(float q) { quadratic = q; changed(); }
 
     // Point light specific methods
     float calculateAttenuation(float distance) const;
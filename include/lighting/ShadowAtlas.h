@@ -0,0 +1,154 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "utils/FrustumCulling.h"
+
+class Light;
+class LightManager;
+class Mesh;
+class Shader;
+
+// A mesh instance drawn into the shadow maps
+struct ShadowCaster {
+    Mesh* mesh = nullptr;
+    glm::mat4 model{1.0f};
+};
+
+// Counters of the last update
+struct ShadowAtlasStats {
+    int cascades = 0;        // Directional cascades with a map
+    int spotShadows = 0;     // Spotlights shadowed this frame
+    int cachedTiles = 0;     // Tiles in the atlas, including spotlights kept for when they come back
+    int tilesRendered = 0;   // Re-rendered this frame
+    int tilesStale = 0;      // Out of date but over the update budget; shaded with their last map
+    int castersDrawn = 0;    // Over the tiles rendered this frame
+    int castersCulled = 0;   // Outside the frustum of the light they were tested against
+    double updateMs = 0.0;   // CPU side of the update, draw submission included
+};
+
+// Shadow maps of the first directional light and the most important spotlights, packed as tiles into one
+// depth texture. The directional light gets cascades: the first shadowDistance units of the view are split
+// into slices, each covered by an orthographic map fitted with some slack around the slice's bounding sphere
+// and kept until the slice leaves it. Each spotlight the lighting shades gets a perspective tile sized by how
+// much of the screen its light covers, and the most important ones are shadowed. A tile is only re-rendered
+// when its light moved, its cascade no longer covers its slice, or a caster changed inside its frustum, so
+// static casters stay cached. At most `updateBudget` tiles render per frame, the most important first; the
+// others keep their last map, which stays correct for the matrix it was rendered with. Each tile's casters
+// are culled on the CPU against its light's frustum
+class ShadowAtlas {
+public:
+    static constexpr int maxCascades = 4;     // MAX_CASCADES in deferred_lighting_PBR.frag
+    static constexpr int maxSpotShadows = 8;  // Spotlights shadowed per frame
+
+    explicit ShadowAtlas(int size = 4096, int cascadeCount = 3, float shadowDistance = 20.0f, int updateBudget = 2);
+    ~ShadowAtlas();
+
+    ShadowAtlas(const ShadowAtlas&) = delete;
+    ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+    // Create the depth texture and its framebuffer
+    bool initialize();
+
+    // Tiles re-rendered per frame at most
+    void setUpdateBudget(int tiles) { updateBudget = tiles; }
+    int getUpdateBudget() const { return updateBudget; }
+
+    // The scene's casters, compared with the last call: tiles whose light frustum holds a caster that moved,
+    // appeared or went away (where it was and where it is) are re-rendered. Unchanged casters cost nothing
+    void setCasters(const std::vector<ShadowCaster>& casters);
+
+    // Choose and place this frame's shadow tiles and render the ones due within the budget. Call after the
+    // light culling (only shaded spotlights get shadows). fovY is in radians; depthShader is
+    // shadow_depth.vert/.frag. Leaves the framebuffer and viewport as it found them
+    void update(const LightManager& lights, Shader& depthShader, const glm::mat4& view, float fovY, float aspect,
+                float nearPlane, float viewportHeight);
+
+    // Bind the atlas to firstUnit and the spot shadow table (a texture buffer indexed by spotlight slot) to the
+    // unit after it, and set the shader's shadow uniforms for the maps rendered so far. The shader must be in use
+    void bind(const Shader& shader, int firstUnit) const;
+
+    const ShadowAtlasStats& getStats() const { return stats; }
+
+    // Release the texture and framebuffer (needs the GL context)
+    void destroy();
+
+private:
+    // A square of the atlas and the map in it
+    struct Tile {
+        int x = 0, y = 0, size = 0;       // In texels; size 0 while it has no place
+        glm::mat4 viewProjection{1.0f};   // The map was rendered with
+        Frustum casterFrustum;            // Where casters can shadow the map
+        bool rendered = false;
+        bool dirty = true;
+        int staleFrames = 0;              // Frames it has waited for an update
+        float importance = 0.0f;
+    };
+
+    struct Cascade {
+        Tile tile;
+        glm::vec3 direction{0.0f};        // Light direction the map was rendered for
+        glm::vec3 center{0.0f};           // Sphere the map covers
+        float radius = 0.0f;
+        glm::vec3 sliceCenter{0.0f};      // Bounding sphere of this frame's slice
+        float sliceRadius = 0.0f;
+        float texelSize = 0.0f;           // World units
+    };
+
+    struct SpotShadow {
+        const Light* light = nullptr;     // Only compared, never dereferenced
+        int slot = 0;                     // This frame's LightManager slot
+        Tile tile;
+        glm::mat4 viewProjection{1.0f};   // Of the light this frame
+        float tanHalfAngle = 0.0f;        // Of the shadowed cone this frame
+        float texelSize = 0.0f;           // Of the rendered map, in world units per unit of distance
+        uint64_t lastUsed = 0;            // Frame it was last shadowed
+    };
+
+    // Caster and its world bounds
+    struct CachedCaster {
+        ShadowCaster caster;
+        BoundingBox bounds;
+    };
+
+    int size;
+    int cascadeCount;
+    float shadowDistance;
+    int updateBudget;
+    int cellsAcross;                  // Allocation grid of the smallest tiles
+    std::vector<uint8_t> cells;       // Taken cells, row by row
+
+    std::vector<CachedCaster> casters;
+    std::vector<BoundingBox> changedBounds;  // Since the last update
+    std::vector<Cascade> cascades;
+    std::vector<SpotShadow> spotShadows;
+    bool directionalShadowed = false;
+    glm::vec3 sunDirection{0.0f};     // Of the shadowed directional light this frame
+    uint64_t frame = 0;
+
+    GLuint texture = 0;
+    GLuint framebuffer = 0;
+
+    // Per spotlight slot: its tile (offset and size in atlas units, texel size in w) and map matrix, or a zero
+    // tile when it has no map
+    std::vector<glm::vec4> spotShadowData;
+    GLuint spotShadowBuffer = 0;
+    GLuint spotShadowTexture = 0;
+
+    ShadowAtlasStats stats;
+
+    // Place a tile of the given size, or of the largest smaller one that fits; false if none does
+    bool allocate(Tile& tile, int tileSize);
+    void release(Tile& tile);
+
+    // Rewrite the spot shadow table for the first spotCount slots
+    void uploadSpotShadows(int spotCount);
+
+    // Fit a cascade to its slice and render it
+    void renderCascade(Cascade& cascade, Shader& depthShader);
+
+    // Render a tile's casters with viewProjection, testing them against casterViewProjection's frustum
+    void renderTile(Tile& tile, const glm::mat4& viewProjection, const glm::mat4& casterViewProjection,
+                    Shader& depthShader);
+};
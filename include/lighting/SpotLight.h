@@ -25,16 +25,12 @@ public:
     float getQuadratic() const { return quadratic; }
 
     // Setters
-    void setDirection(const glm::vec3& dir) { direction = glm::normalize(dir); }
-    void setInnerCutoff(float innerCut) { innerCutoff = innerCut; }
-    void setOuterCutoff(float outerCut) { outerCutoff = outerCut; }
-    void setConstant(float c) { constant = c; }
-    void setLinear(float l) { linear = l; }
-    void setQuadratic(float q) { quadratic = q; }
-
-    // Override virtual methods
-    void updateShaderUniforms(class Shader& shader, int lightIndex) const override;
-    std::string getLightType() const override { return "SpotLight"; }
+    void setDirection(const glm::vec3& dir) { direction = glm::normalize(dir); changed(); }
+    void setInnerCutoff(float innerCut) { innerCutoff = innerCut; changed(); }
+    void setOuterCutoff(float outerCut) { outerCutoff = outerCut; changed(); }
+    void setConstant(float c) { constant = c; changed(); }
+    void setLinear(float l) { linear = l; changed(); }
+    void setQuadratic(float q) { quadratic = q; changed(); }
 
     // Spotlight specific methods
     glm::vec3 getNormalizedDirection() const { return glm::normalize(direction); }
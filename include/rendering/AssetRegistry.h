@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+#include "rendering/Mesh.h"
+#include "rendering/Texture.h"
+#include "rendering/shader.h"
+#include "utils/Hash.h"
+
+class TextureLoader;
+
+// One live asset in a memory report
+struct AssetMemoryInfo {
+    std::string name;  // Source path(s)
+    const char* kind;  // "texture", "mesh" or "shader"
+    size_t gpuBytes;   // Approximate; 0 where unknown (shader programs)
+    long handles;      // Current number of users
+};
+
+// Lookup counters
+struct AssetRegistryStats {
+    size_t hits = 0;    // Requests served by an already loaded asset
+    size_t misses = 0;  // Requests that loaded something
+};
+
+// Central cache of GPU assets keyed by source path plus file content, so an identical file is loaded once
+// even under a different path, and an edited file isn't mistaken for its old self. Assets are handed out as
+// shared_ptr handles and the registry only keeps weak references: GL objects are released when the last
+// handle drops (which must happen while the GL context is alive)
+class AssetRegistry {
+public:
+    // Texture of the given type, streamed through loader when one is given (otherwise loaded synchronously)
+    std::shared_ptr<Texture> getTexture(const std::string& path, TextureType type, TextureLoader* loader = nullptr);
+
+    // ORM texture packed from three maps by the loader
+    std::shared_ptr<Texture> getORMTexture(const ORMSources& sources, TextureLoader& loader);
+
+    // Shader program built from a vertex/fragment pair, with the given variant defines
+    std::shared_ptr<Shader> getShader(const std::string& vertexPath, const std::string& fragmentPath,
+                                      const std::vector<std::string>& defines = {});
+
+    // Mesh built from sourcePath by create, on a miss. variantKey tells apart different builds of the same
+    // file (post-processing, vertex format, material)
+    template<typename MeshType>
+    std::shared_ptr<MeshType> getMesh(const std::string& sourcePath, uint64_t variantKey,
+                                      const std::function<std::shared_ptr<MeshType>()>& create) {
+        uint64_t key = hashCombine(hashCombine(fileKey(sourcePath), variantKey), typeid(MeshType).hash_code());
+        auto found = meshes.find(key);
+        if (found != meshes.end()) {
+            if (auto mesh = found->second.asset.lock()) {
+                ++stats.hits;
+                return std::static_pointer_cast<MeshType>(mesh);
+            }
+        }
+
+        ++stats.misses;
+        std::shared_ptr<MeshType> mesh = create();
+        meshes[key] = {sourcePath, mesh};
+        return mesh;
+    }
+
+    // Every asset that still has users, with its approximate GPU memory. Forgets released assets
+    std::vector<AssetMemoryInfo> getMemoryReport();
+
+    const AssetRegistryStats& getStats() const { return stats; }
+
+private:
+    template<typename T>
+    struct Entry {
+        std::string name;
+        std::weak_ptr<T> asset;
+    };
+
+    // Content fingerprint of a file, re-hashed only when its size or modification time changes
+    struct FileFingerprint {
+        uint64_t size = 0;
+        int64_t modifiedTime = 0;
+        uint64_t contentHash = 0;
+    };
+
+    std::unordered_map<uint64_t, Entry<Texture>> textures;
+    std::unordered_map<uint64_t, Entry<Shader>> shaders;
+    std::unordered_map<uint64_t, Entry<Mesh>> meshes;
+    std::unordered_map<std::string, FileFingerprint> fingerprints;
+    AssetRegistryStats stats;
+
+    // Hash of the file's contents (of its path when it can't be read, so failures still dedupe by path)
+    uint64_t fileKey(const std::string& path);
+};
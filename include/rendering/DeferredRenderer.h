@@ -5,6 +5,19 @@
 #include <vector>
 #include "rendering/shader.h"
 #include "rendering/PBRMesh.h"
+#include "rendering/MaterialPool.h"
+#include "rendering/ShaderPermutations.h"
+#include "lighting/LightManager.h"
+
+// Programs of the light-volume lighting path (see DeferredRenderer::renderLightVolumes)
+struct LightVolumeShaders {
+    Shader& fullScreen;    // Ambient and directional lights: a LIGHT_VOLUMES variant of the lighting shader
+    Shader& pointLights;   // POINT_VOLUME variant on light_volume.vert
+    Shader& spotLights;    // SPOT_VOLUME variant on light_volume.vert
+    Shader& pointStencil;  // The same volumes with light_volume_stencil.frag
+    Shader& spotStencil;
+    Shader& resolve;       // tonemap.frag on the screen quad
+};
 
 class DeferredRenderer {
     public:
@@ -14,14 +27,39 @@ class DeferredRenderer {
         bool initialize();
         void cleanup();
 
+        // lodLevels picks each mesh's level of detail (LOD 0 for meshes without an entry).
+        // A non-null meshletDraws entry replaces that mesh's draw with just the listed index ranges.
+        // Each material draws with the variant of geometryShaders for its features at the given quality.
+        // Pooled materials (with materialPool given) are drawn grouped by pool, so each pool's arrays are
+        // bound once and its materials' draws only change the layer index
         void renderGeometryPass(const std::vector<PBRMesh*>& meshes, 
                                const std::vector<glm::mat4>& modelMatrices,
-                               Shader& geometryShader, 
+                               ShaderPermutations& geometryShaders, 
                                const glm::mat4& viewMatrix, 
-                               const glm::mat4& projectionMatrix);
+                               const glm::mat4& projectionMatrix,
+                               const std::vector<int>& lodLevels = {},
+                               const std::vector<const MeshletDrawList*>& meshletDraws = {},
+                               const MaterialPool* materialPool = nullptr,
+                               ShaderQuality quality = ShaderQuality::High);
+
+        // Texture binds (material changes) in the last geometry pass
+        int getMaterialBindCount() const { return materialBindCount; }
 
         // Render lighting pass (calculate lighting using G-Buffer)
         void renderLightingPass(Shader& lightingShader, const glm::vec3& viewPos);
+
+        // Light-volume alternative to renderLightingPass: each point light is drawn as an instanced sphere and
+        // each spotlight as a cone (a sphere when wider than 45 degrees), so a light only costs the pixels it
+        // covers on screen. A stencil pass first counts, per pixel, the volumes its surface lies inside, and the
+        // lights then shade only where that count isn't zero, which skips the background and surfaces outside
+        // every volume. The count is shared by all volumes, so a light still shades the rest of its footprint
+        // where its surface is inside another light's volume; its attenuation is zero there.
+        // Ambient and directional light is the only full-screen pass.
+        // Everything is summed in a linear HDR buffer with additive blending and tonemapped to the screen at
+        // the end. lightBufferUnit is the first of LightManager::bind's three units
+        void renderLightVolumes(const LightVolumeShaders& shaders, const LightManager& lights, int lightBufferUnit,
+                                const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix,
+                                const glm::vec3& viewPos);
         
         // Debug G-Buffer contents
         void debugGBuffer();
@@ -34,6 +72,7 @@ class DeferredRenderer {
 
     private:
         int width, height;
+        int materialBindCount = 0;
         GLuint gBuffer;
         GLuint gPosition;
         GLuint gNormal;
@@ -43,7 +82,25 @@ class DeferredRenderer {
         GLuint depthBuffer;
         GLuint quadVAO;
         GLuint quadVBO;
+
+        // Light-volume path: its accumulation target (sharing the G-buffer's depth and stencil) and meshes
+        struct VolumeMesh {
+            GLuint vao = 0;
+            GLuint vbo = 0;
+            GLuint ebo = 0;
+            GLsizei indexCount = 0;
+        };
+        GLuint lightBuffer = 0;
+        GLuint lightAccumulation = 0;
+        VolumeMesh sphereVolume;
+        VolumeMesh coneVolume;
         
         // Create full-screen quad for lighting pass
         void createScreenQuad();
+
+        // Create the light accumulation target and the sphere and cone meshes
+        bool createLightVolumes();
+
+        // Bind the G-buffer textures to units 5-9 and point the shader's samplers at them
+        void bindGBufferTextures(Shader& shader);
 };
@@ -1,12 +1,13 @@
 #pragma once
 #include <glad/glad.h>
+#include <span>
 #include <vector>
 
 class EBO {
 public:
 	GLuint id;
 	EBO(GLuint* indices, GLsizeiptr size);
-	EBO(const std::vector<GLuint>& indices);
+	EBO(std::span<const GLuint> indices);
 
 	void bind();
 	void unbind();
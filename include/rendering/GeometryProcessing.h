@@ -0,0 +1,24 @@
+#pragma once
+#include <glad/glad.h>
+#include <span>
+#include "rendering/VBO.h"  // For Vertex struct
+
+// How calculateTangentsBitangents builds the tangent frame
+enum class TangentMode {
+    Fast,          // Average of normalized per-triangle tangents and bitangents (the renderer's original frames)
+    AngleWeighted  // Per-corner tangents projected onto the vertex normal and angle-weighted, then an orthonormal
+                   // frame with the bitangent rebuilt as sign * cross(normal, tangent). Close to MikkTSpace but
+                   // not compatible with it, since vertices can't be split in place; calculateTangentsMikkTSpace
+                   // (rendering/MikkTSpace.h) is the compatible version
+};
+
+// Smooth per-vertex normals from triangle geometry (area-weighted), written in place.
+// Vertices without any contributing triangle get +Y. Runs on threadCount threads (0 = all cores)
+void calculateNormalsFromGeometry(std::span<Vertex> vertices, std::span<const GLuint> indices,
+                                  unsigned threadCount = 0);
+
+// Per-vertex tangents and bitangents from texture coordinates, written in place. Normals must already be set.
+// Triangles with degenerate UVs are skipped; vertices left without a tangent get an arbitrary frame around
+// their normal. Runs on threadCount threads (0 = all cores)
+void calculateTangentsBitangents(std::span<Vertex> vertices, std::span<const GLuint> indices,
+                                 TangentMode mode = TangentMode::Fast, unsigned threadCount = 0);
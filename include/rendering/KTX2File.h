@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include "rendering/TextureCompression.h"
+
+// KTX 2.0 container for baked textures: a 2D, single-layer image with its mip chain, no supercompression.
+// Rows are stored bottom to top, the way GL expects them (recorded as KTXorientation "ru")
+
+// Write texture to path. Throws std::runtime_error if the file can't be written
+void writeKTX2(const std::string& path, const CompressedTexture& texture);
+
+// Read a file written by writeKTX2 (or any KTX2 file in a supported block format): levelCount levels from
+// firstLevel, or all of them from there when levelCount is 0. Throws std::runtime_error for missing,
+// truncated or unsupported files, and levels the file doesn't have
+CompressedTexture readKTX2(const std::string& path, uint32_t firstLevel = 0, uint32_t levelCount = 0);
+
+// Same checks as readKTX2, but only the format, size and level layout: data stays empty
+CompressedTexture readKTX2Header(const std::string& path);
@@ -0,0 +1,25 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+
+// Picks a level of detail for an instance from the projected size of its bounding sphere.
+// Thresholds get a hysteresis band so instances sitting near a threshold don't flicker between levels,
+// and instances smaller than cullPixels aren't drawn at all.
+class LODSelector {
+public:
+    // switchPixels[i]: projected diameter (in pixels) below which LOD i + 1 is used instead of LOD i
+    explicit LODSelector(std::vector<float> switchPixels = {240.0f, 120.0f, 48.0f},
+                         float cullPixels = 2.0f, float hysteresis = 0.15f);
+
+    // Projected diameter in pixels of a world-space sphere under a perspective projection
+    static float projectedDiameter(const glm::vec3& center, float radius, const glm::vec3& cameraPosition,
+                                   float fovY, float viewportHeight);
+
+    // LOD to draw, or -1 to cull. previousLOD is the instance's result from last frame (-1 if it wasn't drawn)
+    int select(float pixelDiameter, int previousLOD, int lodCount) const;
+
+private:
+    std::vector<float> switchPixels;
+    float cullPixels;
+    float hysteresis;
+};
@@ -0,0 +1,93 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "rendering/ORMPacking.h"
+#include "rendering/TextureCompression.h"
+
+class TextureLoader;
+struct TextureRequest;
+
+// Where a pooled material's maps live: one layer of a pool's texture arrays
+struct MaterialSlot {
+    int pool = -1;
+    int layer = -1;
+
+    bool isValid() const { return pool >= 0; }
+};
+
+// Texture arrays shared by materials. Materials whose albedo, normal and packed ORM maps have the same size
+// and storage formats get a layer of the same GL_TEXTURE_2D_ARRAY pool, so draws with different materials
+// only differ in a layer index and the textures are bound once for all of them. A pool holds a fixed
+// number of layers (GL 4.1 can't copy an array into a bigger one); when it's full another pool with the
+// same layout is opened. Layers show the placeholder colors until the loader has streamed the maps in
+class MaterialPool {
+public:
+    // Storage of one map: its size and mip chain, in a block-compressed format or 8-bit RGBA
+    struct MapLayout {
+        int width = 0;
+        int height = 0;
+        int levels = 0;
+        GLenum internalFormat = 0;
+        bool compressed = false;
+        BlockFormat blockFormat = BlockFormat::BC1;  // When compressed
+
+        bool operator==(const MapLayout& other) const = default;
+    };
+
+    explicit MaterialPool(int layersPerPool = 16);
+
+    MaterialPool(const MaterialPool&) = delete;
+    MaterialPool& operator=(const MaterialPool&) = delete;
+
+    // Give a material a layer and queue its maps on the loader. Returns an invalid slot when the maps can't
+    // be pooled (one is missing, the ORM maps can't be packed, or they differ in size or mip chain); the
+    // material then keeps separate textures
+    MaterialSlot add(const std::string& albedoPath, const std::string& normalPath, const ORMSources& orm,
+                     TextureLoader& loader);
+
+    // Free the slot's layer for another material
+    void release(const MaterialSlot& slot);
+
+    // Whether the slot's maps have all arrived (or failed to load, leaving the placeholders)
+    bool isReady(const MaterialSlot& slot) const;
+
+    // Bind a pool's albedo, normal and ORM arrays to firstUnit and the two units after it
+    void bind(int pool, GLenum firstUnit = GL_TEXTURE0) const;
+
+    int getPoolCount() const { return (int)pools.size(); }
+
+    // Layers in use across all pools
+    int getLayerCount() const;
+
+    // GPU memory of every pool's arrays, used or not, in bytes
+    size_t getGPUMemorySize() const;
+
+    // Release the arrays (needs the GL context)
+    void destroy();
+
+private:
+    struct Layer {
+        bool used = false;
+        std::shared_ptr<TextureRequest> requests[3];
+    };
+
+    // Albedo, normal and ORM arrays with the same number of layers
+    struct Pool {
+        MapLayout maps[3];
+        GLuint arrays[3] = {0, 0, 0};
+        std::vector<Layer> layers;
+        size_t gpuBytes = 0;
+    };
+
+    int layersPerPool;
+    std::vector<Pool> pools;
+
+    // Allocate every level of a new pool's arrays
+    void createPool(const MapLayout (&maps)[3]);
+
+    // Fill one map of a layer with the placeholder color for its type
+    void fillPlaceholder(const Pool& pool, int map, int layer) const;
+};
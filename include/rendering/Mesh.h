@@ -3,9 +3,15 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <memory>
+#include <span>
+#include <type_traits>
 #include "rendering/VBO.h"
 #include "rendering/EBO.h"
 #include "rendering/VAO.h"
+#include "rendering/MeshSimplifier.h"  // For MeshLOD
+#include "rendering/Meshlets.h"
+#include "rendering/VertexCompression.h"
+#include "rendering/VertexFormat.h"
 #include "rendering/Texture.h"
 #include "rendering/shader.h"
 #include "core/Camera.h"
@@ -14,16 +20,40 @@
 class Mesh {
 public:
     // Constructor that takes vertex and index data (no textures)
-    Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
+    Mesh(std::span<const Vertex> vertices, std::span<const GLuint> indices);
+    
+    // Constructor that takes vertex and index data with a precomputed bounding box (e.g. from a mesh cache).
+    // The GPU copy holds only the attributes of the given format (e.g. PackedVertexFormat{} for quantized vertices)
+    template<typename Format = LitVertexFormat>
+    Mesh(std::span<const Vertex> vertices, std::span<const GLuint> indices, const BoundingBox& bounds,
+         Format = {})
+        : vertexCount(static_cast<GLsizei>(vertices.size())),
+          indexCount(static_cast<GLsizei>(indices.size())),
+          layout(vertexLayout<Format>()),
+          boundingBox(bounds) {
+        if constexpr (std::is_same_v<Format, FullVertexFormat>) {
+            // Vertex already is this layout: upload without repacking
+            createBuffers(std::as_bytes(vertices), indices);
+        } else {
+            if constexpr (Format::quantized) {
+                quantization = VertexQuantization::fromBounds(bounds);
+            }
+            createBuffers(Format::encode(vertices, quantization), indices);
+        }
+    }
     
     // Constructor that takes vertex, index, and texture data
-    Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, const std::vector<Texture>& textures);
+    Mesh(std::span<const Vertex> vertices, std::span<const GLuint> indices,
+         const std::vector<std::shared_ptr<Texture>>& textures);
     
     // Destructor
     ~Mesh();
     
-    // Render the mesh
-    void draw(Shader& shader);
+    // Render the mesh at the given level of detail (clamped to the available levels)
+    void draw(Shader& shader, int lod = 0);
+    
+    // Render only the given index ranges (e.g. the meshlets that survived culling) in one multi-draw
+    void drawRanges(Shader& shader, const MeshletDrawList& ranges);
     
     // Render the mesh with texture type handling
     void Draw(Shader& shader);
@@ -41,12 +71,33 @@ public:
     // Getter for index count
     GLsizei getIndexCount() const { return indexCount; }
     
+    // How the vertices are stored on the GPU, and the resulting vertex buffer size in bytes
+    const VertexLayout& getVertexLayout() const { return layout; }
+    size_t getVertexBufferSize() const { return (size_t)vertexCount * layout.stride; }
+    
+    // GPU memory of the vertex and index buffers, in bytes
+    size_t getGPUMemorySize() const { return getVertexBufferSize() + (size_t)indexCount * sizeof(GLuint); }
+    
     // Getter for texture count
     size_t getTextureCount() const { return textures.size(); }
     
+    // Use index ranges of the shared index buffer as levels of detail. Without a chain the whole buffer is LOD 0
+    void setLODs(std::span<const MeshLOD> newLODs);
+    
+    // Level of detail ranges (always at least one)
+    int getLODCount() const { return (int)lods.size(); }
+    const MeshLOD& getLOD(int lod) const { return lods[lod]; }
+    
+    // Meshlets partitioning LOD 0, for per-meshlet culling (empty if the mesh wasn't split)
+    void setMeshlets(std::span<const Meshlet> newMeshlets) { meshlets.assign(newMeshlets.begin(), newMeshlets.end()); }
+    std::span<const Meshlet> getMeshlets() const { return meshlets; }
+    
     // Get the bounding box of this mesh
     BoundingBox getBoundingBox() const;
     
+    // Compute the bounding box of a set of vertices
+    static BoundingBox computeBoundingBox(std::span<const Vertex> vertices);
+    
     // Check if this mesh is visible in the frustum
     bool isVisibleInFrustum(const Frustum& frustum, const glm::mat4& modelMatrix) const;
 
@@ -54,14 +105,24 @@ private:
     std::unique_ptr<VAO> vao;
     std::unique_ptr<VBO> vbo;
     std::unique_ptr<EBO> ebo;
-    std::vector<Texture> textures;
+    std::vector<std::shared_ptr<Texture>> textures;  // Shared handles: several meshes may use the same texture
     
     GLsizei vertexCount;
     GLsizei indexCount;
+    VertexLayout layout;
+    VertexQuantization quantization;
+    std::vector<MeshLOD> lods;
+    std::vector<Meshlet> meshlets;
     
     // Bounding box for frustum culling
     BoundingBox boundingBox;
     
+    // Upload vertex data (already in layout's format) and index data, and create the vertex array
+    void createBuffers(std::span<const std::byte> vertexData, std::span<const GLuint> indices);
+    
     // Setup vertex attributes
     void setupVertexAttributes();
+    
+    // Tell the shader how to decode this mesh's vertices
+    void setVertexDecodeUniforms(Shader& shader);
 }; 
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+#include <glad/glad.h>
+#include <numeric>
+#include <span>
+#include <vector>
+
+// Triangles that use each vertex, stored compactly (CSR layout): the triangles around vertex v are
+// triangles[offsets[v]] .. triangles[offsets[v + 1] - 1]
+struct VertexTriangleAdjacency {
+    std::vector<GLuint> offsets;    // vertexCount + 1 entries
+    std::vector<GLuint> triangles;  // triangle ids, grouped by vertex
+
+    VertexTriangleAdjacency(std::span<const GLuint> indices, size_t vertexCount) {
+        offsets.assign(vertexCount + 1, 0);
+        for (GLuint index : indices) {
+            ++offsets[index + 1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        triangles.resize(indices.size());
+        std::vector<GLuint> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            triangles[fill[indices[i]]++] = (GLuint)(i / 3);
+        }
+    }
+
+    GLuint count(GLuint vertex) const { return offsets[vertex + 1] - offsets[vertex]; }
+};
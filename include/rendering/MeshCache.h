@@ -0,0 +1,81 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+#include "rendering/VBO.h"  // For Vertex struct
+#include "rendering/MeshSimplifier.h"  // For MeshLOD
+#include "rendering/Meshlets.h"
+#include "utils/FrustumCulling.h"
+#include "utils/MappedFile.h"
+
+// Identifies the source file a cache was built from
+struct MeshSourceInfo {
+    uint64_t size = 0;
+    int64_t modifiedTime = 0;
+    uint64_t contentHash = 0;  // Only computed when size/time alone can't decide
+};
+
+// Processed mesh data, as produced by a MeshPostProcess and stored in a .glowmesh file
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<GLuint> indices;
+    std::vector<MeshLOD> lods;      // Empty if no LOD chain was built
+    std::vector<Meshlet> meshlets;  // Empty if the mesh wasn't split into meshlets
+};
+
+// Final mesh data loaded from a .glowmesh file. The vertex and index spans point straight into the
+// memory-mapped file, so they can be handed to VBO/EBO uploads without any per-vertex work.
+// Falls back to owning the data when the cache couldn't be written.
+class MeshCache {
+public:
+    MeshCache() = default;
+    MeshCache(MeshCache&&) noexcept = default;
+    MeshCache& operator=(MeshCache&&) noexcept = default;
+
+    // Map a cache file and validate it against its source. Returns false if the cache is
+    // missing, malformed, written by a different format version, built with a different
+    // processKey, or older than the source
+    bool open(const std::string& cachePath, const std::string& sourcePath, uint64_t processKey = 0);
+
+    // Write a cache file for processed mesh data (written to a temporary file, then renamed).
+    // processKey identifies the post-processing that produced the data
+    static bool write(const std::string& cachePath, const std::string& sourcePath, const MeshData& mesh,
+                      const BoundingBox& bounds, uint64_t processKey = 0);
+
+    // Meshes/bunny.obj -> Meshes/bunny.glowmesh
+    static std::string cachePathFor(const std::string& sourcePath);
+
+    // Take ownership of data that isn't backed by a cache file
+    void assign(MeshData&& mesh, const BoundingBox& bounds);
+
+    std::span<const Vertex> getVertices() const { return vertices; }
+    std::span<const GLuint> getIndices() const { return indices; }
+    std::span<const MeshLOD> getLODs() const { return lods; }  // Empty if no LOD chain was built
+    std::span<const Meshlet> getMeshlets() const { return meshlets; }  // Empty if not split into meshlets
+    const BoundingBox& getBoundingBox() const { return boundingBox; }
+
+    // Check if the data came from a mapped cache file
+    bool isMapped() const { return file.isOpen(); }
+
+private:
+    MappedFile file;
+    MeshData owned;
+
+    std::span<const Vertex> vertices;
+    std::span<const GLuint> indices;
+    std::span<const MeshLOD> lods;
+    std::span<const Meshlet> meshlets;
+    BoundingBox boundingBox;
+};
+
+// Processing applied to a freshly loaded OBJ before it's cached (UV generation, tangents, LOD chain, ...)
+using MeshPostProcess = std::function<void(MeshData& mesh)>;
+
+// Load an OBJ through its .glowmesh cache. On a hit the cache is mapped and nothing else runs; on a
+// miss the OBJ is parsed, postProcess is applied and the cache is written for the next run.
+// Pass a different processKey whenever postProcess changes (e.g. optimization toggled) to force a rebuild
+MeshCache loadOBJCached(const std::string& objPath, const MeshPostProcess& postProcess = {},
+                        uint64_t processKey = 0);
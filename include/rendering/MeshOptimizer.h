@@ -0,0 +1,38 @@
+#pragma once
+#include <glad/glad.h>
+#include <span>
+#include <vector>
+#include "rendering/VBO.h"  // For Vertex struct
+
+// Post-transform vertex cache efficiency of an index buffer, simulated with a FIFO cache
+struct VertexCacheStats {
+    float acmr = 0.0f;  // Average cache misses per triangle (0.5 is the ideal for large meshes, 3 the worst)
+    float atvr = 0.0f;  // Average transforms per referenced vertex (1.0 is ideal)
+};
+
+// Before/after statistics from optimizeMesh
+struct MeshOptimizationReport {
+    VertexCacheStats before;
+    VertexCacheStats after;
+    size_t clusterCount = 0;        // Triangle clusters used for overdraw ordering
+    size_t removedVertexCount = 0;  // Vertices no triangle referenced
+};
+
+// Simulate a FIFO post-transform cache of cacheSize entries over the triangle list
+VertexCacheStats analyzeVertexCache(std::span<const GLuint> indices, size_t vertexCount, unsigned cacheSize = 16);
+
+// Reorder triangles for vertex cache locality (Tipsify, Sander et al. 2007). Deterministic
+void optimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount, unsigned cacheSize = 16);
+
+// Reorder clusters of an already cache-optimized index buffer so outward-facing clusters draw first,
+// which lets early depth testing reject more of what's behind them. threshold bounds how much the
+// cluster split may cost in cache efficiency (1.05 = up to 5% worse ACMR). Returns the cluster count
+size_t optimizeOverdraw(std::vector<GLuint>& indices, std::span<const Vertex> vertices, float threshold = 1.05f,
+                        unsigned cacheSize = 16);
+
+// Reorder vertices by first use so vertex fetch walks memory linearly; unreferenced vertices are dropped.
+// Returns the number of vertices removed
+size_t optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
+
+// Run the full pass: vertex cache, then overdraw, then vertex fetch order
+MeshOptimizationReport optimizeMesh(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
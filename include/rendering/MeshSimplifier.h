@@ -0,0 +1,27 @@
+#pragma once
+#include <glad/glad.h>
+#include <span>
+#include <vector>
+#include "rendering/VBO.h"  // For Vertex struct
+
+// One level of detail: a range of a mesh's shared index buffer. Every level indexes the same vertex buffer
+struct MeshLOD {
+    GLuint indexOffset = 0;
+    GLuint indexCount = 0;
+    float error = 0.0f;  // Approximate geometric deviation from LOD 0, in mesh units
+};
+
+// Triangle count of each generated level relative to LOD 0
+inline constexpr float defaultLODRatios[] = {0.5f, 0.25f, 0.1f};
+
+// Simplify a triangle list towards targetIndexCount indices with quadric error metrics (Garland & Heckbert).
+// Edges collapse onto one of their existing endpoints, so the result indexes the original vertex buffer.
+// Open borders and attribute seams (several vertices sharing a position) are never moved.
+// resultError receives the largest error of any collapse performed, in mesh units
+std::vector<GLuint> simplifyMesh(std::span<const Vertex> vertices, std::span<const GLuint> indices,
+                                 size_t targetIndexCount, float* resultError = nullptr);
+
+// Build an LOD chain from LOD 0 (all of indices). Each simplified level is cache-optimized and appended to
+// indices; the returned ranges start with LOD 0. Generation stops once a level no longer shrinks noticeably
+std::vector<MeshLOD> buildLODChain(std::span<const Vertex> vertices, std::vector<GLuint>& indices,
+                                   std::span<const float> ratios = defaultLODRatios);
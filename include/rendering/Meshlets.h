@@ -0,0 +1,54 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+#include "rendering/VBO.h"  // For Vertex struct
+
+// Meshlet size limits (in line with common mesh shader limits)
+inline constexpr size_t maxMeshletVertices = 64;
+inline constexpr size_t maxMeshletTriangles = 124;
+
+// A small cluster of triangles stored contiguously in its mesh's index buffer, with bounds for culling.
+// Bounds are in mesh space
+struct Meshlet {
+    GLuint indexOffset = 0;
+    GLuint indexCount = 0;
+    glm::vec3 center = glm::vec3(0.0f);  // Bounding sphere
+    float radius = 0.0f;
+    glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);  // Average facing direction of the triangles
+    float coneCutoff = 1.0f;  // Sine of the normal cone's half-angle; 1 means the cone can't be culled
+};
+
+// Split the triangles in indices[indexOffset, indexOffset + indexCount) into meshlets by growing each one across
+// shared vertices. The range is reordered in place so every meshlet's triangles are contiguous
+std::vector<Meshlet> buildMeshlets(std::span<const Vertex> vertices, std::span<GLuint> indices,
+                                   GLuint indexOffset, GLuint indexCount);
+
+// Index ranges to draw with glMultiDrawElements
+struct MeshletDrawList {
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;  // Byte offsets into the element buffer
+
+    void clear() {
+        counts.clear();
+        offsets.clear();
+    }
+    bool empty() const { return counts.empty(); }
+};
+
+// Per-frame culling counters
+struct MeshletCullStats {
+    size_t meshletsTested = 0;
+    size_t meshletsFrustumCulled = 0;
+    size_t meshletsConeCulled = 0;
+    size_t trianglesTested = 0;
+    size_t trianglesRejected = 0;
+
+    void reset() { *this = MeshletCullStats(); }
+};
+
+// Test one instance's meshlets against the view frustum and their backface cones, appending the survivors
+// to drawList (adjacent ranges are merged). Runs entirely on the CPU
+void cullMeshlets(std::span<const Meshlet> meshlets, const glm::mat4& viewProjection, const glm::mat4& model,
+                  const glm::vec3& cameraPosition, MeshletDrawList& drawList, MeshletCullStats& stats);
@@ -0,0 +1,13 @@
+#pragma once
+#include <glad/glad.h>
+#include <vector>
+#include "rendering/VBO.h"  // For Vertex struct
+
+// Per-vertex tangents computed the way the MikkTSpace reference implementation (mikktspace.c,
+// genTangSpaceDefault) computes them, so normal maps baked by tools built on it (Blender, xNormal, glTF
+// exporters) shade without seams. Each bitangent is sign * cross(normal, tangent).
+// MikkTSpace gives every triangle corner its own frame. A vertex whose corners end up with different frames
+// (across a UV seam, a handedness flip or a sharp change in tangent direction) is split: the first frame keeps
+// the vertex, every other frame gets an appended copy, and indices are rewritten to use it. Normals and texture
+// coordinates must already be set. Vertices no triangle uses are left as they are
+void calculateTangentsMikkTSpace(std::vector<Vertex>& vertices, std::vector<GLuint>& indices);
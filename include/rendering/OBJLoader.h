@@ -3,9 +3,10 @@
 #include <string>
 #include <fstream>
 #include <sstream>
-#include <unordered_map>
 #include <glm/glm.hpp>
 #include "rendering/VBO.h"  // For Vertex struct
+#include "utils/FlatHashMap.h"
+#include "utils/Hash.h"
 
 // Key for vertex deduplication
 struct OBJKey {
@@ -18,22 +19,47 @@ struct OBJKey {
     }
 };
 
-// Hash function for OBJKey
+// Hash function for OBJKey. Packs the three indices into 64 bits and mixes them, so large index
+// ranges don't collide the way an XOR of scaled indices does
 struct OBJKeyHash {
     size_t operator()(const OBJKey& key) const noexcept {
-        return ((size_t)key.positionIndex * 73856093u) ^ 
-               ((size_t)key.texCoordIndex * 19349663u) ^ 
-               ((size_t)key.normalIndex * 83492791u);
+        uint64_t packed = ((uint64_t)(uint32_t)key.positionIndex << 32) | (uint32_t)key.texCoordIndex;
+        return (size_t)mixHash(packed ^ ((uint64_t)(uint32_t)key.normalIndex * 0x9e3779b97f4a7c15ull));
     }
 };
 
+// Vertex deduplication table used by the loader
+using OBJVertexMap = FlatHashMap<OBJKey, GLuint, OBJKeyHash>;
+
+// Convert an OBJ index to 0-based. Positive indices are 1-based; negative ones count back
+// from the most recent element, given how many elements have been defined so far
+static inline int resolveOBJIndex(int index, size_t count) {
+    return index < 0 ? (int)count + index : index - 1;
+}
+
 // Helper function to safely parse integers
-static inline int parseIndex(const std::string& str) {
-    return std::stoi(str) - 1;  // Convert to 0-based indexing
+static inline int parseIndex(const std::string& str, size_t count) {
+    return resolveOBJIndex(std::stoi(str), count);
 }
 
-// Function to calculate normals from geometry when they're missing
-void calculateNormalsFromGeometry(std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
+// How loadOBJFile reads the file
+enum class OBJLoadMode {
+    Stream,  // std::getline + std::istringstream per line (original path)
+    Mapped,  // Memory-mapped and tokenized in place, no per-line allocation
+    Parallel // Mapped, split at line boundaries and parsed on all cores
+};
 
 // Load OBJ file and return vertices and indices compatible with your Mesh class
-std::pair<std::vector<Vertex>, std::vector<GLuint>> loadOBJFile(const std::string& filepath); 
\ No newline at end of file
+std::pair<std::vector<Vertex>, std::vector<GLuint>> loadOBJFile(const std::string& filepath,
+                                                                OBJLoadMode mode = OBJLoadMode::Parallel);
+
+// Parallel load with an explicit thread count (0 = all cores). The output is identical for every thread count
+std::pair<std::vector<Vertex>, std::vector<GLuint>> loadOBJFileParallel(const std::string& filepath,
+                                                                        unsigned threadCount = 0);
+
+// Load the same file with every mode, print the timings and check the outputs are identical
+bool compareOBJLoadModes(const std::string& filepath);
+
+// Microbenchmark of the vertex deduplication table against std::unordered_map, on synthetic
+// keys and on the face corners of an OBJ file (skipped if filepath is empty)
+void benchmarkOBJDedup(const std::string& filepath);
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Source maps of a packed occlusion/roughness/metallic texture: R = AO, G = roughness, B = metallic
+struct ORMSources {
+    std::string ao;
+    std::string roughness;
+    std::string metallic;
+};
+
+// Where the packed texture is cached: the sources' shared name with "_orm.ktx2", next to the AO map
+// (e.g. Textures/Panel_ao.png + Panel_roughness.png + Panel_metallic.png -> Textures/Panel_orm.ktx2)
+std::string ormCachePath(const ORMSources& sources);
+
+// Whether the cache file exists and is newer than every source
+bool isORMCacheFresh(const std::string& cachePath, const ORMSources& sources);
+
+// Whether the maps can share one texture: all three readable with the same size (checked from the image
+// headers), or a fresh cache already holds them
+bool canPackORM(const ORMSources& sources);
+
+// Decode the three maps (flipped for GL like every texture) and interleave their first channels into RGB.
+// Throws std::runtime_error when a map is missing or the sizes differ
+std::vector<unsigned char> packORM(const ORMSources& sources, int& width, int& height);
@@ -1,8 +1,13 @@
 #pragma once
+#include <cstdint>
 #include <vector>
 #include <memory>
+#include "rendering/MaterialPool.h"
 #include "rendering/Texture.h"
 
+class AssetRegistry;
+
+// Texture handles are shared: with a registry, materials that use the same file share one GL texture
 class PBRMaterial {
 public:
     PBRMaterial();
@@ -12,6 +17,20 @@ public:
                 const std::string& roughnessPath,
                 const std::string& aoPath);
     
+    // Same, but the textures start as placeholders and stream in through the loader (see isReady).
+    // With a registry, textures already loaded elsewhere are reused. Metallic, roughness and AO are packed
+    // into one ORM texture when they can be (see canPackORM), and kept as separate maps otherwise. With a
+    // pool, the maps go into a layer of its texture arrays instead when their sizes and formats allow, unless
+    // the loader streams mips and every map has a baked file to stream from
+    PBRMaterial(const std::string& albedoPath, 
+                const std::string& normalPath,
+                const std::string& metallicPath,
+                const std::string& roughnessPath,
+                const std::string& aoPath,
+                TextureLoader& loader,
+                AssetRegistry* registry = nullptr,
+                MaterialPool* pool = nullptr);
+    
     // Move constructor
     PBRMaterial(PBRMaterial&& other) noexcept;
     
@@ -28,12 +47,26 @@ public:
     // Unbind all textures
     void unbindTextures();
     
-    // Set material properties
-    void setAlbedo(const std::string& path);
-    void setNormal(const std::string& path);
-    void setMetallic(const std::string& path);
-    void setRoughness(const std::string& path);
-    void setAO(const std::string& path);
+    // Set material properties (loaded asynchronously when a loader is given, shared through the registry)
+    void setAlbedo(const std::string& path, TextureLoader* loader = nullptr, AssetRegistry* registry = nullptr);
+    void setNormal(const std::string& path, TextureLoader* loader = nullptr, AssetRegistry* registry = nullptr);
+    void setMetallic(const std::string& path, TextureLoader* loader = nullptr, AssetRegistry* registry = nullptr);
+    void setRoughness(const std::string& path, TextureLoader* loader = nullptr, AssetRegistry* registry = nullptr);
+    void setAO(const std::string& path, TextureLoader* loader = nullptr, AssetRegistry* registry = nullptr);
+    
+    // Replace the metallic, roughness and AO maps with one packed texture (R = AO, G = roughness, B = metallic)
+    void setORM(const ORMSources& sources, TextureLoader& loader, AssetRegistry* registry = nullptr);
+    
+    // Whether the packed ORM texture is used; draw with the ORM_MAP variant of the G-buffer shader then
+    bool usesPackedORM() const { return hasORM; }
+    
+    // Whether the maps live in a MaterialPool layer; draw with the MATERIAL_ARRAY variant then, with the
+    // pool bound (bindTextures leaves pooled maps alone)
+    bool usesMaterialPool() const { return poolSlot.isValid(); }
+    const MaterialSlot& getPoolSlot() const { return poolSlot; }
+    
+    // ShaderFeature bits of the G-buffer shader variant this material draws with
+    uint32_t getShaderFeatures() const;
     
     // Get texture references
     const Texture& getAlbedoTexture() const { return *albedoTexture; }
@@ -41,23 +74,39 @@ public:
     const Texture& getMetallicTexture() const { return *metallicTexture; }
     const Texture& getRoughnessTexture() const { return *roughnessTexture; }
     const Texture& getAOTexture() const { return *aoTexture; }
+    const Texture& getORMTexture() const { return *ormTexture; }
     
     // Check if material has all required textures
     bool isValid() const;
     
+    // Check if every texture has finished loading (placeholders are still bound until then)
+    bool isReady() const;
+    
+    // Pass this frame's screen-space size of the material, in pixels across, to its streamed textures
+    void requestResolution(float pixels) const;
+    
     // Cleanup resources
     void destroy();
 
 private:
-    std::unique_ptr<Texture> albedoTexture;
-    std::unique_ptr<Texture> normalTexture;
-    std::unique_ptr<Texture> metallicTexture;
-    std::unique_ptr<Texture> roughnessTexture;
-    std::unique_ptr<Texture> aoTexture;
+    std::shared_ptr<Texture> albedoTexture;
+    std::shared_ptr<Texture> normalTexture;
+    std::shared_ptr<Texture> metallicTexture;
+    std::shared_ptr<Texture> roughnessTexture;
+    std::shared_ptr<Texture> aoTexture;
+    std::shared_ptr<Texture> ormTexture;
     
     bool hasAlbedo;
     bool hasNormal;
     bool hasMetallic;
     bool hasRoughness;
     bool hasAO;
+    bool hasORM = false;
+    
+    MaterialPool* pool = nullptr;
+    MaterialSlot poolSlot;
+    
+    // Shared handle to a texture, from the registry if there is one
+    static std::shared_ptr<Texture> loadTexture(const std::string& path, TextureType type, TextureLoader* loader,
+                                                AssetRegistry* registry);
 }; 
\ No newline at end of file
@@ -6,15 +6,29 @@
 class PBRMesh : public Mesh {
 public:
     // Constructor with PBR material
-    PBRMesh(const std::vector<Vertex>& vertices, 
-             const std::vector<GLuint>& indices, 
+    PBRMesh(std::span<const Vertex> vertices, 
+             std::span<const GLuint> indices, 
              PBRMaterial&& material);
     
+    // Constructor with a precomputed bounding box (e.g. from a mesh cache), uploading in the given vertex format
+    template<typename Format = LitVertexFormat>
+    PBRMesh(std::span<const Vertex> vertices, 
+             std::span<const GLuint> indices, 
+             const BoundingBox& bounds,
+             PBRMaterial&& material,
+             Format format = {})
+        : Mesh(vertices, indices, bounds, format), pbrMaterial(std::move(material)) {
+        setupPBRVertexAttributes();
+    }
+    
     // Destructor
     ~PBRMesh();
     
-    // Render the mesh with PBR shader
-    void drawPBR(Shader& pbrShader);
+    // Render the mesh with PBR shader at the given level of detail
+    void drawPBR(Shader& pbrShader, int lod = 0);
+    
+    // Render only the given index ranges with PBR shader
+    void drawPBR(Shader& pbrShader, const MeshletDrawList& ranges);
     
     // Set PBR material
     void setMaterial(PBRMaterial&& material);
@@ -30,4 +44,7 @@ private:
     
     // Setup PBR-specific vertex attributes
     void setupPBRVertexAttributes();
+    
+    // Bind material textures and point the shader's samplers at them
+    void bindMaterial(Shader& pbrShader);
 }; 
\ No newline at end of file
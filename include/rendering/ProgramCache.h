@@ -0,0 +1,32 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Program cache counters for this run
+struct ProgramCacheStats {
+    size_t hits = 0;
+    size_t misses = 0;    // Compiled from source (no entry, or the driver rejected it)
+    size_t rejected = 0;  // Of the misses, entries the driver refused (e.g. after a driver update)
+    double savedMs = 0.0; // Compile and link time of the hits, less the time to load them
+};
+
+// Linked program binaries (glGetProgramBinary) kept on disk in ShaderCache/, so later runs skip compiling
+// and linking. Entries are keyed by the final GLSL sources (defines included) and the driver's vendor,
+// renderer and version strings; anything else that makes a binary stale is caught by the driver refusing it
+
+// Cache key of a program built from these sources on the current driver (needs the GL context)
+uint64_t programCacheKey(const std::string& vertexSource, const std::string& fragmentSource);
+
+// Link program from its cached binary. False when there is no entry or the driver rejects it; the program can
+// then be built from source as usual
+bool loadCachedProgram(GLuint program, uint64_t key);
+
+// Ask the driver to keep the binary of a program about to be linked, so it can be cached
+void prepareProgramForCache(GLuint program);
+
+// Save a linked program's binary, with the time it took to build for the savings report
+void storeCachedProgram(GLuint program, uint64_t key, double buildMs);
+
+const ProgramCacheStats& getProgramCacheStats();
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "rendering/shader.h"
+
+class AssetRegistry;
+
+// Switches compiled into a shader variant instead of branched on per fragment. Each maps to a #define
+enum ShaderFeature : uint32_t {
+    ShaderFeatureNormalMap = 1u << 0,      // NORMAL_MAP: perturb the normal with the normal map
+    ShaderFeaturePackedORM = 1u << 1,      // ORM_MAP: one packed occlusion/roughness/metallic texture
+    ShaderFeatureMaterialArray = 1u << 2,  // MATERIAL_ARRAY: maps in a MaterialPool layer
+    ShaderFeatureDirLight = 1u << 3,       // DIR_LIGHT: add the directional lights
+    ShaderFeatureClustered = 1u << 4,      // CLUSTERED: only the lights listed for the pixel's cluster
+    ShaderFeatureLightVolumes = 1u << 5,   // LIGHT_VOLUMES: leave point and spot lights to their volumes
+    ShaderFeaturePointVolume = 1u << 6,    // POINT_VOLUME: a sphere per point light, shading just that light
+    ShaderFeatureSpotVolume = 1u << 7,     // SPOT_VOLUME: a cone per spotlight, shading just that light
+    ShaderFeatureShadows = 1u << 8,        // SHADOWS: look up the directional and spotlight maps of a ShadowAtlas
+};
+
+// QUALITY: how much of the shading model is evaluated (matches QUALITY_LOW/MEDIUM/HIGH in the shaders)
+enum class ShaderQuality : int { Low = 0, Medium = 1, High = 2 };
+
+// Which variant of a shader to use
+struct ShaderVariantKey {
+    uint32_t features = 0;  // ShaderFeature bits
+    ShaderQuality quality = ShaderQuality::High;
+
+    bool operator==(const ShaderVariantKey& other) const = default;
+
+    // The #defines that build this variant
+    std::vector<std::string> defines() const;
+};
+
+// The variants of one vertex/fragment pair, compiled the first time each key is asked for (through the
+// asset registry, so the program binary cache and shared programs apply) and kept for later lookups.
+// Compiling is submitted without waiting (see Shader), so variants prepared together build in parallel
+class ShaderPermutations {
+public:
+    ShaderPermutations(AssetRegistry& registry, std::string vertexPath, std::string fragmentPath);
+
+    // The variant for key; cheap after its first use (a scan over the few compiled variants). Using it waits
+    // for its build
+    Shader& get(const ShaderVariantKey& key);
+
+    // Submit the variants that haven't been yet, without waiting for any of them
+    void prepare(const std::vector<ShaderVariantKey>& keys);
+
+    // Whether key's variant is built (submitting it if it hasn't been), so using it won't stall the frame
+    bool isReady(const ShaderVariantKey& key);
+
+    size_t getVariantCount() const { return variants.size(); }
+
+    // Variants submitted but still building
+    size_t getPendingCount() const;
+
+    // Release every variant (needs the GL context)
+    void clear() { variants.clear(); }
+
+private:
+    AssetRegistry& registry;
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::vector<std::pair<ShaderVariantKey, std::shared_ptr<Shader>>> variants;
+};
@@ -1,6 +1,13 @@
 #pragma once
 #include <glad/glad.h>
+#include <memory>
 #include <string>
+#include "rendering/ORMPacking.h"
+#include "rendering/TextureCompression.h"
+
+class TextureLoader;
+struct TextureRequest;
+struct StreamedTexture;
 
 enum class TextureType {
     DIFFUSE,
@@ -9,7 +16,8 @@ enum class TextureType {
     ALBEDO,
     METALLIC,
     ROUGHNESS,
-    AO
+    AO,
+    ORM  // Packed occlusion (R), roughness (G), metallic (B)
 };
 
 class Texture {
@@ -19,12 +27,30 @@ public:
     TextureType type;
     std::string path;
     
-    // Constructor - loads texture from file
+    // Constructor - loads texture from file. A baked .ktx2 next to the file (see findBakedTexture) is used
+    // instead when the driver supports its format
     Texture(const char* filePath);
     
     // Constructor - loads texture from file with type
     Texture(const char* filePath, TextureType textureType);
     
+    // Constructor - starts with a 1x1 placeholder for the type and lets the loader decode and upload the file.
+    // width/height/nrChannels describe the placeholder until the first bind after the upload. Baked files
+    // are streamed when the loader has a streaming budget
+    Texture(const char* filePath, TextureType textureType, TextureLoader& loader);
+    
+    // Constructor - ORM texture packed from three maps by the loader (see TextureLoader::loadPacked); path is
+    // the cache file
+    Texture(const ORMSources& sources, TextureLoader& loader);
+    
+    // Whether the file's data has arrived (or failed to load, leaving the placeholder). Always true for
+    // textures loaded synchronously
+    bool isReady() const;
+    
+    // Detail the texture is drawn at this frame, as pixels across its projection (see
+    // StreamedTexture::requestResolution). No effect unless it's streamed
+    void requestResolution(float pixels) const;
+    
     // Bind/unbind texture to texture unit
     void bind(GLenum textureUnit = GL_TEXTURE0);
     void unbind();
@@ -42,6 +68,51 @@ public:
     // Get texture type as string
     std::string getTypeString() const;
     
+    // Approximate GPU memory of the texture and its mip chain, in bytes
+    size_t getGPUMemorySize() const;
+    
+    // Pixel transfer format for a channel count
+    static GLenum formatForChannels(int channels);
+    
+    // Storage format for a channel count; color (sRGB) data is decoded to linear by the sampler
+    static GLenum internalFormatFor(int channels, bool srgb);
+    
+    // Color a texture of the type shows until its image has loaded
+    static void placeholderColor(TextureType type, unsigned char rgba[4]);
+    
+    // Albedo is the only sRGB-encoded map type
+    static bool isSRGBType(TextureType type) { return type == TextureType::ALBEDO; }
+    
+    // GL internal format of a block-compressed format, and whether the driver can sample it
+    static GLenum compressedFormat(BlockFormat format);
+    static bool isCompressedFormatSupported(BlockFormat format);
+    
+    // The baked .ktx2 file for a source image: same name with the .ktx2 extension, unless the source has
+    // been modified since. Empty when there is none
+    static std::string findBakedTexture(const std::string& sourcePath);
+    
+    // Upload every level of a compressed texture (from its firstLevel) to the bound GL_TEXTURE_2D. data is
+    // texture.data, or nullptr to read from the bound pixel unpack buffer (levels at their offsets). With
+    // clampToLevels the base and max level are set to exactly the uploaded levels
+    static void uploadCompressedLevels(const CompressedTexture& texture, const unsigned char* data,
+                                       bool clampToLevels = true);
+    
     // Cleanup
     void destroy();
+
+private:
+    std::shared_ptr<TextureRequest> request;  // Pending asynchronous load
+    std::shared_ptr<StreamedTexture> stream;  // Mip streaming state, when streamed
+    size_t gpuMemorySize = 0;
+    
+    // Load path synchronously into the bound texture, from its baked file when possible
+    void loadFile();
+};
+
+// Deleter for shared texture handles: releases the GL texture along with the last handle
+struct TextureDeleter {
+    void operator()(Texture* texture) const {
+        texture->destroy();
+        delete texture;
+    }
 };
\ No newline at end of file
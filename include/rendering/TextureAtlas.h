@@ -0,0 +1,61 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Where an image landed in a TextureAtlas: atlas UV = offset + uv * scale, for uv in [0, 1]
+struct AtlasRegion {
+    glm::vec2 offset{0.0f};
+    glm::vec2 scale{0.0f};
+
+    bool isValid() const { return scale.x > 0.0f; }
+};
+
+// Small one-off images packed into one RGBA texture (rectangles placed by stb_rect_pack as images arrive),
+// so the meshes using them share a bind. Each image is surrounded by a gutter of its repeated edge texels
+// and placed on a multiple of the gutter size, so filtering and the mip levels down to one gutter-sized
+// texel never blend neighbours. Region UVs must stay in [0, 1]: an atlas region can't wrap
+class TextureAtlas {
+public:
+    // gutter is rounded up to a power of two; it also caps the mip chain at log2(gutter) levels
+    explicit TextureAtlas(int size = 1024, bool srgb = true, int gutter = 4);
+    ~TextureAtlas();
+
+    TextureAtlas(const TextureAtlas&) = delete;
+    TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+    // Load an image synchronously and place it; the same path is placed once. Invalid region if the image
+    // can't be loaded or doesn't fit
+    AtlasRegion add(const std::string& path);
+
+    // Place tightly packed 8-bit RGBA pixels, rows bottom to top like GL
+    AtlasRegion add(const unsigned char* rgba, int width, int height);
+
+    // Bind the atlas, rebuilding its mip levels first if images were added since the last bind
+    void bind(GLenum textureUnit = GL_TEXTURE0);
+
+    GLuint getId() const { return id; }
+    int getSize() const { return size; }
+
+    // Fraction of the atlas covered by images and their gutters
+    float getOccupancy() const { return (float)usedArea / ((float)size * size); }
+
+    size_t getGPUMemorySize() const { return (size_t)size * size * 4 * 4 / 3; }
+
+    // Release the texture (needs the GL context)
+    void destroy();
+
+private:
+    struct Packer;  // stb_rect_pack state, in cells of gutter x gutter texels
+    std::unique_ptr<Packer> packer;
+
+    GLuint id = 0;
+    int size;
+    int gutter;
+    size_t usedArea = 0;
+    bool mipsDirty = false;
+    std::unordered_map<std::string, AtlasRegion> regions;
+};
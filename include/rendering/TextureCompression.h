@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// GPU block-compressed formats, 4x4 texels per block. CPU only: nothing here needs a GL context
+enum class BlockFormat : uint8_t {
+    BC1,       // RGB, 8 bytes per block
+    BC1_SRGB,
+    BC4,       // Single channel, 8 bytes per block
+    BC5,       // Two channels (tangent-space normal XY), 16 bytes per block
+    BC7,       // RGBA, 16 bytes per block
+    BC7_SRGB
+};
+
+// What the texels mean, which decides how mip levels are filtered
+enum class MipContent : uint8_t {
+    Linear,    // Data (roughness, metallic, occlusion): filtered as stored
+    SRGB,      // Color: filtered in linear light, stored sRGB-encoded
+    NormalMap  // Tangent-space normals: filtered as vectors and renormalized
+};
+
+// One mip level's blocks within CompressedTexture::data
+struct CompressedLevel {
+    uint32_t width;
+    uint32_t height;
+    size_t offset;
+    size_t size;
+};
+
+// A block-compressed image with its full mip chain, level 0 first (or part of the chain, from firstLevel)
+struct CompressedTexture {
+    BlockFormat format = BlockFormat::BC1;
+    uint32_t width = 0;   // Of level 0, even when it wasn't read
+    uint32_t height = 0;
+    uint32_t firstLevel = 0;  // Mip level of levels[0]
+    std::vector<CompressedLevel> levels;
+    std::vector<unsigned char> data;
+};
+
+// Bytes per 4x4 block
+size_t blockBytes(BlockFormat format);
+
+// Whether the format decodes to sRGB
+bool isSRGBFormat(BlockFormat format);
+
+// Encode one block of 16 texels (row-major, 4 bytes each, RGBA). BC4 reads one channel, BC5 red and green
+void encodeBC1Block(const unsigned char* rgba, unsigned char* block);
+void encodeBC4Block(const unsigned char* rgba, unsigned char* block, int channel = 0);
+void encodeBC5Block(const unsigned char* rgba, unsigned char* block);
+void encodeBC7Block(const unsigned char* rgba, unsigned char* block);
+
+// Encode one block in any of the formats
+void encodeBlock(BlockFormat format, const unsigned char* rgba, unsigned char* block);
+
+// Build the mip chain of an 8-bit image (1-4 channels, tightly packed rows) with a [1 3 3 1] filter that
+// wraps at the edges like GL_REPEAT, and compress every level. Block rows of all levels are spread over
+// threadCount threads (0 = all cores)
+CompressedTexture compressTexture(const unsigned char* pixels, int width, int height, int channels,
+                                  BlockFormat format, MipContent content, unsigned threadCount = 0);
@@ -0,0 +1,213 @@
+#pragma once
+#include <glad/glad.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "rendering/ORMPacking.h"
+#include "rendering/TextureCompression.h"
+
+// A layer of a GL_TEXTURE_2D_ARRAY to fill, instead of a whole GL_TEXTURE_2D. The array's storage is fixed,
+// so an image that doesn't match it (e.g. a baked file replaced by one of another size) fails to load
+struct TextureLayerTarget {
+    int layer = 0;
+    GLenum internalFormat = 0;  // Texture::compressedFormat for block-compressed arrays
+    int width = 0;
+    int height = 0;
+    int levels = 1;             // Compressed images must bring exactly this many levels
+};
+
+// One texture's trip through the loader, shared between the loader and the Texture that asked for it
+struct TextureRequest {
+    enum class State { Queued, Decoded, Ready, Failed };
+
+    std::string path;
+    std::string bakedPath;  // Block-compressed .ktx2 to use instead of path, if any
+    bool srgb = false;      // Color data, stored in an sRGB format
+    std::optional<ORMSources> ormSources;  // Maps to pack into this texture (path is then the cache file)
+    GLuint texture = 0;
+    std::optional<TextureLayerTarget> layerTarget;  // texture is an array and this is the layer to fill
+    bool streamed = false;    // Levels of a streamed texture (see TextureLoader::stream): no source fallback
+    uint32_t firstLevel = 0;  // Baked levels to read; levelCount 0 reads from firstLevel to the last
+    uint32_t levelCount = 0;
+    std::atomic<State> state{State::Queued};
+    bool cancelled = false;  // The texture was destroyed before its upload (GL thread only)
+
+    // Decoded image, owned until it has been uploaded
+    unsigned char* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    int channels = 0;
+    CompressedTexture baked;  // Filled instead of pixels when the baked file was read
+    std::vector<unsigned char> packedPixels;  // Packed ORM maps, when they aren't compressed
+
+    size_t gpuBytes = 0;  // Size of the uploaded texture, once Ready
+
+    ~TextureRequest();
+    void releasePixels();
+
+    // What gets copied into the pixel buffer
+    const unsigned char* uploadData() const;
+    size_t uploadSize() const;
+};
+
+// Mip streaming state of one baked texture (see TextureLoader::stream). Levels residentLevel and coarser are
+// in GPU memory, and the texture's base level is clamped to residentLevel so the sampler never reaches
+// a level that hasn't arrived
+struct StreamedTexture {
+    GLuint texture = 0;
+    std::string path;
+    int width = 0;   // Of level 0
+    int height = 0;
+    BlockFormat format = BlockFormat::BC1;
+    std::vector<size_t> levelBytes;
+    int tailLevel = 0;      // This level and coarser ones load up front and are never evicted
+    int residentLevel = 0;  // Finest level in GPU memory; levelCount() until the tail has arrived
+    int wantedLevel = 0;    // Finest level asked for since the loader's last update; levelCount() if none
+    int demandLevel = 0;    // wantedLevel as of the last update
+    uint64_t lastUsedFrame = 0;
+    std::shared_ptr<TextureRequest> pending;  // Levels on their way
+    int pendingLevel = 0;
+    bool failed = false;    // A read failed; stays at what it has
+
+    int levelCount() const { return (int)levelBytes.size(); }
+
+    // Ask for enough detail to cover `pixels` screen pixels across the texture. Called on the GL thread any
+    // number of times per frame; the finest request wins
+    void requestResolution(float pixels);
+
+    // GPU memory of the resident levels
+    size_t residentBytes() const;
+};
+
+// Streaming counters, covering streamed textures only (textures loaded whole aren't evictable)
+struct TextureStreamingStats {
+    size_t budgetBytes = 0;
+    size_t pinnedBytes = 0;     // Resident for good but counted against the budget (material pool arrays)
+    size_t residentBytes = 0;   // Levels in GPU memory or on their way
+    size_t usedBytes = 0;       // Of those, the levels drawn last frame were sampling
+    size_t textures = 0;
+    size_t levelsStreamed = 0;
+    size_t levelsEvicted = 0;
+};
+
+// Loader counters; times are GL-thread milliseconds spent in update()
+struct TextureLoaderStats {
+    size_t pending = 0;  // Requested but not yet uploaded
+    size_t uploaded = 0;
+    size_t failed = 0;
+    size_t bytesUploaded = 0;
+    double lastUpdateMs = 0.0;
+    double maxUpdateMs = 0.0;  // Worst frame so far (upload hitch)
+};
+
+// Decodes images on worker threads and uploads them on the GL thread through a pixel buffer object.
+// Each image is copied into the mapped PBO a slice at a time under a per-frame budget (the PBO stays
+// mapped across frames), then handed to glTexImage2D in one call so the texture never shows a partial
+// image. Textures keep a 1x1 placeholder until then. Baked block-compressed files are read instead of the
+// source image when the driver supports their format, and uploaded level by level with no mipmap generation
+class TextureLoader {
+public:
+    explicit TextureLoader(unsigned threadCount = 0);
+    ~TextureLoader();
+
+    TextureLoader(const TextureLoader&) = delete;
+    TextureLoader& operator=(const TextureLoader&) = delete;
+
+    // Queue filePath (or its baked version) for decoding into an existing texture object, or into one layer
+    // of an existing texture array
+    std::shared_ptr<TextureRequest> load(GLuint texture, const std::string& filePath, bool srgb = false,
+                                         const std::optional<TextureLayerTarget>& layer = std::nullopt);
+
+    // Queue three maps to be packed into one RGB texture. The result is compressed and cached next to the
+    // sources (see ormCachePath) when the driver supports BC7; a fresh cache is loaded directly
+    std::shared_ptr<TextureRequest> loadPacked(GLuint texture, const ORMSources& sources,
+                                               const std::optional<TextureLayerTarget>& layer = std::nullopt);
+
+    // Advance uploads for roughly budgetMs (at least one slice). Call once per frame on the GL thread
+    void update(double budgetMs = 2.0);
+
+    // Mip streaming of baked textures: only the levels up to 128 pixels load up front, finer ones on worker
+    // threads as StreamedTexture::requestResolution asks for them, and the least recently used finer levels
+    // are evicted to stay under budgetBytes. 0 (the default) turns streaming off and textures load whole
+    void setStreamingBudget(size_t budgetBytes) { streamingStats.budgetBytes = budgetBytes; }
+    bool isStreaming() const { return streamingStats.budgetBytes > 0; }
+
+    // Memory that shares the streaming budget but is never evicted, such as material pool arrays; streamed
+    // levels get what's left of the budget
+    void setPinnedBytes(size_t bytes) { streamingStats.pinnedBytes = bytes; }
+
+    // Stream a baked .ktx2 file into an existing texture object. nullptr if it can't be streamed (unreadable,
+    // or a format the driver can't sample), to load it whole instead
+    std::shared_ptr<StreamedTexture> stream(GLuint texture, const std::string& bakedPath);
+
+    const TextureStreamingStats& getStreamingStats() const { return streamingStats; }
+
+    // Nothing left to decode or upload
+    bool isIdle() const { return stats.pending == 0; }
+
+    const TextureLoaderStats& getStats() const { return stats; }
+
+    // Stop the workers and release the pixel buffer (needs the GL context)
+    void destroy();
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wakeWorkers;
+    std::deque<std::shared_ptr<TextureRequest>> decodeQueue;
+    std::deque<std::shared_ptr<TextureRequest>> uploadQueue;  // Decoded (or failed), waiting for the GL thread
+    bool stopping = false;
+
+    // Upload in progress
+    std::shared_ptr<TextureRequest> current;
+    GLuint pixelBuffer = 0;
+    unsigned char* mapped = nullptr;
+    size_t copiedBytes = 0;
+
+    TextureLoaderStats stats;
+
+    // Streamed textures; their Texture owns them
+    std::vector<std::weak_ptr<StreamedTexture>> streamedTextures;
+    TextureStreamingStats streamingStats;
+    uint64_t frame = 0;
+
+    // Bit per BlockFormat the driver can sample, queried on the GL thread by the first load()
+    uint32_t supportedBlockFormats = 0;
+    bool formatsQueried = false;
+
+    void workerLoop();
+
+    // Read the request's baked file; false if it can't be used
+    bool readBaked(TextureRequest& request);
+
+    // Pack the request's ORM maps (and cache them compressed); false if they can't be loaded
+    bool packORMTexture(TextureRequest& request);
+
+    void queryBlockFormats();
+    std::shared_ptr<TextureRequest> enqueue(std::shared_ptr<TextureRequest> request);
+    void stopWorkers();
+
+    // Absorb finished levels, then evict and request levels for the frame's demand. Runs at the start of
+    // update() and never waits: textures draw with what they have until their levels arrive
+    void updateStreaming();
+
+    // Drop the finest level of the least recently used texture that doesn't need it (or of any texture
+    // but keep, unless onlyUnneeded). Returns the bytes freed, 0 if there was nothing to evict
+    size_t evictLevel(const std::vector<std::shared_ptr<StreamedTexture>>& textures, const StreamedTexture* keep,
+                      bool onlyUnneeded);
+
+    // Take the next decoded image and map the PBO for it; false when nothing is waiting
+    bool beginUpload();
+    void finishUpload();
+
+    // Copy the current image from the bound PBO into its array layer; false if it doesn't fit the array
+    bool uploadLayer(TextureRequest& request);
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <glad/glad.h>
 #include "VBO.h"
+#include "VertexFormat.h"
 
 class VAO {
 public:
@@ -8,7 +9,12 @@ public:
 
 	GLuint id;
 
-	void LinkAttrib(VBO& vbo, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset);
+	void LinkAttrib(VBO& vbo, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset,
+	                GLboolean normalized = GL_FALSE);
+	// Link every attribute of a vertex format stored interleaved in vbo
+	void linkFormat(VBO& vbo, const VertexLayout& layout);
+	template<typename Format>
+	void linkFormat(VBO& vbo) { linkFormat(vbo, vertexLayout<Format>()); }
 	void bind();
 	void unbind();
 	void destroy();
@@ -1,6 +1,8 @@
 #pragma once
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <cstddef>
+#include <span>
 #include <vector>
 
 // Vertex structure that matches the vertex shader attributes
@@ -25,7 +27,8 @@ struct Vertex {
 class VBO {
 public:
 	GLuint id;
-	VBO(const std::vector<Vertex>& vertices);
+	VBO(std::span<const Vertex> vertices);
+	VBO(std::span<const std::byte> data);  // Any other vertex layout
 
 	void bind();
 	void unbind();
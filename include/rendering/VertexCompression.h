@@ -0,0 +1,50 @@
+#pragma once
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "rendering/VBO.h"  // For Vertex struct
+#include "rendering/VertexFormat.h"
+#include "utils/FrustumCulling.h"  // For BoundingBox
+
+// Compact vertex: vertex color is dropped and the bitangent is rebuilt in the shader from the normal, the
+// tangent and a handedness sign
+struct PackedVertex {
+    uint16_t position[4];  // aPos (location = 0): unorm16 within the mesh bounds; w holds the handedness (0 = -1, max = +1)
+    uint16_t texCoord[2];  // aTexCoord (location = 2): half floats
+    int16_t normal[2];     // aNormal (location = 3): octahedral, snorm16
+    int16_t tangent[2];    // aTangent (location = 4): octahedral, snorm16
+};
+static_assert(sizeof(PackedVertex) == 20, "PackedVertex must stay tightly packed");
+
+// Maps quantized positions back to mesh space: position = offset + unorm * scale
+struct VertexQuantization {
+    glm::vec3 offset = glm::vec3(0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+
+    static VertexQuantization fromBounds(const BoundingBox& bounds);
+};
+
+// Octahedral mapping of a unit vector onto [-1, 1]^2, and back
+glm::vec2 octEncode(const glm::vec3& direction);
+glm::vec3 octDecode(const glm::vec2& encoded);
+
+// IEEE half-precision conversion (round to nearest even)
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+
+// Vertex format of PackedVertex. Positions must lie within the bounds the quantization was made from
+struct PackedVertexFormat : VertexFormat<
+    VertexAttrib<VertexSemantic::Position, uint16_t, 4, true>,
+    VertexAttrib<VertexSemantic::TexCoord, HalfFloat, 2>,
+    VertexAttrib<VertexSemantic::Normal, int16_t, 2, true>,
+    VertexAttrib<VertexSemantic::Tangent, int16_t, 2, true>> {
+    static constexpr uint32_t derivedLocations = 1u << (GLuint)VertexSemantic::Bitangent;
+    static constexpr bool quantized = true;
+
+    static std::vector<std::byte> encode(std::span<const Vertex> vertices, const VertexQuantization& quantization);
+};
+static_assert(PackedVertexFormat::stride == sizeof(PackedVertex), "PackedVertexFormat must match PackedVertex");
+static_assert(PackedVertexFormat::attributes[3].offset == offsetof(PackedVertex, tangent),
+              "PackedVertexFormat must match PackedVertex");
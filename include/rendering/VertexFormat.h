@@ -0,0 +1,161 @@
+#pragma once
+#include <glad/glad.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "rendering/VBO.h"  // For Vertex struct
+
+struct VertexQuantization;
+
+// Attribute slots shared by every vertex shader: the semantic's value is its layout(location = N)
+enum class VertexSemantic : GLuint {
+    Position = 0,
+    Color = 1,
+    TexCoord = 2,
+    Normal = 3,
+    Tangent = 4,
+    Bitangent = 5
+};
+
+// Half-precision float component (GL_HALF_FLOAT)
+struct HalfFloat {
+    uint16_t bits;
+};
+
+// GL component type for a C++ component type
+template<typename T> constexpr GLenum glComponentType();
+template<> constexpr GLenum glComponentType<float>() { return GL_FLOAT; }
+template<> constexpr GLenum glComponentType<HalfFloat>() { return GL_HALF_FLOAT; }
+template<> constexpr GLenum glComponentType<int8_t>() { return GL_BYTE; }
+template<> constexpr GLenum glComponentType<uint8_t>() { return GL_UNSIGNED_BYTE; }
+template<> constexpr GLenum glComponentType<int16_t>() { return GL_SHORT; }
+template<> constexpr GLenum glComponentType<uint16_t>() { return GL_UNSIGNED_SHORT; }
+
+// One attribute of a vertex format: Count components of type Component, optionally normalized to [0, 1] / [-1, 1]
+template<VertexSemantic Semantic, typename Component, GLint Count, bool Normalized = false>
+struct VertexAttrib {
+    using ComponentType = Component;
+    static constexpr VertexSemantic semantic = Semantic;
+    static constexpr GLuint location = (GLuint)Semantic;
+    static constexpr GLint components = Count;
+    static constexpr GLenum type = glComponentType<Component>();
+    static constexpr GLboolean normalized = Normalized ? GL_TRUE : GL_FALSE;
+    static constexpr size_t size = sizeof(Component) * Count;
+};
+
+// Runtime description of one attribute, for VAO setup and shader validation
+struct VertexAttribute {
+    GLuint location;
+    GLint components;
+    GLenum type;
+    GLboolean normalized;
+    size_t offset;
+};
+
+// Runtime view of a vertex format
+struct VertexLayout {
+    std::span<const VertexAttribute> attributes;
+    GLsizei stride = 0;
+    uint32_t derivedLocations = 0;  // Locations the shader reconstructs instead of reading (bitmask)
+    bool quantized = false;         // Positions are normalized to the mesh bounds (see VertexQuantization)
+
+    const VertexAttribute* find(GLuint location) const {
+        for (const auto& attribute : attributes) {
+            if (attribute.location == location) return &attribute;
+        }
+        return nullptr;
+    }
+};
+
+// Pointer to the Vertex member a float attribute is copied from
+inline const float* vertexField(const Vertex& vertex, VertexSemantic semantic) {
+    switch (semantic) {
+        case VertexSemantic::Position:  return &vertex.position.x;
+        case VertexSemantic::Color:     return &vertex.color.x;
+        case VertexSemantic::TexCoord:  return &vertex.texCoord.x;
+        case VertexSemantic::Normal:    return &vertex.normal.x;
+        case VertexSemantic::Tangent:   return &vertex.tangent.x;
+        case VertexSemantic::Bitangent: return &vertex.bitangent.x;
+    }
+    return &vertex.position.x;
+}
+
+// An interleaved vertex layout. Stride and offsets are computed at compile time from the attribute list, in order
+template<typename... Attribs>
+struct VertexFormat {
+    static constexpr size_t attributeCount = sizeof...(Attribs);
+    static constexpr GLsizei stride = (GLsizei)(Attribs::size + ...);
+    static constexpr std::array<VertexAttribute, sizeof...(Attribs)> attributes = [] {
+        std::array<VertexAttribute, sizeof...(Attribs)> result{};
+        size_t index = 0;
+        size_t offset = 0;
+        ((result[index++] = VertexAttribute{Attribs::location, Attribs::components, Attribs::type,
+                                            Attribs::normalized, offset},
+          offset += Attribs::size), ...);
+        return result;
+    }();
+    static constexpr uint32_t derivedLocations = 0;
+    static constexpr bool quantized = false;
+
+    // Interleave the attributes out of full vertices. Formats with non-float attributes provide their own encode
+    static std::vector<std::byte> encode(std::span<const Vertex> vertices, const VertexQuantization&) {
+        static_assert((std::is_same_v<typename Attribs::ComponentType, float> && ...),
+                      "Only float formats can be copied straight from Vertex");
+        static_assert(((Attribs::components <= (Attribs::semantic == VertexSemantic::TexCoord ? 2 : 3)) && ...),
+                      "Attribute has more components than its Vertex member");
+
+        std::vector<std::byte> data(vertices.size() * stride);
+        for (size_t v = 0; v < vertices.size(); ++v) {
+            std::byte* out = data.data() + v * stride;
+            size_t index = 0;
+            ((std::memcpy(out + attributes[index++].offset, vertexField(vertices[v], Attribs::semantic), Attribs::size)),
+             ...);
+        }
+        return data;
+    }
+};
+
+// Runtime layout of a format type
+template<typename Format>
+VertexLayout vertexLayout() {
+    return VertexLayout{Format::attributes, Format::stride, Format::derivedLocations, Format::quantized};
+}
+
+// Exactly the Vertex struct (68 bytes); uploads without repacking
+using FullVertexFormat = VertexFormat<
+    VertexAttrib<VertexSemantic::Position, float, 3>,
+    VertexAttrib<VertexSemantic::Color, float, 3>,
+    VertexAttrib<VertexSemantic::TexCoord, float, 2>,
+    VertexAttrib<VertexSemantic::Normal, float, 3>,
+    VertexAttrib<VertexSemantic::Tangent, float, 3>,
+    VertexAttrib<VertexSemantic::Bitangent, float, 3>>;
+static_assert(FullVertexFormat::stride == sizeof(Vertex), "FullVertexFormat must match Vertex");
+static_assert(FullVertexFormat::attributes[2].offset == offsetof(Vertex, texCoord), "FullVertexFormat must match Vertex");
+static_assert(FullVertexFormat::attributes[5].offset == offsetof(Vertex, bitangent), "FullVertexFormat must match Vertex");
+
+// Everything the G-buffer pass reads: Vertex without its color (56 bytes)
+using LitVertexFormat = VertexFormat<
+    VertexAttrib<VertexSemantic::Position, float, 3>,
+    VertexAttrib<VertexSemantic::TexCoord, float, 2>,
+    VertexAttrib<VertexSemantic::Normal, float, 3>,
+    VertexAttrib<VertexSemantic::Tangent, float, 3>,
+    VertexAttrib<VertexSemantic::Bitangent, float, 3>>;
+
+// Untextured meshes: no UVs and no tangent frame (24 bytes)
+using UntexturedVertexFormat = VertexFormat<
+    VertexAttrib<VertexSemantic::Position, float, 3>,
+    VertexAttrib<VertexSemantic::Normal, float, 3>>;
+
+// Depth-only passes (12 bytes)
+using PositionVertexFormat = VertexFormat<
+    VertexAttrib<VertexSemantic::Position, float, 3>>;
+
+// Check a linked program's vertex inputs against a layout: every input the shader reads must be provided (or
+// derived) with a float-compatible type. Layout attributes the shader doesn't read are reported as wasted bytes.
+// Problems are printed under the given label; returns false on a mismatch
+bool validateVertexLayout(GLuint program, const VertexLayout& layout, const std::string& label);
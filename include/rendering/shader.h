@@ -1,18 +1,76 @@
 #pragma once
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <optional>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Typed handle to a uniform by name. The name and type are interned into a small id when the handle is made
+// (once, as a static or a member), and each Shader resolves that id against its reflected uniforms on first use, so later
+// sets are an array lookup with no string building or hashing. A handle works with any Shader; uniforms a
+// program doesn't have (or has with another type) are ignored, like location -1
+template<typename T>
+struct Uniform {
+	explicit Uniform(const char* name);
+
+	int id;
+};
+
+// GL type a handle of each C++ type expects; int also matches samplers and bools
+template<typename T> constexpr GLenum uniformGLType = 0;
+template<> inline constexpr GLenum uniformGLType<bool> = GL_BOOL;
+template<> inline constexpr GLenum uniformGLType<int> = GL_INT;
+template<> inline constexpr GLenum uniformGLType<float> = GL_FLOAT;
+template<> inline constexpr GLenum uniformGLType<glm::ivec3> = GL_INT_VEC3;
+template<> inline constexpr GLenum uniformGLType<glm::vec2> = GL_FLOAT_VEC2;
+template<> inline constexpr GLenum uniformGLType<glm::vec3> = GL_FLOAT_VEC3;
+template<> inline constexpr GLenum uniformGLType<glm::vec4> = GL_FLOAT_VEC4;
+template<> inline constexpr GLenum uniformGLType<glm::mat2> = GL_FLOAT_MAT2;
+template<> inline constexpr GLenum uniformGLType<glm::mat3> = GL_FLOAT_MAT3;
+template<> inline constexpr GLenum uniformGLType<glm::mat4> = GL_FLOAT_MAT4;
 
 class Shader {
 
 	public:
-		Shader(const char* vertexPath, const char* fragmentPath);
+		// defines are inserted as "#define NAME" after the #version line of both stages, to build variants.
+		// Compiling and linking are only submitted here: errors are checked when the program is first used, so
+		// shaders made one after another are built by the driver in parallel
+		Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines = {});
 
 		GLuint id;
 
 		void use();
 		void destroy();
 
+		// Whether the program is built, without waiting for it. Only a driver with parallel compiling can tell
+		// while it's still building; otherwise this is always true and the first use waits
+		bool isReady() const;
+
+		// Let the driver compile and link on its own threads (GL_KHR_parallel_shader_compile) when it has the
+		// extension. Call once after loading GL, with the loader given to glad. False if it isn't supported
+		static bool enableParallelCompile(GLADloadproc getProcAddress);
+
+		// Set a uniform, or one element of a uniform array, on the bound program. Values the program already
+		// holds aren't uploaded again
+		template<typename T>
+		void set(const Uniform<T>& uniform, const std::type_identity_t<T>& value) const {
+			set(uniform, 0, value);
+		}
+
+		template<typename T>
+		void set(const Uniform<T>& uniform, int element, const std::type_identity_t<T>& value) const {
+			int slot = slotFor(uniform.id);
+			if (slot >= 0 && element >= 0 && element < uniforms[slot].arraySize) {
+				store(slot + element, value);
+			}
+		}
+
+		// By name ("lights[3]" for an array element), for setup code; per-frame code should use Uniform handles
 		void setBool(const std::string& name, bool value) const;
 		void setInt(const std::string& name, int value) const;
 		void setFloat(const std::string& name, float value) const;
@@ -23,4 +81,80 @@ class Shader {
 		void setMat3(const std::string& name, const glm::mat3& value) const;
 		void setMat4(const std::string& name, const glm::mat4& value) const;
 
-};
\ No newline at end of file
+		// Active uniforms found at link time, counting each array element
+		int getUniformCount() const {
+			finishBuild();
+			return (int)uniforms.size();
+		}
+
+		// Id of a uniform name and expected type, shared by every shader (see Uniform)
+		static int internUniform(const char* name, GLenum type);
+
+	private:
+		// An active uniform (or array element) and the value it was last given
+		struct UniformSlot {
+			GLint location = -1;
+			GLenum type = 0;
+			int arraySize = 1;  // Elements from this one to the end of its array
+			bool hasValue = false;
+			alignas(16) unsigned char value[sizeof(glm::mat4)];
+		};
+
+		// A build submitted to the driver whose result hasn't been checked yet
+		struct PendingBuild {
+			GLuint vertexShader = 0;
+			GLuint fragmentShader = 0;
+			uint64_t cacheKey = 0;
+			std::chrono::steady_clock::time_point submitted;
+			std::optional<std::chrono::steady_clock::time_point> built;  // When isReady() first saw it done
+		};
+
+		mutable std::vector<UniformSlot> uniforms;
+		mutable std::unordered_map<std::string, int> uniformsByName;  // Arrays by their name and by each element's
+		mutable std::vector<int> uniformsById;                        // Resolved Uniform ids
+		mutable std::optional<PendingBuild> pending;
+
+		// Wait for a pending build, report its errors, cache its binary and reflect its uniforms
+		void finishBuild() const;
+
+		// Read every active uniform of the linked program into the table
+		void reflectUniforms() const;
+
+		// Table index for an interned uniform, resolved (and type checked) on first use; -1 if there's none
+		int slotFor(int uniformId) const;
+
+		template<typename T>
+		void store(int slot, const T& value) const {
+			UniformSlot& uniform = uniforms[slot];
+			if (uniform.hasValue && std::memcmp(uniform.value, &value, sizeof(T)) == 0) {
+				return;
+			}
+			std::memcpy(uniform.value, &value, sizeof(T));
+			uniform.hasValue = true;
+			upload(uniform.location, value);
+		}
+
+		template<typename T>
+		void storeByName(const std::string& name, const T& value) const {
+			finishBuild();
+			auto found = uniformsByName.find(name);
+			if (found != uniformsByName.end()) {
+				store(found->second, value);
+			}
+		}
+
+		static void upload(GLint location, bool value);
+		static void upload(GLint location, int value);
+		static void upload(GLint location, float value);
+		static void upload(GLint location, const glm::ivec3& value);
+		static void upload(GLint location, const glm::vec2& value);
+		static void upload(GLint location, const glm::vec3& value);
+		static void upload(GLint location, const glm::vec4& value);
+		static void upload(GLint location, const glm::mat2& value);
+		static void upload(GLint location, const glm::mat3& value);
+		static void upload(GLint location, const glm::mat4& value);
+
+};
+
+template<typename T>
+Uniform<T>::Uniform(const char* name) : id(Shader::internUniform(name, uniformGLType<T>)) {}
@@ -0,0 +1,153 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Insert-only open-addressing hash map with linear probing.
+//
+// Keys and values live inline in one flat array, with a parallel array of one-byte control tags
+// (0 = empty, otherwise 0x80 | 7 hash bits). Probing walks the tag bytes and only compares keys on
+// a tag match, so a lookup usually touches one or two cache lines and inserts never allocate until
+// the table grows. Slots are indexed with Fibonacci hashing, which keeps weak hash functions from
+// clustering. Size it up front with the expected element count to avoid rehashing.
+template<typename Key, typename Value, typename Hash = std::hash<Key>, typename KeyEqual = std::equal_to<Key>>
+class FlatHashMap {
+public:
+    explicit FlatHashMap(size_t expectedSize = 0) {
+        reserve(expectedSize);
+    }
+
+    // Make room for expectedSize elements without rehashing
+    void reserve(size_t expectedSize) {
+        size_t needed = capacityFor(expectedSize);
+        if (needed > slots.size()) {
+            rehash(needed);
+        }
+    }
+
+    // Returns the value for key, or nullptr if it isn't present
+    Value* find(const Key& key) {
+        if (slots.empty()) return nullptr;
+        uint64_t h = scramble(key);
+        uint8_t tag = tagOf(h);
+        for (size_t i = indexOf(h);; i = (i + 1) & mask) {
+            if (controls[i] == 0) return nullptr;
+            if (controls[i] == tag && equal(slots[i].key, key)) return &slots[i].value;
+        }
+    }
+
+    const Value* find(const Key& key) const {
+        return const_cast<FlatHashMap*>(this)->find(key);
+    }
+
+    // Insert key -> value unless key is already present. Returns the stored value and whether it was inserted
+    std::pair<Value*, bool> tryEmplace(const Key& key, const Value& value) {
+        if ((count + 1) * maxLoadDenominator > slots.size() * maxLoadNumerator) {
+            rehash(slots.empty() ? minCapacity : slots.size() * 2);
+        }
+
+        uint64_t h = scramble(key);
+        uint8_t tag = tagOf(h);
+        for (size_t i = indexOf(h);; i = (i + 1) & mask) {
+            if (controls[i] == 0) {
+                controls[i] = tag;
+                slots[i].key = key;
+                slots[i].value = value;
+                ++count;
+                return {&slots[i].value, true};
+            }
+            if (controls[i] == tag && equal(slots[i].key, key)) {
+                return {&slots[i].value, false};
+            }
+        }
+    }
+
+    // Value for key, default-constructing it if missing
+    Value& operator[](const Key& key) {
+        return *tryEmplace(key, Value()).first;
+    }
+
+    // Visit every (key, value) pair in table order
+    template<typename Fn>
+    void forEach(Fn&& fn) const {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (controls[i] != 0) fn(slots[i].key, slots[i].value);
+        }
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return slots.size(); }
+
+    void clear() {
+        std::fill(controls.begin(), controls.end(), 0);
+        count = 0;
+    }
+
+    // Approximate heap usage of the table
+    size_t memoryBytes() const {
+        return slots.capacity() * sizeof(Slot) + controls.capacity();
+    }
+
+private:
+    struct Slot {
+        Key key;
+        Value value;
+    };
+
+    // Grow past 3/4 full to keep linear probe runs short
+    static constexpr size_t maxLoadNumerator = 3;
+    static constexpr size_t maxLoadDenominator = 4;
+    static constexpr size_t minCapacity = 16;
+
+    std::vector<uint8_t> controls;
+    std::vector<Slot> slots;
+    size_t count = 0;
+    size_t mask = 0;
+    unsigned shift = 64;
+    [[no_unique_address]] Hash hasher;
+    [[no_unique_address]] KeyEqual equal;
+
+    static size_t capacityFor(size_t expectedSize) {
+        size_t capacity = minCapacity;
+        while (capacity * maxLoadNumerator < expectedSize * maxLoadDenominator) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    uint64_t scramble(const Key& key) const {
+        return (uint64_t) hasher(key) * 0x9e3779b97f4a7c15ull;
+    }
+
+    size_t indexOf(uint64_t h) const {
+        return (size_t) (h >> shift);
+    }
+
+    static uint8_t tagOf(uint64_t h) {
+        return (uint8_t) (0x80 | (h & 0x7f));
+    }
+
+    void rehash(size_t newCapacity) {
+        std::vector<uint8_t> oldControls = std::move(controls);
+        std::vector<Slot> oldSlots = std::move(slots);
+
+        controls.assign(newCapacity, 0);
+        slots.resize(newCapacity);
+        mask = newCapacity - 1;
+        shift = 64;
+        for (size_t c = newCapacity; c > 1; c >>= 1) --shift;
+
+        for (size_t i = 0; i < oldSlots.size(); ++i) {
+            if (oldControls[i] == 0) continue;
+            uint64_t h = scramble(oldSlots[i].key);
+            size_t j = indexOf(h);
+            while (controls[j] != 0) j = (j + 1) & mask;
+            controls[j] = tagOf(h);
+            slots[j] = std::move(oldSlots[i]);
+        }
+    }
+};
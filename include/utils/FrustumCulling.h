@@ -68,6 +68,13 @@ public:
     
     // Get the size of the bounding box
     glm::vec3 getSize() const;
+
+    // Get the corners the box spans
+    glm::vec3 getMin() const { return min; }
+    glm::vec3 getMax() const { return max; }
+
+    // Check if the box contains anything
+    bool isValid() const { return valid; }
     
     // Get the radius of the bounding sphere that contains this box
     float getBoundingSphereRadius() const;
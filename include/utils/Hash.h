@@ -0,0 +1,43 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Finalizer from MurmurHash3: spreads every input bit across the whole 64-bit result
+inline uint64_t mixHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// Fast 64-bit hash of a byte range (FNV-1a over 8-byte words, then mixed). Not cryptographic;
+// used for content fingerprints and cache keys
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull) {
+    constexpr uint64_t prime = 0x100000001b3ull;
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t h = seed ^ (size * prime);
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, 8);
+        h = (h ^ word) * prime;
+    }
+    for (; i < size; ++i) {
+        h = (h ^ bytes[i]) * prime;
+    }
+    return mixHash(h);
+}
+
+inline uint64_t hashString(std::string_view text, uint64_t seed = 0xcbf29ce484222325ull) {
+    return hashBytes(text.data(), text.size(), seed);
+}
+
+// Combine two hashes into one (order-dependent)
+inline uint64_t hashCombine(uint64_t seed, uint64_t value) {
+    return mixHash(seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2)));
+}
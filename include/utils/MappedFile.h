@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of an entire file
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    // Move-only: the mapping is released exactly once
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map a file, replacing any current mapping. Returns false if it can't be opened
+    bool open(const std::string& path);
+
+    // Unmap the file
+    void close();
+
+    // Check if a file is mapped (an empty file is open but has no data)
+    bool isOpen() const { return opened; }
+
+    // Access to the mapped bytes
+    const char* data() const { return bytes; }
+    const char* begin() const { return bytes; }
+    const char* end() const { return bytes + length; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+    bool opened = false;
+};
@@ -0,0 +1,58 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Number of worker threads to use when the caller doesn't ask for a specific count
+inline unsigned defaultThreadCount() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+// Run fn(taskIndex) for every task in [0, taskCount) on up to threadCount threads (0 = all cores).
+// The calling thread takes part, tasks are handed out dynamically, and the first exception thrown
+// by any task is rethrown once every thread has finished.
+template<typename Fn>
+void parallelFor(size_t taskCount, Fn&& fn, unsigned threadCount = 0) {
+    if (taskCount == 0) return;
+    if (threadCount == 0) threadCount = defaultThreadCount();
+    size_t workerCount = std::min<size_t>(threadCount, taskCount);
+
+    if (workerCount <= 1) {
+        for (size_t task = 0; task < taskCount; ++task) {
+            fn(task);
+        }
+        return;
+    }
+
+    std::atomic<size_t> nextTask{0};
+    std::exception_ptr firstError;
+    std::mutex errorMutex;
+
+    auto worker = [&]() {
+        for (size_t task = nextTask++; task < taskCount; task = nextTask++) {
+            try {
+                fn(task);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!firstError) firstError = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(workerCount - 1);
+    for (size_t i = 1; i < workerCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (firstError) std::rethrow_exception(firstError);
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cmath>
+#include <glm/glm.hpp>
+
+// Four-wide float vector using GCC/clang vector extensions, so arithmetic compiles to single SSE/NEON
+// instructions on every platform we build for. Three-component helpers keep lane 3 at zero.
+typedef float simd4f __attribute__((vector_size(16)));
+
+inline simd4f simdSplat(float s) {
+    return simd4f{s, s, s, s};
+}
+
+inline simd4f simdLoad3(const glm::vec3& v) {
+    return simd4f{v.x, v.y, v.z, 0.0f};
+}
+
+inline glm::vec3 simdStore3(simd4f v) {
+    return glm::vec3(v[0], v[1], v[2]);
+}
+
+// The y and z products are broadcast by two independent shuffles and added to x: (x + y) + z, like the scalar sum
+inline float simdDot3(simd4f a, simd4f b) {
+    simd4f p = a * b;
+    simd4f y = __builtin_shufflevector(p, p, 1, 1, 1, 1);
+    simd4f z = __builtin_shufflevector(p, p, 2, 2, 2, 2);
+    return (p + y + z)[0];
+}
+
+// One shuffle per operand and one for the result: a * b.yzx - a.yzx * b is the cross product rotated by one lane
+inline simd4f simdCross3(simd4f a, simd4f b) {
+    simd4f aYZX = __builtin_shufflevector(a, a, 1, 2, 0, 3);
+    simd4f bYZX = __builtin_shufflevector(b, b, 1, 2, 0, 3);
+    simd4f c = a * bYZX - aYZX * b;
+    return __builtin_shufflevector(c, c, 1, 2, 0, 3);
+}
+
+// Unit-length v, or fallback when v is (nearly) zero
+inline simd4f simdNormalize3(simd4f v, simd4f fallback) {
+    float lengthSquared = simdDot3(v, v);
+    return lengthSquared > 1e-24f ? v * simdSplat(1.0f / std::sqrt(lengthSquared)) : fallback;
+}
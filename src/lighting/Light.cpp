@@ -1,5 +1,28 @@
 #include "lighting/Light.h"
+#include "lighting/LightManager.h"
 
-Light::Light(const glm::vec3& pos, const glm::vec3& col, float intens, const std::string& lightName)
-    : position(pos), color(col), intensity(intens), name(lightName), isActive(true) {
-} 
\ No newline at end of file
+Light::Light(LightType lightType, const glm::vec3& pos, const glm::vec3& col, float intens,
+             const std::string& lightName)
+    : position(pos), color(col), intensity(intens), name(lightName), isActive(true), type(lightType) {
+}
+
+Light::~Light() {
+    if (manager) {
+        manager->remove(*this);
+    }
+}
+
+void Light::changed() {
+    if (manager) {
+        manager->update(*this);
+    }
+}
+
+std::string Light::getLightType() const {
+    switch (type) {
+        case LightType::Point: return "PointLight";
+        case LightType::Spot: return "SpotLight";
+        case LightType::Directional: return "DirectionalLight";
+    }
+    return "Light";
+}
@@ -0,0 +1,209 @@
+#include "lighting/LightClusters.h"
+#include "lighting/LightManager.h"
+#include "rendering/shader.h"
+#include "utils/Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+    // Below this many lights the assignment runs on the calling thread; starting workers would cost more
+    constexpr size_t parallelLightThreshold = 256;
+
+    // Lights per range-computation task
+    constexpr size_t lightsPerTask = 256;
+
+    const Uniform<int> clusterTableUniform("clusterTable");
+    const Uniform<int> clusterLightIndicesUniform("clusterLightIndices");
+    const Uniform<glm::ivec3> clusterGridUniform("clusterGrid");
+    const Uniform<glm::vec2> clusterTileSizeUniform("clusterTileSize");
+    const Uniform<float> clusterSliceScaleUniform("clusterSliceScale");
+    const Uniform<float> clusterSliceBiasUniform("clusterSliceBias");
+    const Uniform<glm::mat4> viewUniform("view");
+
+    // Tile of an NDC coordinate, for tiles tiles across [-1, 1]
+    int tileOf(float ndc, int tiles) {
+        return std::clamp((int)std::floor((ndc * 0.5f + 0.5f) * tiles), 0, tiles - 1);
+    }
+}
+
+LightClusters::LightClusters(int tilesX, int tilesY, int slices) : grid(tilesX, tilesY, slices) {
+    table.resize((size_t)grid.x * grid.y * grid.z);
+}
+
+void LightClusters::computeRanges(const std::vector<glm::vec4>& bounds, size_t count,
+                                  std::vector<ClusterRange>& ranges, unsigned threadCount) const {
+    ranges.resize(count);
+    float nearPlane = sliceDepths.front();
+    float farPlane = sliceDepths.back();
+
+    parallelFor((count + lightsPerTask - 1) / lightsPerTask, [&](size_t task) {
+        size_t end = std::min(count, (task + 1) * lightsPerTask);
+        for (size_t i = task * lightsPerTask; i < end; ++i) {
+            ClusterRange& range = ranges[i];
+            range = {};
+            range.center = glm::vec3(view * glm::vec4(glm::vec3(bounds[i]), 1.0f));
+            range.radius = bounds[i].w;
+
+            // Depth range, as distance in front of the camera
+            float nearest = -range.center.z - range.radius;
+            float farthest = -range.center.z + range.radius;
+            if (range.radius <= 0.0f || farthest < nearPlane || nearest > farPlane) {
+                continue;
+            }
+            range.z0 = std::clamp((int)std::floor(std::log(std::max(nearest, nearPlane)) * sliceScale + sliceBias),
+                                  0, grid.z - 1);
+            range.z1 = std::clamp((int)std::floor(std::log(std::min(farthest, farPlane)) * sliceScale + sliceBias),
+                                  0, grid.z - 1) + 1;
+        }
+    }, threadCount);
+}
+
+bool LightClusters::tilesInSlice(const ClusterRange& range, int slice, TileRect& rect) const {
+    // The part of the sphere between the slice's depths, bounded by a box as wide as its widest cross-section
+    float depth = -range.center.z;
+    float sliceNear = std::max(sliceDepths[slice], depth - range.radius);
+    float sliceFar = std::min(sliceDepths[slice + 1], depth + range.radius);
+    float offset = depth < sliceNear ? sliceNear - depth : (depth > sliceFar ? depth - sliceFar : 0.0f);
+    float halfWidth = std::sqrt(std::max(range.radius * range.radius - offset * offset, 0.0f));
+
+    // x / depth is smallest at the box's near face when x is negative and at its far face otherwise
+    float minX = range.center.x - halfWidth, maxX = range.center.x + halfWidth;
+    float minY = range.center.y - halfWidth, maxY = range.center.y + halfWidth;
+    float ndcMinX = projectionScale.x * minX / (minX < 0.0f ? sliceNear : sliceFar);
+    float ndcMaxX = projectionScale.x * maxX / (maxX > 0.0f ? sliceNear : sliceFar);
+    float ndcMinY = projectionScale.y * minY / (minY < 0.0f ? sliceNear : sliceFar);
+    float ndcMaxY = projectionScale.y * maxY / (maxY > 0.0f ? sliceNear : sliceFar);
+    if (ndcMaxX < -1.0f || ndcMinX > 1.0f || ndcMaxY < -1.0f || ndcMinY > 1.0f) {
+        return false;
+    }
+    rect.x0 = tileOf(ndcMinX, grid.x);
+    rect.x1 = tileOf(ndcMaxX, grid.x) + 1;
+    rect.y0 = tileOf(ndcMinY, grid.y);
+    rect.y1 = tileOf(ndcMaxY, grid.y) + 1;
+    return true;
+}
+
+void LightClusters::build(const LightManager& lights, const glm::mat4& view, const glm::mat4& projection,
+                          float nearPlane, float farPlane, int viewportWidth, int viewportHeight) {
+    auto start = std::chrono::steady_clock::now();
+    this->view = view;
+    projectionScale = glm::vec2(projection[0][0], projection[1][1]);
+    tileSize = glm::vec2((float)viewportWidth / grid.x, (float)viewportHeight / grid.y);
+    sliceScale = grid.z / std::log(farPlane / nearPlane);
+    sliceBias = -grid.z * std::log(nearPlane) / std::log(farPlane / nearPlane);
+    sliceDepths.resize(grid.z + 1);
+    for (int slice = 0; slice <= grid.z; ++slice) {
+        sliceDepths[slice] = nearPlane * std::pow(farPlane / nearPlane, (float)slice / grid.z);
+    }
+
+    // Only the shaded lights: the rest are culled or faded out
+    size_t pointCount = lights.getShadedCount(LightType::Point);
+    size_t spotCount = lights.getShadedCount(LightType::Spot);
+    unsigned threadCount = pointCount + spotCount < parallelLightThreshold ? 1 : 0;
+    computeRanges(lights.getBounds(LightType::Point), pointCount, pointRanges, threadCount);
+    computeRanges(lights.getBounds(LightType::Spot), spotCount, spotRanges, threadCount);
+
+    auto forEachCluster = [&](const ClusterRange& range, int slice, auto&& fn) {
+        TileRect rect;
+        if (slice < range.z0 || slice >= range.z1 || !tilesInSlice(range, slice, rect)) {
+            return;
+        }
+        for (int y = rect.y0; y < rect.y1; ++y) {
+            for (int x = rect.x0; x < rect.x1; ++x) {
+                fn(clusterIndex(x, y, slice));
+            }
+        }
+    };
+
+    // Count each cluster's lights, a depth slice per task: slices don't share clusters, so tasks never write
+    // to the same entry
+    parallelFor((size_t)grid.z, [&](size_t slice) {
+        for (int i = clusterIndex(0, 0, (int)slice), end = clusterIndex(0, 0, (int)slice + 1); i < end; ++i) {
+            table[i] = glm::uvec4(0);
+        }
+        for (const ClusterRange& range : pointRanges) {
+            forEachCluster(range, (int)slice, [&](int cluster) { ++table[cluster].y; });
+        }
+        for (const ClusterRange& range : spotRanges) {
+            forEachCluster(range, (int)slice, [&](int cluster) { ++table[cluster].z; });
+        }
+    }, threadCount);
+
+    uint32_t total = 0;
+    stats.maxClusterLights = 0;
+    for (glm::uvec4& cluster : table) {
+        cluster.x = total;
+        total += cluster.y + cluster.z;
+        stats.maxClusterLights = std::max(stats.maxClusterLights, (int)(cluster.y + cluster.z));
+    }
+    indices.resize(total);
+
+    // Fill the lists: each cluster's point lights, then its spotlights, in slot order
+    parallelFor((size_t)grid.z, [&](size_t slice) {
+        int first = clusterIndex(0, 0, (int)slice);
+        std::vector<uint32_t> cursors(clusterIndex(0, 0, (int)slice + 1) - first);
+        for (size_t i = 0; i < cursors.size(); ++i) {
+            cursors[i] = table[first + i].x;
+        }
+        for (uint32_t light = 0; light < (uint32_t)pointRanges.size(); ++light) {
+            forEachCluster(pointRanges[light], (int)slice,
+                           [&](int cluster) { indices[cursors[cluster - first]++] = light; });
+        }
+        for (uint32_t light = 0; light < (uint32_t)spotRanges.size(); ++light) {
+            forEachCluster(spotRanges[light], (int)slice,
+                           [&](int cluster) { indices[cursors[cluster - first]++] = light; });
+        }
+    }, threadCount);
+
+    upload();
+    stats.clusters = (int)table.size();
+    stats.lightIndices = indices.size();
+    stats.buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void LightClusters::upload() {
+    if (tableBuffer == 0) {
+        glGenBuffers(1, &tableBuffer);
+        glGenTextures(1, &tableTexture);
+        glGenBuffers(1, &indexBuffer);
+        glGenTextures(1, &indexTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, tableTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32UI, tableBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_R32UI, indexBuffer);
+    }
+
+    // Whole lists every frame, into fresh storage so the driver doesn't wait for last frame's draw
+    glBindBuffer(GL_TEXTURE_BUFFER, tableBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, table.size() * sizeof(glm::uvec4), table.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, indexBuffer);
+    // An empty buffer can't back a texture; keep at least one index
+    glBufferData(GL_TEXTURE_BUFFER, std::max<size_t>(indices.size(), 1) * sizeof(uint32_t),
+                 indices.empty() ? nullptr : indices.data(), GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightClusters::bind(const Shader& shader, int firstUnit) const {
+    glActiveTexture(GL_TEXTURE0 + firstUnit);
+    glBindTexture(GL_TEXTURE_BUFFER, tableTexture);
+    glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+    glBindTexture(GL_TEXTURE_BUFFER, indexTexture);
+    shader.set(clusterTableUniform, firstUnit);
+    shader.set(clusterLightIndicesUniform, firstUnit + 1);
+    shader.set(clusterGridUniform, grid);
+    shader.set(clusterTileSizeUniform, tileSize);
+    shader.set(clusterSliceScaleUniform, sliceScale);
+    shader.set(clusterSliceBiasUniform, sliceBias);
+    shader.set(viewUniform, view);
+}
+
+void LightClusters::destroy() {
+    if (tableBuffer) {
+        glDeleteTextures(1, &tableTexture);
+        glDeleteBuffers(1, &tableBuffer);
+        glDeleteTextures(1, &indexTexture);
+        glDeleteBuffers(1, &indexBuffer);
+    }
+    tableBuffer = tableTexture = indexBuffer = indexTexture = 0;
+}
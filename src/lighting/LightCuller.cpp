@@ -0,0 +1,110 @@
+#include "lighting/LightCuller.h"
+#include "lighting/LightManager.h"
+#include "lighting/SpotLight.h"
+#include "rendering/LODSelector.h"
+#include "utils/FrustumCulling.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+    // Sphere around the part of a spotlight's influence sphere inside its outer cone
+    glm::vec4 spotBounds(const SpotLight& spot, float radius) {
+        float cosOuter = std::clamp(spot.getOuterCutoff(), -1.0f, 1.0f);
+        if (cosOuter <= 0.0f) {
+            return glm::vec4(spot.getPosition(), radius);  // More than a hemisphere
+        }
+        float sinOuter = std::sqrt(1.0f - cosOuter * cosOuter);
+        glm::vec3 direction = glm::normalize(spot.getDirection());
+        // Wide cones: the circle at the end of the cone bounds it. Narrow ones: the sphere through the apex
+        // and that circle
+        if (cosOuter < 0.70710678f) {
+            return glm::vec4(spot.getPosition() + direction * (radius * cosOuter), radius * sinOuter);
+        }
+        float halfLength = radius / (2.0f * cosOuter);
+        return glm::vec4(spot.getPosition() + direction * halfLength, halfLength);
+    }
+}
+
+LightCuller::LightCuller(int budget, float fadeSeconds, float hysteresis)
+    : budget(budget), fadeSeconds(fadeSeconds), hysteresis(hysteresis) {
+}
+
+void LightCuller::cull(LightManager& lights, const Frustum& frustum, const glm::vec3& cameraPosition, float fovY,
+                       float viewportHeight, float deltaTime) {
+    auto start = std::chrono::steady_clock::now();
+    stats = {};
+    candidates.clear();
+
+    const LightType types[2] = {LightType::Point, LightType::Spot};
+    for (int t = 0; t < 2; ++t) {
+        LightType type = types[t];
+        const std::vector<glm::vec4>& bounds = lights.getBounds(type);
+        int count = (int)bounds.size();
+        stats.considered += count;
+        targets[t].assign(count, enabled ? 0.0f : 1.0f);
+        fades[t].resize(count);
+        for (int slot = 0; slot < count; ++slot) {
+            fades[t][slot] = lights.getFade(type, slot);
+        }
+        if (!enabled) {
+            continue;
+        }
+
+        for (int slot = 0; slot < count; ++slot) {
+            const Light& light = lights.getLight(type, slot);
+            glm::vec4 sphere = bounds[slot];
+            if (type == LightType::Spot) {
+                sphere = spotBounds(static_cast<const SpotLight&>(light), sphere.w);
+            }
+            if (!light.getIsActive() || sphere.w <= 0.0f || !frustum.isSphereInside(glm::vec3(sphere), sphere.w)) {
+                fades[t][slot] = 0.0f;  // Nothing on screen to pop
+                ++stats.frustumCulled;
+                continue;
+            }
+
+            glm::vec3 color = LightManager::shadedColor(light);  // What the lighting shades, so the ranking agrees
+            float brightness = std::max(color.r, std::max(color.g, color.b));
+            float coverage = std::min(LODSelector::projectedDiameter(glm::vec3(sphere), sphere.w, cameraPosition,
+                                                                     fovY, viewportHeight) / viewportHeight, 1.0f);
+            float importance = brightness * coverage * coverage;
+            if (fades[t][slot] > 0.0f) {
+                importance *= 1.0f + hysteresis;
+            }
+            candidates.push_back({type, slot, importance});
+        }
+    }
+
+    // The most important `budget` lights head for full strength, the others for zero
+    if (enabled) {
+        size_t kept = std::min(candidates.size(), (size_t)std::max(budget, 0));
+        std::nth_element(candidates.begin(), candidates.begin() + kept, candidates.end(),
+                         [](const Candidate& a, const Candidate& b) { return a.importance > b.importance; });
+        for (size_t i = 0; i < kept; ++i) {
+            targets[candidates[i].type == LightType::Spot][candidates[i].slot] = 1.0f;
+        }
+        stats.budgetDropped = (int)(candidates.size() - kept);
+    }
+
+    float step = fadeSeconds > 0.0f ? deltaTime / fadeSeconds : 1.0f;
+    for (int t = 0; t < 2; ++t) {
+        for (size_t slot = 0; slot < fades[t].size(); ++slot) {
+            float& fade = fades[t][slot];
+            float target = targets[t][slot];
+            if (!enabled) {
+                fade = 1.0f;
+            } else if (fade < target) {
+                fade = std::min(fade + step, target);
+            } else {
+                fade = std::max(fade - step, target);
+            }
+            if (fade > 0.0f) {
+                ++stats.shaded;
+                stats.fading += fade < 1.0f;
+            }
+        }
+        lights.setFades(types[t], fades[t]);
+    }
+
+    stats.cullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
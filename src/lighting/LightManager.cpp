@@ -0,0 +1,260 @@
+#include "lighting/LightManager.h"
+#include "lighting/DirectionalLight.h"
+#include "lighting/PointLight.h"
+#include "lighting/SpotLight.h"
+#include "rendering/shader.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Slots allocated for a type the first time it's uploaded; grown by doubling
+    constexpr int initialCapacity = 64;
+
+    struct LightUniforms {
+        Uniform<int> buffer;
+        Uniform<int> count;
+        Uniform<int> stride;
+    };
+
+    const LightUniforms lightUniforms[3] = {
+        {Uniform<int>("pointLights"), Uniform<int>("pointLightCount"), Uniform<int>("pointLightStride")},
+        {Uniform<int>("spotLights"), Uniform<int>("spotLightCount"), Uniform<int>("spotLightStride")},
+        {Uniform<int>("dirLights"), Uniform<int>("dirLightCount"), Uniform<int>("dirLightStride")},
+    };
+}
+
+void LightManager::LightArrays::markDirty(int slot) {
+    if (dirtyBegin == dirtyEnd) {
+        dirtyBegin = slot;
+        dirtyEnd = slot + 1;
+    } else {
+        dirtyBegin = std::min(dirtyBegin, slot);
+        dirtyEnd = std::max(dirtyEnd, slot + 1);
+    }
+}
+
+LightManager::LightManager() {
+    // Point: position + radius, color. Spot: position + radius, direction + outer cutoff, color + inner cutoff.
+    // Directional: direction, color
+    lights[(int)LightType::Point].streamCount = 2;
+    lights[(int)LightType::Spot].streamCount = 3;
+    lights[(int)LightType::Directional].streamCount = 2;
+}
+
+LightManager::~LightManager() {
+    // Lights that outlive the manager stop reporting to it
+    for (LightArrays& arrays : lights) {
+        for (Light* light : arrays.owners) {
+            light->manager = nullptr;
+            light->slot = -1;
+        }
+    }
+}
+
+void LightManager::add(Light& light) {
+    if (light.manager == this) {
+        return;
+    }
+    if (light.manager) {
+        light.manager->remove(light);
+    }
+
+    LightArrays& arrays = lights[(int)light.type];
+    light.manager = this;
+    light.slot = arrays.count();
+    arrays.owners.push_back(&light);
+    arrays.fades.push_back(1.0f);
+    for (int stream = 0; stream < arrays.streamCount; ++stream) {
+        arrays.streams[stream].emplace_back(0.0f);
+    }
+    write(arrays, light.slot);
+    arrays.markDirty(light.slot);
+
+    // Shaded from the start: move it up to the end of the shaded slots
+    swapSlots(arrays, light.slot, arrays.shaded);
+    ++arrays.shaded;
+}
+
+void LightManager::remove(Light& light) {
+    if (light.manager != this) {
+        return;
+    }
+
+    // The last shaded light takes a freed shaded slot and the last light the slot it left, so both the
+    // shaded slots and the arrays stay packed
+    LightArrays& arrays = lights[(int)light.type];
+    int slot = light.slot;
+    if (slot < arrays.shaded) {
+        --arrays.shaded;
+        swapSlots(arrays, slot, arrays.shaded);
+        slot = arrays.shaded;
+    }
+    swapSlots(arrays, slot, arrays.count() - 1);
+    arrays.owners.pop_back();
+    arrays.fades.pop_back();
+    for (int stream = 0; stream < arrays.streamCount; ++stream) {
+        arrays.streams[stream].pop_back();
+    }
+    arrays.dirtyEnd = std::min(arrays.dirtyEnd, arrays.count());
+    arrays.dirtyBegin = std::min(arrays.dirtyBegin, arrays.dirtyEnd);
+
+    light.manager = nullptr;
+    light.slot = -1;
+}
+
+void LightManager::update(const Light& light) {
+    if (light.manager != this) {
+        return;
+    }
+    LightArrays& arrays = lights[(int)light.type];
+    write(arrays, light.slot);
+    arrays.markDirty(light.slot);
+}
+
+void LightManager::swapSlots(LightArrays& arrays, int a, int b) {
+    if (a == b) {
+        return;
+    }
+    std::swap(arrays.owners[a], arrays.owners[b]);
+    std::swap(arrays.fades[a], arrays.fades[b]);
+    for (int stream = 0; stream < arrays.streamCount; ++stream) {
+        std::swap(arrays.streams[stream][a], arrays.streams[stream][b]);
+    }
+    arrays.owners[a]->slot = a;
+    arrays.owners[b]->slot = b;
+    arrays.markDirty(a);
+    arrays.markDirty(b);
+}
+
+void LightManager::setFades(LightType type, const std::vector<float>& fades) {
+    LightArrays& arrays = lights[(int)type];
+    for (int slot = 0; slot < arrays.count() && slot < (int)fades.size(); ++slot) {
+        float fade = std::clamp(fades[slot], 0.0f, 1.0f);
+        if (fade != arrays.fades[slot]) {
+            arrays.fades[slot] = fade;
+            write(arrays, slot);
+            arrays.markDirty(slot);
+        }
+    }
+
+    // Faded-in lights to the front, the rest behind them
+    int shaded = 0;
+    for (int slot = 0; slot < arrays.count(); ++slot) {
+        if (arrays.fades[slot] > 0.0f) {
+            swapSlots(arrays, slot, shaded++);
+        }
+    }
+    arrays.shaded = shaded;
+}
+
+void LightManager::write(LightArrays& arrays, int slot) {
+    const Light& light = *arrays.owners[slot];
+    glm::vec3 color = shadedColor(light);
+    float fade = arrays.fades[slot];
+
+    switch (light.type) {
+        case LightType::Point: {
+            const auto& point = static_cast<const PointLight&>(light);
+            float radius = influenceRadius(color);
+            arrays.streams[0][slot] = glm::vec4(point.getPosition(), radius);
+            arrays.streams[1][slot] = glm::vec4(color * fade, 0.0f);
+            break;
+        }
+        case LightType::Spot: {
+            const auto& spot = static_cast<const SpotLight&>(light);
+            float radius = influenceRadius(color);
+            arrays.streams[0][slot] = glm::vec4(spot.getPosition(), radius);
+            arrays.streams[1][slot] = glm::vec4(spot.getDirection(), spot.getOuterCutoff());
+            arrays.streams[2][slot] = glm::vec4(color * fade, spot.getInnerCutoff());
+            break;
+        }
+        case LightType::Directional: {
+            const auto& directional = static_cast<const DirectionalLight&>(light);
+            arrays.streams[0][slot] = glm::vec4(directional.getDirection(), 0.0f);
+            arrays.streams[1][slot] = glm::vec4(color * fade, 0.0f);
+            break;
+        }
+    }
+}
+
+glm::vec3 LightManager::shadedColor(const Light& light) {
+    // Inactive lights stay in their slot but add nothing (and reach nowhere)
+    return light.isActive ? light.color : glm::vec3(0.0f);
+}
+
+float LightManager::influenceRadius(const glm::vec3& color) {
+    float brightest = std::max(color.r, std::max(color.g, color.b));
+    if (brightest <= 0.0f) {
+        return 0.0f;
+    }
+    // Solve brightest / d^2 = 5 / 256
+    return std::sqrt(brightest * 256.0f / 5.0f);
+}
+
+void LightManager::upload() {
+    stats.lights = 0;
+    stats.bytesUploaded = 0;
+    stats.lightsUploaded = 0;
+
+    for (LightArrays& arrays : lights) {
+        stats.lights += arrays.count();
+
+        if (arrays.texture == 0 || arrays.count() > arrays.capacity) {
+            // Reallocate and send everything
+            int capacity = std::max(arrays.capacity, initialCapacity);
+            while (capacity < arrays.count()) {
+                capacity *= 2;
+            }
+            if (arrays.buffer == 0) {
+                glGenBuffers(1, &arrays.buffer);
+                glGenTextures(1, &arrays.texture);
+            }
+            glBindBuffer(GL_TEXTURE_BUFFER, arrays.buffer);
+            glBufferData(GL_TEXTURE_BUFFER, (GLsizeiptr)arrays.streamCount * capacity * sizeof(glm::vec4), nullptr,
+                         GL_DYNAMIC_DRAW);
+            glBindTexture(GL_TEXTURE_BUFFER, arrays.texture);
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, arrays.buffer);
+            arrays.capacity = capacity;
+            arrays.dirtyBegin = 0;
+            arrays.dirtyEnd = arrays.count();
+        }
+
+        if (arrays.dirtyBegin == arrays.dirtyEnd) {
+            continue;
+        }
+        glBindBuffer(GL_TEXTURE_BUFFER, arrays.buffer);
+        size_t rangeBytes = (size_t)(arrays.dirtyEnd - arrays.dirtyBegin) * sizeof(glm::vec4);
+        for (int stream = 0; stream < arrays.streamCount; ++stream) {
+            GLintptr offset = ((GLintptr)stream * arrays.capacity + arrays.dirtyBegin) * sizeof(glm::vec4);
+            glBufferSubData(GL_TEXTURE_BUFFER, offset, (GLsizeiptr)rangeBytes,
+                            &arrays.streams[stream][arrays.dirtyBegin]);
+            stats.bytesUploaded += rangeBytes;
+        }
+        stats.lightsUploaded += arrays.dirtyEnd - arrays.dirtyBegin;
+        arrays.dirtyBegin = arrays.dirtyEnd = 0;
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void LightManager::bind(const Shader& shader, int firstUnit) const {
+    for (int type = 0; type < 3; ++type) {
+        const LightArrays& arrays = lights[type];
+        glActiveTexture(GL_TEXTURE0 + firstUnit + type);
+        glBindTexture(GL_TEXTURE_BUFFER, arrays.texture);
+        shader.set(lightUniforms[type].buffer, firstUnit + type);
+        shader.set(lightUniforms[type].count, arrays.shaded);
+        shader.set(lightUniforms[type].stride, arrays.capacity);
+    }
+}
+
+void LightManager::destroy() {
+    for (LightArrays& arrays : lights) {
+        if (arrays.texture) {
+            glDeleteTextures(1, &arrays.texture);
+            glDeleteBuffers(1, &arrays.buffer);
+        }
+        arrays.texture = 0;
+        arrays.buffer = 0;
+        arrays.capacity = 0;
+    }
+}
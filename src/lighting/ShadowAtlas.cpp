@@ -0,0 +1,493 @@
+#include "lighting/ShadowAtlas.h"
+#include "lighting/DirectionalLight.h"
+#include "lighting/LightManager.h"
+#include "lighting/SpotLight.h"
+#include "rendering/LODSelector.h"
+#include "rendering/Mesh.h"
+#include "rendering/shader.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace {
+    // Smallest tile; the atlas is allocated in cells of this size
+    constexpr int minTileSize = 128;
+
+    // Largest spotlight tile
+    constexpr int maxSpotTileSize = 1024;
+
+    // Cascades cover their slice's sphere this much wider, so the camera can move a while before a refit
+    constexpr float cascadeSlack = 1.25f;
+
+    // Split between uniform (0) and logarithmic (1) cascade distances
+    constexpr float cascadeSplitLambda = 0.75f;
+
+    // Casters up to this far towards the light from a cascade can still shadow it when they move
+    constexpr float cascadeCasterReach = 1000.0f;
+
+    constexpr float spotNearPlane = 0.05f;
+
+    // Spotlights wider than this are shadowed over this cone only
+    const float minSpotCosine = std::cos(glm::radians(80.0f));
+
+    const Uniform<glm::mat4> modelUniform("model");
+    const Uniform<glm::mat4> lightViewProjectionUniform("lightViewProjection");
+    const Uniform<int> shadowAtlasUniform("shadowAtlas");
+    const Uniform<int> cascadeCountUniform("cascadeCount");
+    const Uniform<glm::mat4> cascadeMatricesUniform("cascadeMatrices");
+    const Uniform<glm::vec4> cascadeRectsUniform("cascadeRects");
+    const Uniform<float> cascadeTexelSizesUniform("cascadeTexelSizes");
+    const Uniform<int> spotShadowsUniform("spotShadows");
+
+    // Texels per spotlight slot in the spot shadow buffer: tile, then the matrix's four columns
+    constexpr int spotShadowTexels = 5;
+
+    // Clip space to [0, 1] in x, y and depth
+    const glm::mat4 clipToTexture = glm::translate(glm::mat4(1.0f), glm::vec3(0.5f)) *
+                                    glm::scale(glm::mat4(1.0f), glm::vec3(0.5f));
+
+    glm::vec3 upFor(const glm::vec3& direction) {
+        return std::abs(direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+
+    int nextPowerOfTwo(float value) {
+        int size = 1;
+        while (size < value && size < (1 << 30)) {
+            size <<= 1;
+        }
+        return size;
+    }
+}
+
+ShadowAtlas::ShadowAtlas(int size, int cascadeCount, float shadowDistance, int updateBudget)
+    : size(std::max(size, minTileSize)), cascadeCount(std::clamp(cascadeCount, 0, maxCascades)),
+      shadowDistance(shadowDistance), updateBudget(updateBudget) {
+    cellsAcross = this->size / minTileSize;
+    cells.assign((size_t)cellsAcross * cellsAcross, 0);
+    cascades.resize(this->cascadeCount);
+}
+
+ShadowAtlas::~ShadowAtlas() {
+    destroy();
+}
+
+bool ShadowAtlas::initialize() {
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+    // Depth comparison in the sampler, and bilinear filtering of its results (2x2 PCF per tap)
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, texture, 0);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        std::cerr << "Shadow atlas framebuffer not complete!" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool ShadowAtlas::allocate(Tile& tile, int tileSize) {
+    for (int tileCells = std::min(tileSize, size) / minTileSize; tileCells >= 1; tileCells /= 2) {
+        // Tiles sit on multiples of their own size, so freed tiles leave holes the same sizes fit back into
+        for (int y = 0; y + tileCells <= cellsAcross; y += tileCells) {
+            for (int x = 0; x + tileCells <= cellsAcross; x += tileCells) {
+                bool free = true;
+                for (int cy = y; cy < y + tileCells && free; ++cy) {
+                    for (int cx = x; cx < x + tileCells && free; ++cx) {
+                        free = !cells[(size_t)cy * cellsAcross + cx];
+                    }
+                }
+                if (!free) {
+                    continue;
+                }
+                for (int cy = y; cy < y + tileCells; ++cy) {
+                    std::fill_n(cells.begin() + (size_t)cy * cellsAcross + x, tileCells, 1);
+                }
+                tile.x = x * minTileSize;
+                tile.y = y * minTileSize;
+                tile.size = tileCells * minTileSize;
+                tile.rendered = false;
+                tile.dirty = true;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ShadowAtlas::release(Tile& tile) {
+    int tileCells = tile.size / minTileSize;
+    for (int cy = tile.y / minTileSize; cy < tile.y / minTileSize + tileCells; ++cy) {
+        std::fill_n(cells.begin() + (size_t)cy * cellsAcross + tile.x / minTileSize, tileCells, 0);
+    }
+    tile = {};
+}
+
+void ShadowAtlas::setCasters(const std::vector<ShadowCaster>& newCasters) {
+    size_t common = std::min(casters.size(), newCasters.size());
+    for (size_t i = 0; i < common; ++i) {
+        CachedCaster& cached = casters[i];
+        if (cached.caster.mesh == newCasters[i].mesh && cached.caster.model == newCasters[i].model) {
+            continue;
+        }
+        changedBounds.push_back(cached.bounds);
+        cached.caster = newCasters[i];
+        cached.bounds = cached.caster.mesh->getBoundingBox().transform(cached.caster.model);
+        changedBounds.push_back(cached.bounds);
+    }
+    for (size_t i = common; i < casters.size(); ++i) {
+        changedBounds.push_back(casters[i].bounds);
+    }
+    casters.resize(common);
+    for (size_t i = common; i < newCasters.size(); ++i) {
+        casters.push_back({newCasters[i], newCasters[i].mesh->getBoundingBox().transform(newCasters[i].model)});
+        changedBounds.push_back(casters.back().bounds);
+    }
+}
+
+void ShadowAtlas::update(const LightManager& lights, Shader& depthShader, const glm::mat4& view, float fovY,
+                         float aspect, float nearPlane, float viewportHeight) {
+    auto start = std::chrono::steady_clock::now();
+    stats = {};
+    ++frame;
+
+    // Maps a changed caster could shadow are out of date
+    auto invalidate = [&](Tile& tile) {
+        for (const BoundingBox& bounds : changedBounds) {
+            if (tile.rendered && tile.casterFrustum.isBoundingBoxInside(bounds)) {
+                tile.dirty = true;
+                return;
+            }
+        }
+    };
+    for (Cascade& cascade : cascades) {
+        invalidate(cascade.tile);
+    }
+    for (SpotShadow& shadow : spotShadows) {
+        invalidate(shadow.tile);
+    }
+    changedBounds.clear();
+
+    glm::mat4 cameraToWorld = glm::inverse(view);
+    glm::vec3 cameraPosition(cameraToWorld[3]);
+    glm::vec3 forward = -glm::normalize(glm::vec3(cameraToWorld[2]));
+
+    // Cascades: a slice's sphere keeps its radius whichever way the camera turns, so a map only ever needs to move
+    directionalShadowed = lights.getDirectionalLightCount() > 0 &&
+                          lights.getLight(LightType::Directional, 0).getIsActive();
+    if (directionalShadowed) {
+        const auto& sun = static_cast<const DirectionalLight&>(lights.getLight(LightType::Directional, 0));
+        sunDirection = sun.getNormalizedDirection();
+        float tanHalfY = std::tan(fovY * 0.5f);
+        float cornerScale = tanHalfY * tanHalfY * (1.0f + aspect * aspect);  // Corner distance^2 / depth^2
+        float farthest = std::max(shadowDistance, nearPlane * 2.0f);
+        float sliceNear = nearPlane;
+        for (int i = 0; i < cascadeCount; ++i) {
+            Cascade& cascade = cascades[i];
+            float t = (float)(i + 1) / cascadeCount;
+            float sliceFar = glm::mix(nearPlane + (farthest - nearPlane) * t,
+                                      nearPlane * std::pow(farthest / nearPlane, t), cascadeSplitLambda);
+
+            // The sphere through the slice's near and far corners, centered on the view axis
+            float depth = std::min((sliceFar + sliceNear) * (1.0f + cornerScale) * 0.5f, sliceFar);
+            cascade.sliceCenter = cameraPosition + forward * depth;
+            cascade.sliceRadius = std::sqrt(std::max((sliceFar - depth) * (sliceFar - depth) +
+                                                     cornerScale * sliceFar * sliceFar,
+                                                     (depth - sliceNear) * (depth - sliceNear) +
+                                                     cornerScale * sliceNear * sliceNear));
+            sliceNear = sliceFar;
+
+            if (cascade.tile.size == 0 && !allocate(cascade.tile, std::min(size / 4, 2048))) {
+                continue;
+            }
+            if (sunDirection != cascade.direction ||
+                glm::distance(cascade.sliceCenter, cascade.center) + cascade.sliceRadius > cascade.radius) {
+                cascade.tile.dirty = true;
+            }
+            cascade.tile.importance = 1.0f / (i + 1);
+        }
+    }
+
+    // Spotlights: the shaded ones covering the most screen
+    struct Candidate {
+        int slot;
+        float pixels;
+    };
+    std::vector<Candidate> candidates;
+    const std::vector<glm::vec4>& bounds = lights.getBounds(LightType::Spot);
+    for (int slot = 0; slot < lights.getShadedCount(LightType::Spot); ++slot) {
+        if (lights.getLight(LightType::Spot, slot).getIsActive() && bounds[slot].w > 0.0f) {
+            candidates.push_back({slot, LODSelector::projectedDiameter(glm::vec3(bounds[slot]), bounds[slot].w,
+                                                                       cameraPosition, fovY, viewportHeight)});
+        }
+    }
+    size_t kept = std::min(candidates.size(), (size_t)maxSpotShadows);
+    std::partial_sort(candidates.begin(), candidates.begin() + kept, candidates.end(),
+                      [](const Candidate& a, const Candidate& b) { return a.pixels > b.pixels; });
+
+    for (size_t i = 0; i < kept; ++i) {
+        const auto& spot = static_cast<const SpotLight&>(lights.getLight(LightType::Spot, candidates[i].slot));
+        auto shadow = std::find_if(spotShadows.begin(), spotShadows.end(),
+                                   [&](const SpotShadow& entry) { return entry.light == &spot; });
+        if (shadow == spotShadows.end()) {
+            spotShadows.push_back({});
+            shadow = spotShadows.end() - 1;
+            shadow->light = &spot;
+        }
+        shadow->slot = candidates[i].slot;
+        shadow->lastUsed = frame;
+
+        // About a texel per pixel the light covers. Tiles are resized when that's over twice or under a quarter
+        // of their size, so lights near a boundary don't keep reallocating
+        int wanted = std::clamp(nextPowerOfTwo(candidates[i].pixels), minTileSize, maxSpotTileSize);
+        if (shadow->tile.size != 0 && (wanted > shadow->tile.size || wanted * 4 <= shadow->tile.size)) {
+            release(shadow->tile);
+        }
+        while (shadow->tile.size == 0 && !allocate(shadow->tile, wanted)) {
+            // Full: give up the least recently used tile of a light not shadowed this frame
+            auto evicted = std::min_element(spotShadows.begin(), spotShadows.end(),
+                                            [&](const SpotShadow& a, const SpotShadow& b) {
+                                                bool aFree = a.lastUsed != frame && a.tile.size != 0;
+                                                bool bFree = b.lastUsed != frame && b.tile.size != 0;
+                                                return aFree != bFree ? aFree : a.lastUsed < b.lastUsed;
+                                            });
+            if (evicted->lastUsed == frame || evicted->tile.size == 0) {
+                break;
+            }
+            release(evicted->tile);
+        }
+        if (shadow->tile.size == 0) {
+            continue;
+        }
+
+        float cosOuter = std::clamp(spot.getOuterCutoff(), minSpotCosine, 1.0f);
+        float tanHalf = std::sqrt(1.0f - cosOuter * cosOuter) / cosOuter;
+        glm::vec3 position = spot.getPosition();
+        glm::vec3 direction = spot.getNormalizedDirection();
+        shadow->viewProjection = glm::perspective(2.0f * std::atan(tanHalf), 1.0f, spotNearPlane,
+                                                  bounds[shadow->slot].w) *
+                                 glm::lookAt(position, position + direction, upFor(direction));
+        shadow->tanHalfAngle = tanHalf;
+        if (shadow->viewProjection != shadow->tile.viewProjection) {
+            shadow->tile.dirty = true;
+        }
+        shadow->tile.importance = std::min(candidates[i].pixels / viewportHeight, 1.0f);
+    }
+    // Entries that lost their tile have nothing left to cache
+    spotShadows.erase(std::remove_if(spotShadows.begin(), spotShadows.end(),
+                                     [](const SpotShadow& entry) { return entry.tile.size == 0; }),
+                      spotShadows.end());
+
+    // Tiles that have never been rendered go first (a light missing its shadow shows more than a late one),
+    // then by importance, raised the longer a tile waits
+    struct DueTile {
+        Tile* tile;
+        Cascade* cascade;
+        SpotShadow* spot;
+    };
+    std::vector<DueTile> due;
+    for (int i = 0; i < cascadeCount && directionalShadowed; ++i) {
+        if (cascades[i].tile.size != 0 && cascades[i].tile.dirty) {
+            due.push_back({&cascades[i].tile, &cascades[i], nullptr});
+        }
+    }
+    for (SpotShadow& shadow : spotShadows) {
+        if (shadow.lastUsed == frame && shadow.tile.dirty) {
+            due.push_back({&shadow.tile, nullptr, &shadow});
+        }
+    }
+    auto priority = [](const DueTile& entry) {
+        return (entry.tile->rendered ? 0.0f : 1000.0f) + entry.tile->importance * (1.0f + entry.tile->staleFrames);
+    };
+    std::sort(due.begin(), due.end(), [&](const DueTile& a, const DueTile& b) { return priority(a) > priority(b); });
+    size_t rendered = std::min(due.size(), (size_t)std::max(updateBudget, 0));
+    for (size_t i = rendered; i < due.size(); ++i) {
+        ++due[i].tile->staleFrames;
+    }
+    stats.tilesStale = (int)(due.size() - rendered);
+    due.resize(rendered);
+
+    if (!due.empty()) {
+        GLint previousFramebuffer = 0;
+        GLint previousViewport[4];
+        glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+        glGetIntegerv(GL_VIEWPORT, previousViewport);
+        GLboolean cullFace = glIsEnabled(GL_CULL_FACE);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
+        glEnable(GL_SCISSOR_TEST);
+        // Both faces: the ground plane and open meshes have no back to cast from. The slope-scaled offset keeps
+        // lit surfaces from shadowing themselves
+        glDisable(GL_CULL_FACE);
+        glEnable(GL_POLYGON_OFFSET_FILL);
+        glPolygonOffset(2.0f, 4.0f);
+        depthShader.use();
+
+        for (const DueTile& entry : due) {
+            if (entry.cascade) {
+                renderCascade(*entry.cascade, depthShader);
+            } else {
+                // The light's own frustum bounds a spotlight's casters
+                renderTile(*entry.tile, entry.spot->viewProjection, entry.spot->viewProjection, depthShader);
+                entry.spot->texelSize = 2.0f * entry.spot->tanHalfAngle / entry.tile->size;
+            }
+        }
+
+        glDisable(GL_POLYGON_OFFSET_FILL);
+        glDisable(GL_SCISSOR_TEST);
+        if (cullFace) {
+            glEnable(GL_CULL_FACE);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+        glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+    }
+
+    for (int i = 0; i < cascadeCount && directionalShadowed; ++i) {
+        stats.cascades += cascades[i].tile.rendered;
+    }
+    stats.cachedTiles = stats.cascades;
+    for (const SpotShadow& shadow : spotShadows) {
+        stats.spotShadows += shadow.lastUsed == frame && shadow.tile.rendered;
+        stats.cachedTiles += shadow.tile.rendered;
+    }
+    uploadSpotShadows(lights.getShadedCount(LightType::Spot));
+    stats.updateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ShadowAtlas::uploadSpotShadows(int spotCount) {
+    // Slots move every frame as lights are culled, so the whole table is rewritten. Slots without a map keep a
+    // zero tile size
+    spotShadowData.assign((size_t)std::max(spotCount, 1) * spotShadowTexels, glm::vec4(0.0f));
+    for (const SpotShadow& shadow : spotShadows) {
+        if (shadow.lastUsed != frame || !shadow.tile.rendered || shadow.slot >= spotCount) {
+            continue;
+        }
+        glm::vec4* entry = &spotShadowData[(size_t)shadow.slot * spotShadowTexels];
+        entry[0] = glm::vec4((float)shadow.tile.x, (float)shadow.tile.y, (float)shadow.tile.size,
+                             shadow.texelSize * size) / (float)size;
+        glm::mat4 matrix = clipToTexture * shadow.tile.viewProjection;
+        for (int column = 0; column < 4; ++column) {
+            entry[1 + column] = matrix[column];
+        }
+    }
+
+    if (spotShadowBuffer == 0) {
+        glGenBuffers(1, &spotShadowBuffer);
+        glGenTextures(1, &spotShadowTexture);
+        glBindTexture(GL_TEXTURE_BUFFER, spotShadowTexture);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, spotShadowBuffer);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, spotShadowBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, spotShadowData.size() * sizeof(glm::vec4), spotShadowData.data(),
+                 GL_STREAM_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+void ShadowAtlas::renderCascade(Cascade& cascade, Shader& depthShader) {
+    // Refit: a sphere with slack around the slice, its center snapped to whole texels so the map doesn't
+    // shimmer as the camera moves
+    cascade.direction = sunDirection;
+    glm::mat4 lightView = glm::lookAt(glm::vec3(0.0f), sunDirection, upFor(sunDirection));
+    float radius = cascade.sliceRadius * cascadeSlack;
+    cascade.texelSize = 2.0f * radius / cascade.tile.size;
+    glm::vec3 center(lightView * glm::vec4(cascade.sliceCenter, 1.0f));
+    center.x = std::floor(center.x / cascade.texelSize) * cascade.texelSize;
+    center.y = std::floor(center.y / cascade.texelSize) * cascade.texelSize;
+    cascade.center = glm::vec3(glm::transpose(lightView) * glm::vec4(center, 1.0f));
+    cascade.radius = radius - cascade.texelSize * 2.0f;  // Less what the snapping may have moved
+
+    // Depth range: the sphere, and every caster between it and the light
+    float nearZ = center.z + radius;
+    float farZ = center.z - radius;
+    for (const CachedCaster& caster : casters) {
+        for (const glm::vec3& corner : caster.bounds.getCorners()) {
+            nearZ = std::max(nearZ, (lightView * glm::vec4(corner, 1.0f)).z);
+        }
+    }
+    float left = center.x - radius, right = center.x + radius;
+    float bottom = center.y - radius, top = center.y + radius;
+    renderTile(cascade.tile, glm::ortho(left, right, bottom, top, -nearZ, -farZ) * lightView,
+               glm::ortho(left, right, bottom, top, -nearZ - cascadeCasterReach, -farZ) * lightView, depthShader);
+}
+
+void ShadowAtlas::renderTile(Tile& tile, const glm::mat4& viewProjection, const glm::mat4& casterViewProjection,
+                             Shader& depthShader) {
+    tile.viewProjection = viewProjection;
+    tile.casterFrustum.extractPlanes(casterViewProjection);
+
+    glViewport(tile.x, tile.y, tile.size, tile.size);
+    glScissor(tile.x, tile.y, tile.size, tile.size);
+    glClear(GL_DEPTH_BUFFER_BIT);
+    depthShader.set(lightViewProjectionUniform, viewProjection);
+    for (const CachedCaster& caster : casters) {
+        if (!tile.casterFrustum.isBoundingBoxInside(caster.bounds)) {
+            ++stats.castersCulled;
+            continue;
+        }
+        depthShader.set(modelUniform, caster.caster.model);
+        caster.caster.mesh->draw(depthShader);
+        ++stats.castersDrawn;
+    }
+
+    tile.rendered = true;
+    tile.dirty = false;
+    tile.staleFrames = 0;
+    ++stats.tilesRendered;
+}
+
+void ShadowAtlas::bind(const Shader& shader, int firstUnit) const {
+    glActiveTexture(GL_TEXTURE0 + firstUnit);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glActiveTexture(GL_TEXTURE0 + firstUnit + 1);
+    glBindTexture(GL_TEXTURE_BUFFER, spotShadowTexture);
+    shader.set(shadowAtlasUniform, firstUnit);
+    shader.set(spotShadowsUniform, firstUnit + 1);
+
+    // Maps are used with the matrices they were rendered with, so stale tiles are still correct where they reach
+    auto atlasRect = [&](const Tile& tile) {
+        return glm::vec4((float)tile.x, (float)tile.y, (float)tile.size, (float)tile.size) / (float)size;
+    };
+
+    int count = 0;
+    for (int i = 0; i < cascadeCount && directionalShadowed; ++i) {
+        const Cascade& cascade = cascades[i];
+        if (!cascade.tile.rendered) {
+            continue;
+        }
+        shader.set(cascadeMatricesUniform, count, clipToTexture * cascade.tile.viewProjection);
+        shader.set(cascadeRectsUniform, count, atlasRect(cascade.tile));
+        shader.set(cascadeTexelSizesUniform, count, cascade.texelSize);
+        ++count;
+    }
+    shader.set(cascadeCountUniform, count);
+}
+
+void ShadowAtlas::destroy() {
+    if (framebuffer) {
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteTextures(1, &texture);
+    }
+    if (spotShadowBuffer) {
+        glDeleteTextures(1, &spotShadowTexture);
+        glDeleteBuffers(1, &spotShadowBuffer);
+    }
+    framebuffer = texture = spotShadowBuffer = spotShadowTexture = 0;
+}
@@ -1,16 +1,33 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <random>
 #include <SDL2/SDL.h>
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "rendering/shader.h"
+#include "rendering/ProgramCache.h"
+#include "rendering/ShaderPermutations.h"
 #include "rendering/PBRMesh.h"
 #include "rendering/OBJLoader.h"
+#include "rendering/GeometryProcessing.h"
+#include "rendering/MeshCache.h"
+#include "rendering/MeshOptimizer.h"
+#include "rendering/MeshSimplifier.h"
+#include "rendering/LODSelector.h"
+#include "rendering/TextureLoader.h"
+#include "rendering/AssetRegistry.h"
+#include "rendering/MaterialPool.h"
 #include "core/Camera.h"
 #include "lighting/PointLight.h"
 #include "lighting/DirectionalLight.h"
 #include "lighting/SpotLight.h"
+#include "lighting/LightManager.h"
+#include "lighting/LightClusters.h"
+#include "lighting/LightCuller.h"
+#include "lighting/ShadowAtlas.h"
 #include "imgui.h"
 #include "imgui_impl_sdl2.h"
 #include "imgui_impl_opengl3.h"
@@ -20,6 +37,15 @@
 // Constants
 constexpr int WINDOW_WIDTH = 800;
 constexpr int WINDOW_HEIGHT = 600;
+constexpr float CAMERA_FOV_DEGREES = 45.0f;
+constexpr float CAMERA_NEAR_PLANE = 0.1f;
+constexpr float CAMERA_FAR_PLANE = 100.0f;
+constexpr double TEXTURE_UPLOAD_BUDGET_MS = 2.0;  // GL-thread time per frame for streaming textures in
+constexpr float PLANE_UV_REPEAT_SIZE = 2.0f;  // World units covered by one repeat of the plane's textures
+constexpr int LIGHT_BUFFER_TEXTURE_UNIT = 10;  // First of three, after the G-buffer's units 5-9
+constexpr int LIGHT_CLUSTER_TEXTURE_UNIT = 13;  // First of two, after the light buffers
+constexpr int SHADOW_ATLAS_TEXTURE_UNIT = 15;  // First of two (atlas, spot shadow table), after the clusters
+constexpr int MAX_EXTRA_LIGHTS = 4096;
 
 // Global variables for cleanup
 SDL_Window* g_window = nullptr;
@@ -32,7 +58,68 @@ int g_visibleObjects = 0;
 BoundingBox g_bunnyBoundingBox;  // Global bunny bounding box
 bool g_frustumCullingEnabled = true;  // Toggle for frustum culling
 
+// Level of detail statistics
+bool g_lodEnabled = true;  // Toggle for screen-size LOD selection
+int g_smallCulledObjects = 0;  // Instances culled for being too small on screen
+int g_lodInstanceCounts[4] = {};  // Instances drawn at LOD 0..3
+long long g_drawnTriangles = 0;
+
+// Meshlet culling statistics
+bool g_meshletCullingEnabled = true;  // Toggle for per-meshlet frustum and backface cone culling
+MeshletCullStats g_meshletStats;
+
+// Texture streaming statistics
+TextureLoaderStats g_textureStats;
+double g_firstFrameMs = 0.0;     // Startup to first presented frame
+double g_texturesReadyMs = 0.0;  // Startup to every texture resident (0 while still loading)
+int g_textureBudgetMB = 256;     // Mip streaming budget for baked textures
+TextureStreamingStats g_streamingStats;
+
+// Shader variants
+ShaderQuality g_shaderQuality = ShaderQuality::High;        // Chosen in the UI
+ShaderQuality g_activeShaderQuality = ShaderQuality::High;  // Drawn with: g_shaderQuality once it has built
+size_t g_shaderVariants = 0;
+size_t g_shaderVariantsPending = 0;
+
+// Light buffer statistics
+LightManagerStats g_lightStats;
+
+// Lighting path
+bool g_clusteredShading = true;  // Toggle for looping over each pixel's cluster instead of every light
+bool g_lightVolumes = false;     // Toggle for drawing point and spot lights as stencil-masked volumes instead
+int g_extraLights = 0;           // Small random point lights added on top of the scene's, to load the light loop
+LightClusterStats g_clusterStats;
+
+// Light culling
+bool g_lightCulling = true;  // Toggle for frustum culling and the light budget
+int g_lightBudget = 256;     // Most point and spot lights shaded per frame
+LightCullStats g_lightCullStats;
+
+// Shadows
+bool g_shadows = true;         // Toggle for the shadow atlas
+int g_shadowUpdateBudget = 2;  // Most shadow tiles re-rendered per frame
+ShadowAtlasStats g_shadowStats;
+
+// Asset registry statistics, refreshed about once a second
+size_t g_liveAssets = 0;
+size_t g_assetGPUBytes = 0;
+AssetRegistryStats g_assetStats;
+
+// Material pool statistics
+int g_pooledMaterials = 0;
+int g_materialPools = 0;
+size_t g_materialPoolBytes = 0;
+int g_materialBinds = 0;  // Texture binds in the last geometry pass
+
+// Reorder mesh triangles/vertices for GPU cache locality and overdraw when (re)building mesh caches
+constexpr bool g_optimizeMeshes = true;
+
+// Upload dense meshes as 20-byte quantized vertices instead of the full 68-byte Vertex
+using BunnyVertexFormat = PackedVertexFormat;
+
 // Function declarations
+uint32_t lightingPathFeature();
+uint32_t shadowFeature();
 bool initializeSDL();
 bool createWindow();
 bool initializeOpenGL();
@@ -43,11 +130,22 @@ void updateCamera(Camera& camera, const Uint8* state, float deltaTime, bool& cam
 void renderImGui(Camera& camera, float currentFPS, float deltaTime, bool cameraMode);
 std::vector<Vertex> createPlaneVertices();
 std::vector<GLuint> createPlaneIndices();
-std::vector<Vertex> calculateTangentsBitangents(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices);
 
 
-int main() {
+int main(int argc, char* argv[]) {
+    // Offline tooling: time the OBJ loader modes and dedup table, then exit
+    if (argc > 2 && std::string(argv[1]) == "--bench-obj") {
+        bool identical = compareOBJLoadModes(argv[2]);
+        benchmarkOBJDedup(argv[2]);
+        return identical ? 0 : 1;
+    }
+
     // ===== INITIALIZATION =====
+    auto startupStart = std::chrono::steady_clock::now();
+    auto millisecondsSinceStartup = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupStart).count();
+    };
+
     if (!initializeSDL()) {
         return -1;
     }
@@ -71,12 +169,23 @@ int main() {
     glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
     glEnable(GL_DEPTH_TEST);
 
+    // Textures decode on worker threads while meshes load, and upload a little each frame. Baked textures
+    // stream their finer mips in as the camera gets close, within the budget
+    TextureLoader textureLoader;
+    textureLoader.setStreamingBudget((size_t)g_textureBudgetMB << 20);
+
+    // Shared textures, shaders and meshes: a file used twice is loaded once
+    AssetRegistry assets;
+
+    // Texture arrays for materials with matching map sizes and formats, so they share one set of binds
+    MaterialPool materialPool;
+
     // ===== GEOMETRY CREATION =====
     auto planeVertices = createPlaneVertices();
     auto planeIndices = createPlaneIndices();
     
     // Calculate tangents and bitangents for normal mapping
-    planeVertices = calculateTangentsBitangents(planeVertices, planeIndices);
+    calculateTangentsBitangents(planeVertices, planeIndices);
 
     // Create PBR material for the plane
     PBRMaterial planePBRMaterial(
@@ -84,57 +193,88 @@ int main() {
         "Textures/TCom_Scifi_Panel_2K_normal.png",
         "Textures/TCom_Scifi_Panel_2K_metallic.png",
         "Textures/TCom_Scifi_Panel_2K_roughness.png",
-        "Textures/TCom_Scifi_Panel_2K_ao.png"
+        "Textures/TCom_Scifi_Panel_2K_ao.png",
+        textureLoader,
+        &assets,
+        &materialPool
     );
 
     // Create plane mesh
     PBRMesh planeMesh(planeVertices, planeIndices, std::move(planePBRMaterial));
 
-    // Load bunny mesh
-    std::vector<Vertex> bunnyVertices;
-    std::vector<GLuint> bunnyIndices;
+    // Load bunny mesh through its binary cache; UVs and tangents are only generated when the cache is rebuilt.
+    // The registry keys it by file contents and post-processing, so another user would share this instance
+    std::shared_ptr<PBRMesh> bunnyMesh;
     try {
-        auto bunnyData = loadOBJFile("Meshes/bunny.obj");
-        bunnyVertices = bunnyData.first;
-        bunnyIndices = bunnyData.second;
-    } catch (const std::exception& e) {
-        std::cerr << "Failed to load bunny model: " << e.what() << std::endl;
-        return -1;
-    }
-
-    // Generate texture coordinates for bunny (spherical mapping)
-    for (auto& vertex : bunnyVertices) {
-        // Convert position to spherical coordinates for texture mapping
-        glm::vec3 pos = vertex.position;
-        float radius = glm::length(pos);
-        
-        if (radius > 0.0f) {
-            // Spherical coordinates: u = azimuth angle, v = elevation angle
-            float u = 0.5f + (atan2(pos.z, pos.x) / (2.0f * M_PI));  // Azimuth: 0 to 1
-            float v = 0.5f + (asin(pos.y / radius) / M_PI);          // Elevation: 0 to 1
-            
-            vertex.texCoord = glm::vec2(u, v);
-        } else {
-            vertex.texCoord = glm::vec2(0.5f, 0.5f);  // Center point
-        }
-    }
+        bunnyMesh = assets.getMesh<PBRMesh>("Meshes/bunny.obj", g_optimizeMeshes ? 1 : 0, [&]() {
+            MeshCache bunnyData = loadOBJCached("Meshes/bunny.obj", [](MeshData& mesh) {
+                // Generate texture coordinates for bunny (spherical mapping)
+                for (auto& vertex : mesh.vertices) {
+                    // Convert position to spherical coordinates for texture mapping
+                    glm::vec3 pos = vertex.position;
+                    float radius = glm::length(pos);
+                    
+                    if (radius > 0.0f) {
+                        // Spherical coordinates: u = azimuth angle, v = elevation angle
+                        float u = 0.5f + (atan2(pos.z, pos.x) / (2.0f * M_PI));  // Azimuth: 0 to 1
+                        float v = 0.5f + (asin(pos.y / radius) / M_PI);          // Elevation: 0 to 1
+                        
+                        vertex.texCoord = glm::vec2(u, v);
+                    } else {
+                        vertex.texCoord = glm::vec2(0.5f, 0.5f);  // Center point
+                    }
+                }
 
-    // Calculate tangents and bitangents for bunny (after texture coordinates are set)
-    bunnyVertices = calculateTangentsBitangents(bunnyVertices, bunnyIndices);
+                // Calculate tangents and bitangents for bunny (after texture coordinates are set)
+                calculateTangentsBitangents(mesh.vertices, mesh.indices);
 
-    // Create PBR material for the bunny
-    PBRMaterial bunnyPBRMaterial(
-        "Textures/TCom_Plastic_SpaceBlanketFolds_2K_albedo.png",
-        "Textures/TCom_Plastic_SpaceBlanketFolds_2K_normal.png",
-        "Textures/TCom_Plastic_SpaceBlanketFolds_2K_metallic.png",
-        "Textures/TCom_Plastic_SpaceBlanketFolds_2K_roughness.png",
-        "Textures/TCom_Plastic_SpaceBlanketFolds_2K_ao.png"
-    );
-    
+                if (g_optimizeMeshes) {
+                    MeshOptimizationReport report = optimizeMesh(mesh.vertices, mesh.indices);
+                    std::cout << "Bunny mesh optimized: ACMR " << report.before.acmr << " -> " << report.after.acmr
+                              << ", ATVR " << report.before.atvr << " -> " << report.after.atvr
+                              << " (" << report.clusterCount << " overdraw clusters)" << std::endl;
+                }
 
+                // Simplified levels share the vertex buffer and are appended to the index buffer
+                mesh.lods = buildLODChain(mesh.vertices, mesh.indices);
+                for (size_t i = 0; i < mesh.lods.size(); ++i) {
+                    std::cout << "Bunny LOD " << i << ": " << mesh.lods[i].indexCount / 3 << " triangles (error "
+                              << mesh.lods[i].error << ")" << std::endl;
+                }
 
-    // Create a single bunny mesh instance
-    PBRMesh bunnyMesh(bunnyVertices, bunnyIndices, std::move(bunnyPBRMaterial));
+                // Split LOD 0 into meshlets for per-meshlet culling (reorders LOD 0's triangles)
+                mesh.meshlets = buildMeshlets(mesh.vertices, mesh.indices, 0, mesh.lods[0].indexCount);
+                std::cout << "Bunny meshlets: " << mesh.meshlets.size() << std::endl;
+            }, g_optimizeMeshes ? 1 : 0);
+
+            // Create PBR material for the bunny
+            PBRMaterial bunnyPBRMaterial(
+                "Textures/TCom_Plastic_SpaceBlanketFolds_2K_albedo.png",
+                "Textures/TCom_Plastic_SpaceBlanketFolds_2K_normal.png",
+                "Textures/TCom_Plastic_SpaceBlanketFolds_2K_metallic.png",
+                "Textures/TCom_Plastic_SpaceBlanketFolds_2K_roughness.png",
+                "Textures/TCom_Plastic_SpaceBlanketFolds_2K_ao.png",
+                textureLoader,
+                &assets,
+                &materialPool
+            );
+
+            // Create a single bunny mesh instance, uploading straight from the cache
+            auto mesh = std::make_shared<PBRMesh>(bunnyData.getVertices(), bunnyData.getIndices(),
+                                                  bunnyData.getBoundingBox(), std::move(bunnyPBRMaterial),
+                                                  BunnyVertexFormat{});
+            mesh->setLODs(bunnyData.getLODs());
+            mesh->setMeshlets(bunnyData.getMeshlets());
+            return mesh;
+        });
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load bunny model: " << e.what() << std::endl;
+        return -1;
+    }
+    std::cout << "Bunny vertex buffer: " << bunnyMesh->getVertexBufferSize() / 1024 << " KB ("
+              << bunnyMesh->getVertexBufferSize() / std::max<size_t>(bunnyMesh->getVertexCount(), 1)
+              << " bytes per vertex)" << std::endl;
+    g_bunnyBoundingBox = bunnyMesh->getBoundingBox();  // Local-space bounds for culling
 
     // Create transformation matrices for 100 bunny instances
     std::vector<glm::mat4> bunnyTransforms;
@@ -152,20 +292,33 @@ int main() {
             transform = glm::translate(transform, glm::vec3(x, y, z));
             transform = glm::scale(transform, glm::vec3(3.0f)); // Scale up the bunny by 3x
             
-                    bunnyTransforms.push_back(transform);
+            bunnyTransforms.push_back(transform);
+        }
     }
+
+    // Per-instance LOD from the previous frame (-1 = not drawn), so selection can apply hysteresis
+    std::vector<int> bunnyLODs(bunnyTransforms.size(), -1);
+    LODSelector lodSelector;
     
-    // Calculate bounding box for bunny mesh (in local space)
-    std::vector<glm::vec3> bunnyPositions;
-    for (const auto& vertex : bunnyVertices) {
-        bunnyPositions.push_back(vertex.position);
-    }
-    g_bunnyBoundingBox = BoundingBox::fromVertices(bunnyPositions);
-}
+    // Per-instance meshlet draw lists, reused every frame
+    std::vector<MeshletDrawList> bunnyMeshletDraws(bunnyTransforms.size());
 
     // ===== SHADER CREATION =====
-    Shader gbufferShader("Shaders/gbuffer.vert", "Shaders/gbuffer_PBR.frag");
-    Shader deferredLightingShader("Shaders/deferred_lighting.vert", "Shaders/deferred_lighting_PBR.frag");
+    // Variants are compiled the first time a material or light setup needs them
+    ShaderPermutations gbufferShaders(assets, "Shaders/gbuffer.vert", "Shaders/gbuffer_PBR.frag");
+    ShaderPermutations lightingShaders(assets, "Shaders/deferred_lighting.vert", "Shaders/deferred_lighting_PBR.frag");
+    ShaderPermutations lightVolumeShaders(assets, "Shaders/light_volume.vert", "Shaders/deferred_lighting_PBR.frag");
+    ShaderPermutations lightVolumeStencilShaders(assets, "Shaders/light_volume.vert",
+                                                 "Shaders/light_volume_stencil.frag");
+    std::shared_ptr<Shader> tonemapShader = assets.getShader("Shaders/deferred_lighting.vert", "Shaders/tonemap.frag");
+    std::shared_ptr<Shader> shadowDepthShader = assets.getShader("Shaders/shadow_depth.vert",
+                                                                 "Shaders/shadow_depth.frag");
+    auto gbufferKeyFor = [](const PBRMaterial& material, ShaderQuality quality) {
+        return ShaderVariantKey{material.getShaderFeatures(), quality};
+    };
+    auto gbufferShaderFor = [&](const PBRMaterial& material) -> Shader& {
+        return gbufferShaders.get(gbufferKeyFor(material, g_activeShaderQuality));
+    };
 
     // ===== LIGHT SETUP =====
     // Original point lights
@@ -292,17 +445,92 @@ int main() {
         1.5f                             // Intensity
     );
 
+    // The lighting shader reads every light from the manager's buffers
+    LightManager lightManager;
+    for (Light* light : std::initializer_list<Light*>{pointLight1.get(), pointLight2.get(), pointLight3.get(),
+                                                      pointLight4.get(), spotLight1.get(), spotLight2.get(),
+                                                      spotLight3.get(), spotLight4.get(), directionalLight.get()}) {
+        lightManager.add(*light);
+    }
+    for (const auto& light : gridLights) {
+        lightManager.add(*light);
+    }
+
+    // Extra lights for the UI slider, spread over the plane; created as the slider asks for them
+    std::vector<std::unique_ptr<PointLight>> extraLights;
+    std::mt19937 extraLightRandom(7);
+    auto setExtraLightCount = [&](int count) {
+        std::uniform_real_distribution<float> across(-5.0f, 5.0f);
+        std::uniform_real_distribution<float> height(0.2f, 2.0f);
+        std::uniform_real_distribution<float> channel(0.005f, 0.02f);
+        while ((int)extraLights.size() < count) {
+            // Dim enough to reach about 1 unit (see LightManager::influenceRadius)
+            extraLights.push_back(std::make_unique<PointLight>(
+                glm::vec3(across(extraLightRandom), height(extraLightRandom), across(extraLightRandom)),
+                glm::vec3(channel(extraLightRandom), channel(extraLightRandom), channel(extraLightRandom))));
+            lightManager.add(*extraLights.back());
+        }
+        extraLights.resize(std::min((size_t)count, extraLights.size()));  // Destroyed lights leave the manager
+    };
+    LightClusters lightClusters;
+    LightCuller lightCuller;
+
+    // ===== SHADER VARIANTS =====
+    auto lightingKeyFor = [&](ShaderQuality quality, uint32_t pathFeature = lightingPathFeature(),
+                              uint32_t shadows = shadowFeature()) {
+        uint32_t features = lightManager.getDirectionalLightCount() > 0 ? (uint32_t)ShaderFeatureDirLight : 0u;
+        return ShaderVariantKey{features | pathFeature | shadows, quality};
+    };
+    auto spotVolumeKeyFor = [](ShaderQuality quality, uint32_t shadows = shadowFeature()) {
+        return ShaderVariantKey{ShaderFeatureSpotVolume | shadows, quality};
+    };
+    auto shaderVariantsReady = [&](ShaderQuality quality) {
+        return gbufferShaders.isReady(gbufferKeyFor(planeMesh.getMaterial(), quality)) &&
+               gbufferShaders.isReady(gbufferKeyFor(bunnyMesh->getMaterial(), quality)) &&
+               lightingShaders.isReady(lightingKeyFor(quality)) &&
+               lightVolumeShaders.isReady({ShaderFeaturePointVolume, quality}) &&
+               lightVolumeShaders.isReady(spotVolumeKeyFor(quality));
+    };
+
+    // Submit every variant the scene can switch to in one batch, so the driver builds them side by side. The
+    // first frame waits for the current quality's; the other tiers finish in the background
+    for (ShaderQuality quality : {g_activeShaderQuality, ShaderQuality::Low, ShaderQuality::Medium,
+                                  ShaderQuality::High}) {
+        gbufferShaders.prepare({gbufferKeyFor(planeMesh.getMaterial(), quality),
+                                gbufferKeyFor(bunnyMesh->getMaterial(), quality)});
+        for (uint32_t shadows : {shadowFeature(), shadowFeature() ^ ShaderFeatureShadows}) {
+            lightingShaders.prepare({lightingKeyFor(quality, ShaderFeatureClustered, shadows),
+                                     lightingKeyFor(quality, 0, shadows),
+                                     lightingKeyFor(quality, ShaderFeatureLightVolumes, shadows)});
+            lightVolumeShaders.prepare({spotVolumeKeyFor(quality, shadows)});
+        }
+        lightVolumeShaders.prepare({{ShaderFeaturePointVolume, quality}});
+    }
+    lightVolumeStencilShaders.prepare({{ShaderFeaturePointVolume, ShaderQuality::High},
+                                       {ShaderFeatureSpotVolume, ShaderQuality::High}});
+
+    // Every mesh's vertex format must supply what the G-buffer shader reads (waits for those variants)
+    bool planeLayoutValid = validateVertexLayout(gbufferShaderFor(planeMesh.getMaterial()).id,
+                                                 planeMesh.getVertexLayout(), "plane");
+    bool bunnyLayoutValid = validateVertexLayout(gbufferShaderFor(bunnyMesh->getMaterial()).id,
+                                                 bunnyMesh->getVertexLayout(), "bunny");
+    if (!planeLayoutValid || !bunnyLayoutValid) {
+        std::cerr << "Vertex formats don't match the G-buffer shader" << std::endl;
+        return -1;
+    }
+
     // ===== CAMERA AND MATRICES SETUP =====
     Camera camera(glm::vec3(0.0f, 2.0f, 5.0f));
     glm::mat4 model = glm::mat4(1.0f);
     model = glm::rotate(model, glm::radians(0.0f), glm::vec3(1.0f, 0.0f, 0.0f));
-    glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 100.0f);
+    glm::mat4 projection = glm::perspective(glm::radians(CAMERA_FOV_DEGREES), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
 
     // ===== TIMING AND INPUT VARIABLES =====
     bool firstMouse = true;
     int lastX = WINDOW_WIDTH / 2;
     int lastY = WINDOW_HEIGHT / 2;
     Uint32 lastFrameTime = SDL_GetTicks();
+    Uint32 lastAssetReportTime = 0;
     float deltaTime = 0.0f;
     Uint32 frameCount = 0;
     Uint32 fpsStartTime = SDL_GetTicks();
@@ -323,8 +551,20 @@ int main() {
         return -1;
     }
 
+    // Shadow maps of the sun and the spotlights, in one atlas. Every mesh instance casts
+    ShadowAtlas shadowAtlas;
+    if (!shadowAtlas.initialize()) {
+        std::cerr << "Failed to initialize shadow atlas!" << std::endl;
+        cleanup();
+        return -1;
+    }
+    std::vector<ShadowCaster> shadowCasters = {{&planeMesh, glm::mat4(1.0f)}};
+    for (const glm::mat4& transform : bunnyTransforms) {
+        shadowCasters.push_back({bunnyMesh.get(), transform});
+    }
+
     // Create geometry meshes vector with plane and bunny
-    std::vector<PBRMesh*> geometryMeshes = {&planeMesh, &bunnyMesh};
+    std::vector<PBRMesh*> geometryMeshes = {&planeMesh, bunnyMesh.get()};
 
     // ===== MAIN RENDER LOOP =====
     bool quit = false;
@@ -354,6 +594,37 @@ int main() {
         // Update camera
         updateCamera(camera, state, deltaTime, cameraMode);
 
+        // Stream decoded textures to the GPU within this frame's budget
+        textureLoader.setStreamingBudget((size_t)g_textureBudgetMB << 20);
+        textureLoader.setPinnedBytes(materialPool.getGPUMemorySize());
+        textureLoader.update(TEXTURE_UPLOAD_BUDGET_MS);
+        g_textureStats = textureLoader.getStats();
+        g_streamingStats = textureLoader.getStreamingStats();
+        if (g_texturesReadyMs == 0.0 && textureLoader.isIdle()) {
+            g_texturesReadyMs = millisecondsSinceStartup();
+            std::cout << "All textures resident " << g_texturesReadyMs << " ms after startup (worst upload frame "
+                      << g_textureStats.maxUpdateMs << " ms)" << std::endl;
+            for (const AssetMemoryInfo& asset : assets.getMemoryReport()) {
+                std::cout << "  " << asset.kind << " " << asset.name << ": " << asset.gpuBytes / 1024 << " KB, "
+                          << asset.handles << " handle(s)" << std::endl;
+            }
+        }
+
+        // Asset memory totals for the UI
+        if (currentFrameTime - lastAssetReportTime >= 1000) {
+            lastAssetReportTime = currentFrameTime;
+            std::vector<AssetMemoryInfo> report = assets.getMemoryReport();
+            g_liveAssets = report.size();
+            g_assetGPUBytes = 0;
+            for (const AssetMemoryInfo& asset : report) {
+                g_assetGPUBytes += asset.gpuBytes;
+            }
+            g_assetStats = assets.getStats();
+            g_pooledMaterials = materialPool.getLayerCount();
+            g_materialPools = materialPool.getPoolCount();
+            g_materialPoolBytes = materialPool.getGPUMemorySize();
+        }
+
         // Clear buffers
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -367,141 +638,166 @@ int main() {
         renderImGui(camera, currentFPS, deltaTime, cameraMode);
 
         // ===== DEFERRED RENDERING PASSES =====
+        // A new quality takes over once its variants are built; until then frames use the current one
+        if (g_shaderQuality != g_activeShaderQuality && shaderVariantsReady(g_shaderQuality)) {
+            g_activeShaderQuality = g_shaderQuality;
+        }
+        g_shaderVariants = gbufferShaders.getVariantCount() + lightingShaders.getVariantCount() +
+                           lightVolumeShaders.getVariantCount() + lightVolumeStencilShaders.getVariantCount();
+        g_shaderVariantsPending = gbufferShaders.getPendingCount() + lightingShaders.getPendingCount() +
+                                  lightVolumeShaders.getPendingCount() + lightVolumeStencilShaders.getPendingCount();
+
         // Update frustum with current view-projection matrix
         glm::mat4 viewProjection = projection * camera.getViewMatrix();
         frustum.extractPlanes(viewProjection);
         
-        // Geometry pass: Render to G-Buffer with frustum culling
+        // Geometry pass: Render to G-Buffer with frustum culling and LOD selection
         std::vector<glm::mat4> modelMatrices;
         std::vector<PBRMesh*> visibleMeshes;
+        std::vector<int> lodLevels;
+        std::vector<const MeshletDrawList*> meshletDraws;
         
         // Always render the plane (ground)
         modelMatrices.push_back(glm::mat4(1.0f)); // Identity matrix for plane
         visibleMeshes.push_back(&planeMesh);
+        lodLevels.push_back(0);
+        meshletDraws.push_back(nullptr);
+        g_drawnTriangles = planeMesh.getIndexCount() / 3;
+        g_meshletStats.reset();
         
-        // Frustum culling for bunnies
+        // Plane texture detail: the screen size of one texture repeat at the plane's closest point
+        BoundingBox planeBounds = planeMesh.getBoundingBox();
+        glm::vec3 planeClosest = glm::clamp(camera.getPosition(), planeBounds.getMin(), planeBounds.getMax());
+        planeMesh.getMaterial().requestResolution(
+            LODSelector::projectedDiameter(planeClosest, PLANE_UV_REPEAT_SIZE * 0.5f, camera.getPosition(),
+                                           glm::radians(CAMERA_FOV_DEGREES), (float)WINDOW_HEIGHT));
+        
+        // Frustum culling, then screen-size LOD selection for bunnies
         g_culledObjects = 0;
-        if (g_frustumCullingEnabled) {
-            // Frustum culling enabled - only render visible bunnies
-            for (const auto& transform : bunnyTransforms) {
-                // Transform bunny bounding box to world space
-                BoundingBox worldBoundingBox = g_bunnyBoundingBox.transform(transform);
-                
-                // Check if bunny is visible
-                if (frustum.isBoundingBoxInside(worldBoundingBox)) {
-                    modelMatrices.push_back(transform);
-                    visibleMeshes.push_back(&bunnyMesh);
-                } else {
-                    g_culledObjects++;
+        g_smallCulledObjects = 0;
+        std::fill(std::begin(g_lodInstanceCounts), std::end(g_lodInstanceCounts), 0);
+        glm::vec3 bunnyCenter = g_bunnyBoundingBox.getCenter();
+        float bunnyRadius = g_bunnyBoundingBox.getBoundingSphereRadius();
+        float bunnyTexturePixels = 0.0f;  // Largest visible bunny, which sets the detail its textures need
+        for (size_t i = 0; i < bunnyTransforms.size(); ++i) {
+            const glm::mat4& transform = bunnyTransforms[i];
+            
+            // Check if bunny is visible (transform bunny bounding box to world space)
+            if (g_frustumCullingEnabled && !frustum.isBoundingBoxInside(g_bunnyBoundingBox.transform(transform))) {
+                g_culledObjects++;
+                bunnyLODs[i] = -1;
+                continue;
+            }
+            
+            // World-space bounding sphere: the largest axis scale bounds the radius
+            glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(bunnyCenter, 1.0f));
+            float scale = std::max({glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])),
+                                    glm::length(glm::vec3(transform[2]))});
+            float pixels = LODSelector::projectedDiameter(worldCenter, bunnyRadius * scale, camera.getPosition(),
+                                                          glm::radians(CAMERA_FOV_DEGREES), (float)WINDOW_HEIGHT);
+            
+            int lod = 0;
+            if (g_lodEnabled) {
+                lod = lodSelector.select(pixels, bunnyLODs[i], bunnyMesh->getLODCount());
+                bunnyLODs[i] = lod;
+                if (lod < 0) {
+                    g_smallCulledObjects++;
+                    continue;
                 }
+            } else {
+                bunnyLODs[i] = -1;
             }
-        } else {
-            // Frustum culling disabled - render all bunnies
-            for (const auto& transform : bunnyTransforms) {
-                modelMatrices.push_back(transform);
-                visibleMeshes.push_back(&bunnyMesh);
+            
+            // Full-detail instances are drawn meshlet by meshlet, skipping off-screen and back-facing clusters
+            const MeshletDrawList* meshletDraw = nullptr;
+            if (lod == 0 && g_meshletCullingEnabled && !bunnyMesh->getMeshlets().empty()) {
+                MeshletDrawList& drawList = bunnyMeshletDraws[i];
+                drawList.clear();
+                size_t rejectedBefore = g_meshletStats.trianglesRejected;
+                cullMeshlets(bunnyMesh->getMeshlets(), viewProjection, transform, camera.getPosition(), drawList,
+                             g_meshletStats);
+                if (drawList.empty()) {
+                    continue;
+                }
+                meshletDraw = &drawList;
+                g_drawnTriangles -= (long long)(g_meshletStats.trianglesRejected - rejectedBefore);
             }
-            g_culledObjects = 0;  // No culling when disabled
+            
+            bunnyTexturePixels = std::max(bunnyTexturePixels, pixels);
+            modelMatrices.push_back(transform);
+            visibleMeshes.push_back(bunnyMesh.get());
+            lodLevels.push_back(lod);
+            meshletDraws.push_back(meshletDraw);
+            g_lodInstanceCounts[std::min(lod, 3)]++;
+            g_drawnTriangles += bunnyMesh->getLOD(lod).indexCount / 3;
+        }
+        
+        if (bunnyTexturePixels > 0.0f) {
+            bunnyMesh->getMaterial().requestResolution(bunnyTexturePixels);
         }
         
         // Update visible objects count for ImGui
         g_visibleObjects = (int)visibleMeshes.size();
         
         // Use visible meshes from frustum culling
-        deferredRenderer.renderGeometryPass(visibleMeshes, modelMatrices, gbufferShader, camera.getViewMatrix(), projection);
+        deferredRenderer.renderGeometryPass(visibleMeshes, modelMatrices, gbufferShaders, camera.getViewMatrix(),
+                                            projection, lodLevels, meshletDraws, &materialPool, g_activeShaderQuality);
+        g_materialBinds = deferredRenderer.getMaterialBindCount();
 
         // Lighting pass: Calculate lighting and display result
-        deferredLightingShader.use();
-        
-        // Set up light uniforms for deferred lighting
-        std::vector<glm::vec3> lightPositions;
-        std::vector<glm::vec3> lightColors;
-        
-        // Add original 4 point lights
-        lightPositions.push_back(pointLight1->getPosition());
-        lightPositions.push_back(pointLight2->getPosition());
-        lightPositions.push_back(pointLight3->getPosition());
-        lightPositions.push_back(pointLight4->getPosition());
-        
-        lightColors.push_back(pointLight1->getColor());
-        lightColors.push_back(pointLight2->getColor());
-        lightColors.push_back(pointLight3->getColor());
-        lightColors.push_back(pointLight4->getColor());
-        
-        // Add all 100 grid lights
-        for (const auto& light : gridLights) {
-            lightPositions.push_back(light->getPosition());
-            lightColors.push_back(light->getColor());
+        // Only lights that changed since last frame are sent to the light buffers
+        setExtraLightCount(g_extraLights);
+        lightCuller.setEnabled(g_lightCulling);
+        lightCuller.setBudget(g_lightBudget);
+        lightCuller.cull(lightManager, frustum, camera.getPosition(), glm::radians(CAMERA_FOV_DEGREES),
+                         (float)WINDOW_HEIGHT, deltaTime);
+        g_lightCullStats = lightCuller.getStats();
+        lightManager.upload();
+        g_lightStats = lightManager.getStats();
+
+        // Shadow tiles whose light or casters changed, within the update budget; the rest stay cached
+        if (g_shadows) {
+            shadowAtlas.setUpdateBudget(g_shadowUpdateBudget);
+            shadowAtlas.setCasters(shadowCasters);
+            shadowAtlas.update(lightManager, *shadowDepthShader, camera.getViewMatrix(),
+                               glm::radians(CAMERA_FOV_DEGREES), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT,
+                               CAMERA_NEAR_PLANE, (float)WINDOW_HEIGHT);
+            g_shadowStats = shadowAtlas.getStats();
         }
         
-        // Set spotlight positions, directions, colors, and cutoffs
-        std::vector<glm::vec3> spotLightPositions = {
-            spotLight1->getPosition(),
-            spotLight2->getPosition(),
-            spotLight3->getPosition(),
-            spotLight4->getPosition()
-        };
-        std::vector<glm::vec3> spotLightDirections = {
-            spotLight1->getDirection(),
-            spotLight2->getDirection(),
-            spotLight3->getDirection(),
-            spotLight4->getDirection()
-        };
-        std::vector<glm::vec3> spotLightColors = {
-            spotLight1->getColor(),
-            spotLight2->getColor(),
-            spotLight3->getColor(),
-            spotLight4->getColor()
-        };
-        std::vector<float> spotLightInnerCutoffs = {
-            spotLight1->getInnerCutoff(),
-            spotLight2->getInnerCutoff(),
-            spotLight3->getInnerCutoff(),
-            spotLight4->getInnerCutoff()
-        };
-        std::vector<float> spotLightOuterCutoffs = {
-            spotLight1->getOuterCutoff(),
-            spotLight2->getOuterCutoff(),
-            spotLight3->getOuterCutoff(),
-            spotLight4->getOuterCutoff()
-        };
-        
-        // Set all light uniforms (up to 64 lights supported)
-        for (int i = 0; i < 64; i++) {
-            if (i < lightPositions.size()) {
-                deferredLightingShader.setVec3("lightPositions[" + std::to_string(i) + "]", lightPositions[i]);
-                deferredLightingShader.setVec3("lightColors[" + std::to_string(i) + "]", lightColors[i]);
-            } else {
-                // Set unused lights to zero
-                deferredLightingShader.setVec3("lightPositions[" + std::to_string(i) + "]", glm::vec3(0.0f));
-                deferredLightingShader.setVec3("lightColors[" + std::to_string(i) + "]", glm::vec3(0.0f));
+        Shader& deferredLightingShader = lightingShaders.get(lightingKeyFor(g_activeShaderQuality));
+        if (g_lightVolumes) {
+            LightVolumeShaders volumeShaders{
+                deferredLightingShader,
+                lightVolumeShaders.get({ShaderFeaturePointVolume, g_activeShaderQuality}),
+                lightVolumeShaders.get(spotVolumeKeyFor(g_activeShaderQuality)),
+                lightVolumeStencilShaders.get({ShaderFeaturePointVolume, ShaderQuality::High}),
+                lightVolumeStencilShaders.get({ShaderFeatureSpotVolume, ShaderQuality::High}),
+                *tonemapShader,
+            };
+            if (g_shadows) {
+                for (Shader* shader : {&volumeShaders.fullScreen, &volumeShaders.spotLights}) {
+                    shader->use();
+                    shadowAtlas.bind(*shader, SHADOW_ATLAS_TEXTURE_UNIT);
+                }
             }
-            
-            if (i < spotLightPositions.size()) {
-                deferredLightingShader.setVec3("spotLightPositions[" + std::to_string(i) + "]", spotLightPositions[i]);
-                deferredLightingShader.setVec3("spotLightDirections[" + std::to_string(i) + "]", spotLightDirections[i]);
-                deferredLightingShader.setVec3("spotLightColors[" + std::to_string(i) + "]", spotLightColors[i]);
-                deferredLightingShader.setFloat("spotLightInnerCutoffs[" + std::to_string(i) + "]", spotLightInnerCutoffs[i]);
-                deferredLightingShader.setFloat("spotLightOuterCutoffs[" + std::to_string(i) + "]", spotLightOuterCutoffs[i]);
-            } else {
-                // Set unused spotlights to zero
-                deferredLightingShader.setVec3("spotLightPositions[" + std::to_string(i) + "]", glm::vec3(0.0f));
-                deferredLightingShader.setVec3("spotLightDirections[" + std::to_string(i) + "]", glm::vec3(0.0f));
-                deferredLightingShader.setVec3("spotLightColors[" + std::to_string(i) + "]", glm::vec3(0.0f));
-                deferredLightingShader.setFloat("spotLightInnerCutoffs[" + std::to_string(i) + "]", 0.0f);
-                deferredLightingShader.setFloat("spotLightOuterCutoffs[" + std::to_string(i) + "]", 0.0f);
+            deferredRenderer.renderLightVolumes(volumeShaders, lightManager, LIGHT_BUFFER_TEXTURE_UNIT,
+                                                camera.getViewMatrix(), projection, camera.getPosition());
+        } else {
+            deferredLightingShader.use();
+            lightManager.bind(deferredLightingShader, LIGHT_BUFFER_TEXTURE_UNIT);
+            if (g_shadows) {
+                shadowAtlas.bind(deferredLightingShader, SHADOW_ATLAS_TEXTURE_UNIT);
+            }
+            if (g_clusteredShading) {
+                lightClusters.build(lightManager, camera.getViewMatrix(), projection, CAMERA_NEAR_PLANE,
+                                    CAMERA_FAR_PLANE, WINDOW_WIDTH, WINDOW_HEIGHT);
+                g_clusterStats = lightClusters.getStats();
+                lightClusters.bind(deferredLightingShader, LIGHT_CLUSTER_TEXTURE_UNIT);
             }
+
+            deferredRenderer.renderLightingPass(deferredLightingShader, camera.getPosition());
         }
-        
-        // Set directional light
-        deferredLightingShader.setVec3("dirLightDirection", directionalLight->getDirection());
-        deferredLightingShader.setVec3("dirLightColor", directionalLight->getColor());
-        deferredLightingShader.setBool("hasDirLight", true);
-        
-        deferredLightingShader.setInt("numLights", lightPositions.size());
-        deferredLightingShader.setInt("numSpotLights", spotLightPositions.size());
-        
-        deferredRenderer.renderLightingPass(deferredLightingShader, camera.getPosition());
 
         // Render ImGui
         ImGui::Render();
@@ -509,11 +805,30 @@ int main() {
 
         // Swap buffers
         SDL_GL_SwapWindow(g_window);
+        if (g_firstFrameMs == 0.0) {
+            g_firstFrameMs = millisecondsSinceStartup();
+            std::cout << "First frame " << g_firstFrameMs << " ms after startup" << std::endl;
+            const ProgramCacheStats& programCacheStats = getProgramCacheStats();
+            std::cout << "Shader program cache: " << programCacheStats.hits << " hits, " << programCacheStats.misses
+                      << " misses, " << programCacheStats.savedMs << " ms saved" << std::endl;
+        }
     }
 
     // ===== CLEANUP =====
+    textureLoader.destroy();
     planeMesh.destroy();
-    bunnyMesh.destroy();
+    bunnyMesh.reset();  // Last handles release the GL objects
+    materialPool.destroy();
+    gbufferShaders.clear();
+    lightingShaders.clear();
+    lightVolumeShaders.clear();
+    lightVolumeStencilShaders.clear();
+    tonemapShader.reset();
+    shadowDepthShader.reset();
+    shadowAtlas.destroy();
+    lightClusters.destroy();
+    extraLights.clear();
+    lightManager.destroy();
     deferredRenderer.cleanup();
 
     ImGui_ImplOpenGL3_Shutdown();
@@ -525,6 +840,20 @@ int main() {
 }
 
 // Implementation of helper functions
+
+// Lighting shader feature of the path chosen in the UI
+uint32_t lightingPathFeature() {
+    if (g_lightVolumes) {
+        return ShaderFeatureLightVolumes;
+    }
+    return g_clusteredShading ? (uint32_t)ShaderFeatureClustered : 0u;
+}
+
+// Lighting shader feature of the shadow toggle
+uint32_t shadowFeature() {
+    return g_shadows ? (uint32_t)ShaderFeatureShadows : 0u;
+}
+
 bool initializeSDL() {
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         std::cerr << "SDL could not initialize! SDL_Error: " << SDL_GetError() << std::endl;
@@ -567,6 +896,7 @@ bool initializeOpenGL() {
         std::cerr << "Failed to initialize GLAD" << std::endl;
         return false;
     }
+    Shader::enableParallelCompile((GLADloadproc)SDL_GL_GetProcAddress);
     
     // Enable backface culling for better performance
     glEnable(GL_CULL_FACE);
@@ -656,81 +986,71 @@ void renderImGui(Camera& camera, float currentFPS, float deltaTime, bool cameraM
         } else {
             ImGui::Text("Culling: DISABLED (all objects rendered)");
         }
-        ImGui::Text("Lights: 54 (4 original + 50 grid lights)");
+        ImGui::Checkbox("Screen-size LOD", &g_lodEnabled);
+        ImGui::Text("Too small to draw: %d", g_smallCulledObjects);
+        ImGui::Text("LOD 0/1/2/3: %d / %d / %d / %d", g_lodInstanceCounts[0], g_lodInstanceCounts[1],
+                    g_lodInstanceCounts[2], g_lodInstanceCounts[3]);
+        ImGui::Text("Triangles: %lld", g_drawnTriangles);
+        ImGui::Checkbox("Meshlet Culling", &g_meshletCullingEnabled);
+        ImGui::Text("Meshlets: %zu tested, %zu frustum / %zu cone culled", g_meshletStats.meshletsTested,
+                    g_meshletStats.meshletsFrustumCulled, g_meshletStats.meshletsConeCulled);
+        ImGui::Text("Meshlet triangles rejected: %zu of %zu", g_meshletStats.trianglesRejected,
+                    g_meshletStats.trianglesTested);
+        ImGui::Text("Textures: %zu loaded, %zu pending, %zu failed", g_textureStats.uploaded,
+                    g_textureStats.pending, g_textureStats.failed);
+        ImGui::Text("Texture upload: %.2f ms (worst %.2f ms)", g_textureStats.lastUpdateMs, g_textureStats.maxUpdateMs);
+        ImGui::SliderInt("Texture budget (MB)", &g_textureBudgetMB, 16, 1024);
+        ImGui::Text("Streamed mips: %.1f MB resident, %.1f MB used, %zu textures (%zu in, %zu evicted)",
+                    g_streamingStats.residentBytes / (1024.0 * 1024.0), g_streamingStats.usedBytes / (1024.0 * 1024.0),
+                    g_streamingStats.textures, g_streamingStats.levelsStreamed, g_streamingStats.levelsEvicted);
+        ImGui::Text("Material pools: %.1f MB of the budget", g_streamingStats.pinnedBytes / (1024.0 * 1024.0));
+        ImGui::Text("Startup: first frame %.0f ms, textures ready %.0f ms", g_firstFrameMs, g_texturesReadyMs);
+        ImGui::Text("Assets: %zu live, %.1f MB GPU (%zu shared, %zu loaded)", g_liveAssets,
+                    g_assetGPUBytes / (1024.0 * 1024.0), g_assetStats.hits, g_assetStats.misses);
+        ImGui::Text("Materials: %d pooled in %d arrays (%.1f MB), %d texture binds per frame", g_pooledMaterials,
+                    g_materialPools, g_materialPoolBytes / (1024.0 * 1024.0), g_materialBinds);
+        int shaderQuality = (int)g_shaderQuality;
+        if (ImGui::Combo("Shading quality", &shaderQuality, "Low\0Medium\0High\0")) {
+            g_shaderQuality = (ShaderQuality)shaderQuality;
+        }
+        ImGui::Text("Shader variants: %zu compiled, %zu still building", g_shaderVariants, g_shaderVariantsPending);
+        ImGui::Text("Lights: %zu (%zu uploaded last frame, %zu bytes)", g_lightStats.lights,
+                    g_lightStats.lightsUploaded, g_lightStats.bytesUploaded);
+        ImGui::SliderInt("Extra point lights", &g_extraLights, 0, MAX_EXTRA_LIGHTS);
+        ImGui::Checkbox("Light culling", &g_lightCulling);
+        if (g_lightCulling) {
+            ImGui::SliderInt("Light budget", &g_lightBudget, 1, MAX_EXTRA_LIGHTS);
+            ImGui::Text("Lights shaded: %d of %d (%d outside view, %d over budget, %d fading), %.2f ms",
+                        g_lightCullStats.shaded, g_lightCullStats.considered, g_lightCullStats.frustumCulled,
+                        g_lightCullStats.budgetDropped, g_lightCullStats.fading, g_lightCullStats.cullMs);
+        }
+        ImGui::Checkbox("Shadows", &g_shadows);
+        if (g_shadows) {
+            ImGui::SliderInt("Shadow tile updates per frame", &g_shadowUpdateBudget, 1, 8);
+            ImGui::Text("Shadow maps: %d cascades, %d spotlights (%d tiles cached)", g_shadowStats.cascades,
+                        g_shadowStats.spotShadows, g_shadowStats.cachedTiles);
+            ImGui::Text("Shadow tiles: %d rendered, %d waiting; casters %d drawn, %d culled; %.2f ms",
+                        g_shadowStats.tilesRendered, g_shadowStats.tilesStale, g_shadowStats.castersDrawn,
+                        g_shadowStats.castersCulled, g_shadowStats.updateMs);
+        }
+        ImGui::Checkbox("Light volumes", &g_lightVolumes);
+        ImGui::Checkbox("Clustered shading", &g_clusteredShading);
+        if (g_clusteredShading && !g_lightVolumes) {
+            ImGui::Text("Clusters: %d, %zu light entries (at most %d per cluster), built in %.2f ms",
+                        g_clusterStats.clusters, g_clusterStats.lightIndices, g_clusterStats.maxClusterLights,
+                        g_clusterStats.buildMs);
+        }
     
     ImGui::Separator();
     ImGui::Text("Lights");
     ImGui::Text("Point Lights: 4 (White, Green, Red, Blue)");
     ImGui::Text("Spotlights: 4 (Yellow, Magenta, Cyan, Orange)");
     ImGui::Text("Directional Light: 1 (Sun-like)");
-    ImGui::Text("Total: 9 lights");
-    ImGui::Text("Max Capacity: 64 point lights + 64 spotlights");
+    ImGui::Text("Grid: 50 point lights, plus the extra lights above");
     
     ImGui::End();
 }
 
-// Function to calculate tangents and bitangents for normal mapping
-std::vector<Vertex> calculateTangentsBitangents(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices) {
-    std::vector<Vertex> result = vertices;
-    
-    // Initialize tangents and bitangents to zero
-    for (auto& vertex : result) {
-        vertex.tangent = glm::vec3(0.0f);
-        vertex.bitangent = glm::vec3(0.0f);
-    }
-    
-    // Calculate tangents and bitangents for each triangle
-    for (size_t i = 0; i < indices.size(); i += 3) {
-        GLuint i0 = indices[i];
-        GLuint i1 = indices[i + 1];
-        GLuint i2 = indices[i + 2];
-        
-        Vertex& v0 = result[i0];
-        Vertex& v1 = result[i1];
-        Vertex& v2 = result[i2];
-        
-        // Calculate edges
-        glm::vec3 edge1 = v1.position - v0.position;
-        glm::vec3 edge2 = v2.position - v0.position;
-        
-        // Calculate texture coordinate differences
-        glm::vec2 deltaUV1 = v1.texCoord - v0.texCoord;
-        glm::vec2 deltaUV2 = v2.texCoord - v0.texCoord;
-        
-        // Calculate tangent and bitangent
-        float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-        
-        glm::vec3 tangent;
-        tangent.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-        tangent.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-        tangent.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-        tangent = glm::normalize(tangent);
-        
-        glm::vec3 bitangent;
-        bitangent.x = f * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x);
-        bitangent.y = f * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y);
-        bitangent.z = f * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
-        bitangent = glm::normalize(bitangent);
-        
-        // Accumulate tangents and bitangents
-        v0.tangent += tangent;
-        v1.tangent += tangent;
-        v2.tangent += tangent;
-        
-        v0.bitangent += bitangent;
-        v1.bitangent += bitangent;
-        v2.bitangent += bitangent;
-    }
-    
-    // Normalize accumulated tangents and bitangents
-    for (auto& vertex : result) {
-        vertex.tangent = glm::normalize(vertex.tangent);
-        vertex.bitangent = glm::normalize(vertex.bitangent);
-    }
-    
-    return result;
-}
-
 std::vector<Vertex> createPlaneVertices() {
     return {
         Vertex(glm::vec3(-5.0f, 0.0f, -5.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec2(0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)),
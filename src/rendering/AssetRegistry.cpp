@@ -0,0 +1,129 @@
+#include "rendering/AssetRegistry.h"
+#include "rendering/TextureLoader.h"
+#include "utils/MappedFile.h"
+#include <filesystem>
+
+namespace {
+    // Drop entries whose asset has been released
+    template<typename Map>
+    void pruneReleased(Map& entries) {
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (it->second.asset.expired()) {
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+uint64_t AssetRegistry::fileKey(const std::string& path) {
+    std::error_code error;
+    auto size = std::filesystem::file_size(path, error);
+    auto time = error ? std::filesystem::file_time_type() : std::filesystem::last_write_time(path, error);
+    if (error) {
+        return hashString(path);
+    }
+
+    FileFingerprint& fingerprint = fingerprints[path];
+    int64_t modifiedTime = (int64_t)time.time_since_epoch().count();
+    if (fingerprint.contentHash != 0 && fingerprint.size == size && fingerprint.modifiedTime == modifiedTime) {
+        return fingerprint.contentHash;
+    }
+
+    MappedFile file(path);
+    if (!file.isOpen()) {
+        fingerprints.erase(path);
+        return hashString(path);
+    }
+    fingerprint.size = size;
+    fingerprint.modifiedTime = modifiedTime;
+    fingerprint.contentHash = hashBytes(file.data(), file.size());
+    return fingerprint.contentHash;
+}
+
+std::shared_ptr<Texture> AssetRegistry::getTexture(const std::string& path, TextureType type, TextureLoader* loader) {
+    uint64_t key = hashCombine(fileKey(path), (uint64_t)type);
+    auto found = textures.find(key);
+    if (found != textures.end()) {
+        if (auto texture = found->second.asset.lock()) {
+            ++stats.hits;
+            return texture;
+        }
+    }
+
+    ++stats.misses;
+    std::shared_ptr<Texture> texture(loader ? new Texture(path.c_str(), type, *loader)
+                                            : new Texture(path.c_str(), type),
+                                     TextureDeleter());
+    textures[key] = {path, texture};
+    return texture;
+}
+
+std::shared_ptr<Texture> AssetRegistry::getORMTexture(const ORMSources& sources, TextureLoader& loader) {
+    uint64_t key = hashCombine(hashCombine(hashCombine(fileKey(sources.ao), fileKey(sources.roughness)),
+                                           fileKey(sources.metallic)), (uint64_t)TextureType::ORM);
+    auto found = textures.find(key);
+    if (found != textures.end()) {
+        if (auto texture = found->second.asset.lock()) {
+            ++stats.hits;
+            return texture;
+        }
+    }
+
+    ++stats.misses;
+    std::shared_ptr<Texture> texture(new Texture(sources, loader), TextureDeleter());
+    textures[key] = {texture->path, texture};
+    return texture;
+}
+
+std::shared_ptr<Shader> AssetRegistry::getShader(const std::string& vertexPath, const std::string& fragmentPath,
+                                                 const std::vector<std::string>& defines) {
+    uint64_t key = hashCombine(fileKey(vertexPath), fileKey(fragmentPath));
+    std::string name = vertexPath + " + " + fragmentPath;
+    for (const std::string& define : defines) {
+        key = hashCombine(key, hashString(define));
+        name += " [" + define + "]";
+    }
+    auto found = shaders.find(key);
+    if (found != shaders.end()) {
+        if (auto shader = found->second.asset.lock()) {
+            ++stats.hits;
+            return shader;
+        }
+    }
+
+    ++stats.misses;
+    std::shared_ptr<Shader> shader(new Shader(vertexPath.c_str(), fragmentPath.c_str(), defines), [](Shader* program) {
+        program->destroy();
+        delete program;
+    });
+    shaders[key] = {name, shader};
+    return shader;
+}
+
+std::vector<AssetMemoryInfo> AssetRegistry::getMemoryReport() {
+    pruneReleased(textures);
+    pruneReleased(shaders);
+    pruneReleased(meshes);
+
+    std::vector<AssetMemoryInfo> report;
+    for (const auto& [key, entry] : textures) {
+        long handles = entry.asset.use_count();  // Before lock() adds one
+        if (auto texture = entry.asset.lock()) {
+            report.push_back({entry.name, "texture", texture->getGPUMemorySize(), handles});
+        }
+    }
+    for (const auto& [key, entry] : meshes) {
+        long handles = entry.asset.use_count();
+        if (auto mesh = entry.asset.lock()) {
+            report.push_back({entry.name, "mesh", mesh->getGPUMemorySize(), handles});
+        }
+    }
+    for (const auto& [key, entry] : shaders) {
+        if (!entry.asset.expired()) {
+            report.push_back({entry.name, "shader", 0, entry.asset.use_count()});
+        }
+    }
+    return report;
+}
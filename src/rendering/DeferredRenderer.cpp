@@ -1,6 +1,76 @@
 #include "rendering/DeferredRenderer.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <numeric>
+#include <glm/gtc/constants.hpp>
+
+namespace {
+    const Uniform<glm::mat4> modelUniform("model");
+    const Uniform<glm::mat4> viewUniform("view");
+    const Uniform<glm::mat4> projectionUniform("projection");
+    const Uniform<int> albedoArrayUniform("albedoArray");
+    const Uniform<int> normalArrayUniform("normalArray");
+    const Uniform<int> ormArrayUniform("ormArray");
+    const Uniform<glm::vec3> viewPosUniform("viewPos");
+    const Uniform<int> gPositionUniform("gPosition");
+    const Uniform<int> gNormalUniform("gNormal");
+    const Uniform<int> gAlbedoUniform("gAlbedo");
+    const Uniform<int> gMetallicRoughnessUniform("gMetallicRoughness");
+    const Uniform<int> gAOUniform("gAO");
+    const Uniform<glm::vec2> screenSizeUniform("screenSize");
+    const Uniform<bool> spotSpheresUniform("spotSpheres");
+    const Uniform<int> lightAccumulationUniform("lightAccumulation");
+
+    // Stencil bits: the geometry pass sets the top one where it draws, and the light-volume stencil pass counts
+    // volumes in the others (modulo 128)
+    constexpr GLuint coveredStencilBit = 0x80;
+    constexpr GLuint volumeCountMask = 0x7F;
+
+    // Light volume tessellation: segments around, and rings from pole to pole of the sphere
+    constexpr int volumeSegments = 16;
+    constexpr int sphereRings = 8;
+
+    // Unit sphere, pushed out so its flat faces and not just its corners enclose the sphere
+    void buildSphere(std::vector<glm::vec3>& vertices, std::vector<GLuint>& indices) {
+        float scale = 1.0f / (std::cos(glm::pi<float>() / volumeSegments) *
+                              std::cos(glm::pi<float>() / (2 * sphereRings)));
+        for (int ring = 0; ring <= sphereRings; ++ring) {
+            float theta = glm::pi<float>() * ring / sphereRings;
+            for (int segment = 0; segment < volumeSegments; ++segment) {
+                float phi = glm::two_pi<float>() * segment / volumeSegments;
+                vertices.push_back(scale * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta),
+                                                     std::sin(theta) * std::sin(phi)));
+            }
+        }
+        for (int ring = 0; ring < sphereRings; ++ring) {
+            for (int segment = 0; segment < volumeSegments; ++segment) {
+                GLuint a = ring * volumeSegments + segment;
+                GLuint b = ring * volumeSegments + (segment + 1) % volumeSegments;
+                GLuint c = a + volumeSegments;
+                GLuint d = b + volumeSegments;
+                indices.insert(indices.end(), {a, b, c, b, d, c});
+            }
+        }
+    }
+
+    // Cone with its apex at the origin and a unit radius base at z = 1, pushed out like the sphere
+    void buildCone(std::vector<glm::vec3>& vertices, std::vector<GLuint>& indices) {
+        float scale = 1.0f / std::cos(glm::pi<float>() / volumeSegments);
+        vertices.push_back(glm::vec3(0.0f));
+        vertices.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+        for (int segment = 0; segment < volumeSegments; ++segment) {
+            float phi = glm::two_pi<float>() * segment / volumeSegments;
+            vertices.push_back(glm::vec3(scale * std::cos(phi), scale * std::sin(phi), 1.0f));
+        }
+        for (int segment = 0; segment < volumeSegments; ++segment) {
+            GLuint a = 2 + segment;
+            GLuint b = 2 + (segment + 1) % volumeSegments;
+            indices.insert(indices.end(), {0, b, a, 1, a, b});
+        }
+    }
+}
 
 DeferredRenderer::DeferredRenderer(int width, int height):
     width(width), height(height), gBuffer(0), gPosition(0), gNormal(0), gAlbedo(0), gAO(0), gMetallicRoughness(0), depthBuffer(0) {
@@ -54,11 +124,11 @@ bool DeferredRenderer::initialize(){
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT4, GL_TEXTURE_2D, gAO, 0);
 
-    // Create depth buffer
+    // Create depth buffer, with stencil for the light passes
     glGenRenderbuffers(1, &depthBuffer);
     glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, width, height);
-    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
 
     GLuint attachments[5] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3, GL_COLOR_ATTACHMENT4 };
     glDrawBuffers(5, attachments);
@@ -74,27 +144,126 @@ bool DeferredRenderer::initialize(){
     // Create full-screen quad for lighting pass
     createScreenQuad();
 
+    if (!createLightVolumes()) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        return false;
+    }
+
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
     return true; 
 }
 
+bool DeferredRenderer::createLightVolumes() {
+    glGenTextures(1, &lightAccumulation);
+    glBindTexture(GL_TEXTURE_2D, lightAccumulation);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenFramebuffers(1, &lightBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, lightBuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, lightAccumulation, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Light accumulation framebuffer is not complete!" << std::endl;
+        return false;
+    }
+
+    auto upload = [](VolumeMesh& mesh, const std::vector<glm::vec3>& vertices, const std::vector<GLuint>& indices) {
+        glGenVertexArrays(1, &mesh.vao);
+        glGenBuffers(1, &mesh.vbo);
+        glGenBuffers(1, &mesh.ebo);
+        glBindVertexArray(mesh.vao);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        glBindVertexArray(0);
+        mesh.indexCount = (GLsizei)indices.size();
+    };
+    std::vector<glm::vec3> vertices;
+    std::vector<GLuint> indices;
+    buildSphere(vertices, indices);
+    upload(sphereVolume, vertices, indices);
+    vertices.clear();
+    indices.clear();
+    buildCone(vertices, indices);
+    upload(coneVolume, vertices, indices);
+    return true;
+}
+
 void DeferredRenderer::renderGeometryPass(const std::vector<PBRMesh*>& meshes, 
                                          const std::vector<glm::mat4>& modelMatrices,
-                                         Shader& geometryShader, 
+                                         ShaderPermutations& geometryShaders, 
                                          const glm::mat4& viewMatrix, 
-                                         const glm::mat4& projectionMatrix){
+                                         const glm::mat4& projectionMatrix,
+                                         const std::vector<int>& lodLevels,
+                                         const std::vector<const MeshletDrawList*>& meshletDraws,
+                                         const MaterialPool* materialPool,
+                                         ShaderQuality quality){
         std::cout << "Starting geometry pass with " << meshes.size() << " meshes" << std::endl;
         bindGBuffer();
 
-        geometryShader.use();
-        geometryShader.setMat4("view", viewMatrix);
-        geometryShader.setMat4("projection", projectionMatrix);
+        // Mark the pixels geometry covers, for the light passes
+        glEnable(GL_STENCIL_TEST);
+        glStencilFunc(GL_ALWAYS, coveredStencilBit, coveredStencilBit);
+        glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+        glStencilMask(coveredStencilBit);
+
+        // Variant and pool of each mesh's material (pool -1 for materials with their own textures)
+        auto shaderFor = [&](const PBRMaterial& material) -> Shader& {
+            ShaderVariantKey key;
+            key.features = material.getShaderFeatures();
+            key.quality = quality;
+            return geometryShaders.get(key);
+        };
+        auto poolOf = [&](size_t i) {
+            const PBRMaterial& material = meshes[i]->getMaterial();
+            return material.usesMaterialPool() && materialPool ? material.getPoolSlot().pool : -1;
+        };
+
+        // Draw pooled materials together, one pool at a time; the rest keep their order
+        std::vector<size_t> order(meshes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return poolOf(a) > poolOf(b); });
+
+        // Switch programs only when the variant changes, and pool arrays only when the pool does
+        Shader* boundShader = nullptr;
+        int boundPool = -1;
+        materialBindCount = 0;
+        for (size_t i : order){
+            const PBRMaterial& material = meshes[i]->getMaterial();
+            Shader& shader = shaderFor(material);
+            if (boundShader != &shader) {
+                shader.use();
+                shader.set(viewUniform, viewMatrix);
+                shader.set(projectionUniform, projectionMatrix);
+                boundShader = &shader;
+                boundPool = -1;
+            }
+            int pool = poolOf(i);
+            if (pool >= 0 && pool != boundPool) {
+                materialPool->bind(pool, GL_TEXTURE0);
+                shader.set(albedoArrayUniform, 0);
+                shader.set(normalArrayUniform, 1);
+                shader.set(ormArrayUniform, 2);
+                boundPool = pool;
+                ++materialBindCount;
+            } else if (pool < 0) {
+                ++materialBindCount;
+            }
 
-        for (size_t i = 0; i < meshes.size(); ++i){
             glm::mat4 modelMatrix = (i < modelMatrices.size()) ? modelMatrices[i] : glm::mat4(1.0f);
-            geometryShader.setMat4("model", modelMatrix);
+            shader.set(modelUniform, modelMatrix);
             std::cout << "Rendering mesh " << i << " to G-Buffer" << std::endl;
-            meshes[i]->drawPBR(geometryShader);
+            if (i < meshletDraws.size() && meshletDraws[i]) {
+                meshes[i]->drawPBR(shader, *meshletDraws[i]);
+            } else {
+                int lod = (i < lodLevels.size()) ? lodLevels[i] : 0;
+                meshes[i]->drawPBR(shader, lod);
+            }
         }
 
         std::cout << "Geometry pass completed" << std::endl;
@@ -103,8 +272,11 @@ void DeferredRenderer::renderGeometryPass(const std::vector<PBRMesh*>& meshes,
         for (int i = 0; i < 4; i++) {
             glActiveTexture(GL_TEXTURE0 + i);
             glBindTexture(GL_TEXTURE_2D, 0);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
         }
 
+        glDisable(GL_STENCIL_TEST);
+        glStencilMask(0xFF);
         unbindGBuffer();
 }
 
@@ -112,28 +284,8 @@ void DeferredRenderer::renderLightingPass(Shader& lightingShader, const glm::vec
     std::cout << "Rendering lighting pass!" << std::endl;
     
     // Shader is already bound in main.cpp, so we don't need to call use() again
-    lightingShader.setVec3("viewPos", viewPos);
-    
-    // Bind G-Buffer textures to texture units 5-8 to match the uniform values
-    glActiveTexture(GL_TEXTURE5);
-    glBindTexture(GL_TEXTURE_2D, gPosition);
-    lightingShader.setInt("gPosition", 5);
-    
-    glActiveTexture(GL_TEXTURE6);
-    glBindTexture(GL_TEXTURE_2D, gNormal);
-    lightingShader.setInt("gNormal", 6);
-    
-    glActiveTexture(GL_TEXTURE7);
-    glBindTexture(GL_TEXTURE_2D, gAlbedo);
-    lightingShader.setInt("gAlbedo", 7);
-    
-    glActiveTexture(GL_TEXTURE8);
-    glBindTexture(GL_TEXTURE_2D, gMetallicRoughness);
-    lightingShader.setInt("gMetallicRoughness", 8);
-    
-    glActiveTexture(GL_TEXTURE9);
-    glBindTexture(GL_TEXTURE_2D, gAO);
-    lightingShader.setInt("gAO", 9);
+    lightingShader.set(viewPosUniform, viewPos);
+    bindGBufferTextures(lightingShader);
     
     // Debug: Check if textures are bound
     std::cout << "G-Buffer textures bound - Position: " << gPosition << ", Normal: " << gNormal 
@@ -159,10 +311,135 @@ void DeferredRenderer::renderLightingPass(Shader& lightingShader, const glm::vec
     std::cout << "Screen quad rendered with VAO: " << quadVAO << std::endl;
 }
 
+void DeferredRenderer::renderLightVolumes(const LightVolumeShaders& shaders, const LightManager& lights,
+                                          int lightBufferUnit, const glm::mat4& viewMatrix,
+                                          const glm::mat4& projectionMatrix, const glm::vec3& viewPos) {
+    glBindFramebuffer(GL_FRAMEBUFFER, lightBuffer);
+    glViewport(0, 0, width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);  // Depth and stencil are the geometry pass's
+    glDepthMask(GL_FALSE);
+    glEnable(GL_STENCIL_TEST);
+
+    // Ambient and directional lights, on every covered pixel
+    glDisable(GL_DEPTH_TEST);
+    glStencilMask(0x00);
+    glStencilFunc(GL_EQUAL, coveredStencilBit, coveredStencilBit);
+    shaders.fullScreen.use();
+    shaders.fullScreen.set(viewPosUniform, viewPos);
+    bindGBufferTextures(shaders.fullScreen);
+    lights.bind(shaders.fullScreen, lightBufferUnit);
+    glBindVertexArray(quadVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+
+    struct VolumePass {
+        Shader& stencil;
+        Shader& lighting;
+        const VolumeMesh& mesh;
+        int count;
+        bool spotSpheres;  // Spotlights through the sphere mesh; light_volume.vert keeps each spot in one of its draws
+    };
+    int spotCount = lights.getShadedCount(LightType::Spot);
+    const VolumePass passes[] = {
+        {shaders.pointStencil, shaders.pointLights, sphereVolume, lights.getShadedCount(LightType::Point), false},
+        {shaders.spotStencil, shaders.spotLights, coneVolume, spotCount, false},
+        {shaders.spotStencil, shaders.spotLights, sphereVolume, spotCount, true},
+    };
+    auto drawVolumes = [&](Shader& shader, const VolumePass& pass) {
+        shader.use();
+        shader.set(viewUniform, viewMatrix);
+        shader.set(projectionUniform, projectionMatrix);
+        shader.set(spotSpheresUniform, pass.spotSpheres);
+        lights.bind(shader, lightBufferUnit);
+        glBindVertexArray(pass.mesh.vao);
+        glDrawElementsInstanced(GL_TRIANGLES, pass.mesh.indexCount, GL_UNSIGNED_INT, nullptr, pass.count);
+    };
+
+    // Stencil: count the volumes each pixel's surface is inside. A volume's back faces behind the surface
+    // count up and its front faces behind it count down, so the volumes the surface is in front of or
+    // behind cancel out. Volumes the camera is inside lose their front faces to the near plane and still add one
+    glEnable(GL_DEPTH_TEST);
+    glDepthFunc(GL_LESS);
+    glDisable(GL_CULL_FACE);
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glStencilMask(volumeCountMask);
+    glStencilFunc(GL_ALWAYS, 0, 0);
+    glStencilOpSeparate(GL_BACK, GL_KEEP, GL_INCR_WRAP, GL_KEEP);
+    glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_DECR_WRAP, GL_KEEP);
+    for (const VolumePass& pass : passes) {
+        if (pass.count > 0) {
+            drawVolumes(pass.stencil, pass);
+        }
+    }
+
+    // Lights: back faces, so volumes around the camera still draw, added up where the count isn't zero. The
+    // count is the union of every volume, not this light's own, so pixels inside other volumes shade too
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_FRONT);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+    glStencilMask(0x00);
+    glStencilFunc(GL_NOTEQUAL, 0, volumeCountMask);
+    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    for (const VolumePass& pass : passes) {
+        if (pass.count > 0) {
+            pass.lighting.use();
+            pass.lighting.set(viewPosUniform, viewPos);
+            pass.lighting.set(screenSizeUniform, glm::vec2((float)width, (float)height));
+            bindGBufferTextures(pass.lighting);
+            drawVolumes(pass.lighting, pass);
+        }
+    }
+
+    glDisable(GL_BLEND);
+    glCullFace(GL_BACK);
+    glDisable(GL_STENCIL_TEST);
+    glStencilMask(0xFF);
+    glDepthMask(GL_TRUE);
+    glEnable(GL_DEPTH_TEST);
+
+    // Tonemap to the screen
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    shaders.resolve.use();
+    glActiveTexture(GL_TEXTURE5);
+    glBindTexture(GL_TEXTURE_2D, lightAccumulation);
+    shaders.resolve.set(lightAccumulationUniform, 5);
+    glBindVertexArray(quadVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+    glBindVertexArray(0);
+}
+
+void DeferredRenderer::bindGBufferTextures(Shader& shader) {
+    glActiveTexture(GL_TEXTURE5);
+    glBindTexture(GL_TEXTURE_2D, gPosition);
+    shader.set(gPositionUniform, 5);
+    
+    glActiveTexture(GL_TEXTURE6);
+    glBindTexture(GL_TEXTURE_2D, gNormal);
+    shader.set(gNormalUniform, 6);
+    
+    glActiveTexture(GL_TEXTURE7);
+    glBindTexture(GL_TEXTURE_2D, gAlbedo);
+    shader.set(gAlbedoUniform, 7);
+    
+    glActiveTexture(GL_TEXTURE8);
+    glBindTexture(GL_TEXTURE_2D, gMetallicRoughness);
+    shader.set(gMetallicRoughnessUniform, 8);
+    
+    glActiveTexture(GL_TEXTURE9);
+    glBindTexture(GL_TEXTURE_2D, gAO);
+    shader.set(gAOUniform, 9);
+}
+
 void DeferredRenderer::bindGBuffer() {
     glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
     glViewport(0, 0, width, height);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Zero albedo alpha marks pixels no geometry covered; the lighting pass skips them
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClearStencil(0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 }
 
 void DeferredRenderer::unbindGBuffer() {
@@ -252,6 +529,22 @@ void DeferredRenderer::cleanup(){
         quadVBO = 0;
     }
 
+    if (lightBuffer) {
+        glDeleteFramebuffers(1, &lightBuffer);
+        lightBuffer = 0;
+        glDeleteTextures(1, &lightAccumulation);
+        lightAccumulation = 0;
+    }
+
+    for (VolumeMesh* mesh : {&sphereVolume, &coneVolume}) {
+        if (mesh->vao) {
+            glDeleteVertexArrays(1, &mesh->vao);
+            glDeleteBuffers(1, &mesh->vbo);
+            glDeleteBuffers(1, &mesh->ebo);
+        }
+        *mesh = {};
+    }
+
     if (depthBuffer) {
         glDeleteRenderbuffers(1, &depthBuffer);
         depthBuffer = 0;
@@ -7,11 +7,11 @@ EBO::EBO(GLuint *indices, GLsizeiptr size) {
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, GL_STATIC_DRAW);
 }
 
-EBO::EBO(const std::vector<GLuint>& indices) {
+EBO::EBO(std::span<const GLuint> indices) {
 	glGenBuffers(1, &id);
 	
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size_bytes(), indices.data(), GL_STATIC_DRAW);
 }
 
 void EBO::bind() {
@@ -0,0 +1,220 @@
+#include "rendering/GeometryProcessing.h"
+#include "rendering/MeshAdjacency.h"
+#include "utils/Parallel.h"
+#include "utils/Simd.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+// Both passes follow the same pattern: compute per-triangle values in parallel, then gather them per vertex
+// through the vertex->triangle adjacency. Each vertex is written by exactly one task, so there are no atomics
+// or per-thread copies of the vertex array. A single thread scatters each triangle's value as it computes it
+// instead, with no staging array or adjacency to build; both visit each vertex's triangles in index order, so
+// results are bit-identical for any thread count.
+
+namespace {
+    // Elements per parallel task
+    constexpr size_t blockSize = 4096;
+
+    template<typename Fn>
+    void parallelBlocks(size_t count, unsigned threadCount, Fn&& fn) {
+        size_t blocks = (count + blockSize - 1) / blockSize;
+        parallelFor(blocks, [&](size_t block) {
+            size_t begin = block * blockSize;
+            size_t end = std::min(begin + blockSize, count);
+            for (size_t i = begin; i < end; ++i) {
+                fn(i);
+            }
+        }, threadCount);
+    }
+
+    // Sum perTriangle(t) into the triangle's vertices through accumulate(vertex, value, corner, first), with each
+    // vertex's triangles in index order. first marks a vertex's first triangle, which assigns instead of adding
+    // so callers don't need a pass to clear their sums. Returns which vertices got any triangle at all (bool, not
+    // uint8_t: stores through a char type may alias the vertices and force reloads in the scatter loop)
+    template<typename Value, typename TriangleFn, typename AccumulateFn>
+    std::unique_ptr<bool[]> accumulateTriangles(std::span<const GLuint> indices, size_t vertexCount,
+                                                unsigned threadCount, TriangleFn&& perTriangle,
+                                                AccumulateFn&& accumulate) {
+        size_t triangleCount = indices.size() / 3;
+        auto touched = std::make_unique<bool[]>(vertexCount);
+        unsigned workers = threadCount > 0 ? threadCount : defaultThreadCount();
+        if (workers <= 1 || indices.size() <= blockSize) {
+            auto scatter = [&](GLuint v, const Value& value, int corner) {
+                accumulate(v, value, corner, !touched[v]);
+                touched[v] = true;
+            };
+            for (size_t t = 0; t < triangleCount; ++t) {
+                Value value = perTriangle(t);
+                scatter(indices[t * 3], value, 0);
+                scatter(indices[t * 3 + 1], value, 1);
+                scatter(indices[t * 3 + 2], value, 2);
+            }
+            return touched;
+        }
+
+        std::vector<Value> values(triangleCount);
+        parallelBlocks(triangleCount, workers, [&](size_t t) {
+            values[t] = perTriangle(t);
+        });
+        VertexTriangleAdjacency adjacency(indices, vertexCount);
+        parallelBlocks(vertexCount, workers, [&](size_t v) {
+            GLuint begin = adjacency.offsets[v];
+            for (GLuint a = begin; a < adjacency.offsets[v + 1]; ++a) {
+                GLuint t = adjacency.triangles[a];
+                int corner = (indices[t * 3] == v) ? 0 : (indices[t * 3 + 1] == v) ? 1 : 2;
+                accumulate((GLuint)v, values[t], corner, a == begin);
+            }
+            touched[v] = adjacency.offsets[v + 1] > begin;
+        });
+        return touched;
+    }
+
+    // Some unit vector perpendicular to n
+    simd4f perpendicular(simd4f n) {
+        simd4f axis = std::fabs(n[0]) < 0.9f ? simd4f{1.0f, 0.0f, 0.0f, 0.0f} : simd4f{0.0f, 1.0f, 0.0f, 0.0f};
+        return simdNormalize3(simdCross3(n, axis), simd4f{0.0f, 0.0f, 1.0f, 0.0f});
+    }
+
+    // Unit-length v, or perpendicular(n) when v is (nearly) zero; the fallback is only built when it's needed
+    simd4f normalizeOrPerpendicular(simd4f v, simd4f n) {
+        return simdDot3(v, v) > 1e-24f ? simdNormalize3(v, v) : perpendicular(n);
+    }
+
+    // Interior angle at corner p0 of a triangle
+    float cornerAngle(simd4f p0, simd4f p1, simd4f p2) {
+        simd4f zero = simdSplat(0.0f);
+        simd4f a = simdNormalize3(p1 - p0, zero);
+        simd4f b = simdNormalize3(p2 - p0, zero);
+        return std::acos(std::fmax(-1.0f, std::fmin(1.0f, simdDot3(a, b))));
+    }
+
+    struct TriangleFrame {
+        simd4f tangent;    // Zero when the triangle's UVs are degenerate
+        simd4f bitangent;
+    };
+
+    struct WeightedTriangleFrame {
+        TriangleFrame frame;
+        float angles[3];   // Interior angle at each corner
+    };
+
+    // Normalized tangent and bitangent of a triangle from its edges and UV deltas. Inline so the Fast scatter
+    // keeps the frame in registers (GCC otherwise calls it and returns the frame through memory)
+    inline TriangleFrame triangleFrame(const Vertex& v0, const Vertex& v1, const Vertex& v2) {
+        simd4f zero = simdSplat(0.0f);
+        glm::vec2 deltaUV1 = v1.texCoord - v0.texCoord;
+        glm::vec2 deltaUV2 = v2.texCoord - v0.texCoord;
+
+        // Zero-area UV triangles have no defined tangent direction; leave them out instead of dividing by zero
+        float determinant = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+        if (std::fabs(determinant) < 1e-20f) {
+            return {zero, zero};
+        }
+
+        // The 1/determinant scale drops out under normalization, but its sign keeps mirrored UVs mirrored
+        simd4f p0 = simdLoad3(v0.position);
+        simd4f edge1 = simdLoad3(v1.position) - p0;
+        simd4f edge2 = simdLoad3(v2.position) - p0;
+        float sign = determinant > 0.0f ? 1.0f : -1.0f;
+        simd4f tangent = (edge1 * simdSplat(deltaUV2.y) - edge2 * simdSplat(deltaUV1.y)) * simdSplat(sign);
+        simd4f bitangent = (edge2 * simdSplat(deltaUV1.x) - edge1 * simdSplat(deltaUV2.x)) * simdSplat(sign);
+        return {simdNormalize3(tangent, zero), simdNormalize3(bitangent, zero)};
+    }
+}
+
+void calculateNormalsFromGeometry(std::span<Vertex> vertices, std::span<const GLuint> indices, unsigned threadCount) {
+    indices = indices.first(indices.size() - indices.size() % 3);
+
+    // Unnormalized face normals: their length is twice the area, which gives the area weighting for free
+    auto sums = std::make_unique_for_overwrite<simd4f[]>(vertices.size());
+    auto touched = accumulateTriangles<simd4f>(indices, vertices.size(), threadCount, [&](size_t t) {
+        simd4f p0 = simdLoad3(vertices[indices[t * 3]].position);
+        simd4f p1 = simdLoad3(vertices[indices[t * 3 + 1]].position);
+        simd4f p2 = simdLoad3(vertices[indices[t * 3 + 2]].position);
+        return simdCross3(p1 - p0, p2 - p0);
+    }, [&](GLuint v, simd4f faceNormal, int, bool first) {
+        sums[v] = first ? faceNormal : sums[v] + faceNormal;
+    });
+
+    simd4f up = {0.0f, 1.0f, 0.0f, 0.0f};  // Fallback for vertices with no normal contribution
+    parallelBlocks(vertices.size(), threadCount, [&](size_t v) {
+        vertices[v].normal = simdStore3(touched[v] ? simdNormalize3(sums[v], up) : up);
+    });
+}
+
+void calculateTangentsBitangents(std::span<Vertex> vertices, std::span<const GLuint> indices, TangentMode mode,
+                                 unsigned threadCount) {
+    indices = indices.first(indices.size() - indices.size() % 3);
+    simd4f zero = simdSplat(0.0f);
+
+    auto corners = [&](size_t t) -> std::array<const Vertex*, 3> {
+        return {&vertices[indices[t * 3]], &vertices[indices[t * 3 + 1]], &vertices[indices[t * 3 + 2]]};
+    };
+
+    // Sums go straight into the output fields (measured faster here than arrays of their own); a vertex's first
+    // triangle overwrites whatever was there
+    auto store = [&](GLuint v, simd4f tangent, simd4f bitangent, bool first) {
+        Vertex& vertex = vertices[v];
+        if (!first) {
+            tangent += simdLoad3(vertex.tangent);
+            bitangent += simdLoad3(vertex.bitangent);
+        }
+        vertex.tangent = simdStore3(tangent);
+        vertex.bitangent = simdStore3(bitangent);
+    };
+
+    std::unique_ptr<bool[]> touched;
+    if (mode == TangentMode::Fast) {
+        touched = accumulateTriangles<TriangleFrame>(indices, vertices.size(), threadCount, [&](size_t t) {
+            auto [v0, v1, v2] = corners(t);
+            return triangleFrame(*v0, *v1, *v2);
+        }, [&](GLuint v, const TriangleFrame& frame, int, bool first) {
+            store(v, frame.tangent, frame.bitangent, first);
+        });
+    } else {
+        touched = accumulateTriangles<WeightedTriangleFrame>(indices, vertices.size(), threadCount, [&](size_t t) {
+            auto [v0, v1, v2] = corners(t);
+            simd4f p0 = simdLoad3(v0->position);
+            simd4f p1 = simdLoad3(v1->position);
+            simd4f p2 = simdLoad3(v2->position);
+            return WeightedTriangleFrame{triangleFrame(*v0, *v1, *v2),
+                                         {cornerAngle(p0, p1, p2), cornerAngle(p1, p2, p0), cornerAngle(p2, p0, p1)}};
+        }, [&](GLuint v, const WeightedTriangleFrame& triangle, int corner, bool first) {
+            // Project into the vertex's tangent plane, weight by the corner's angle
+            const TriangleFrame& frame = triangle.frame;
+            simd4f normal = simdLoad3(vertices[v].normal);
+            simd4f weight = simdSplat(triangle.angles[corner]);
+            simd4f tangent = frame.tangent - normal * simdSplat(simdDot3(normal, frame.tangent));
+            simd4f bitangent = frame.bitangent - normal * simdSplat(simdDot3(normal, frame.bitangent));
+            store(v, simdNormalize3(tangent, zero) * weight, simdNormalize3(bitangent, zero) * weight, first);
+        });
+    }
+
+    parallelBlocks(vertices.size(), threadCount, [&](size_t v) {
+        Vertex& vertex = vertices[v];
+        simd4f normal = simdLoad3(vertex.normal);
+        simd4f tangentSum = touched[v] ? simdLoad3(vertex.tangent) : zero;
+        simd4f bitangentSum = touched[v] ? simdLoad3(vertex.bitangent) : zero;
+
+        if (mode == TangentMode::Fast) {
+            simd4f tangent = normalizeOrPerpendicular(tangentSum, normal);
+            vertex.tangent = simdStore3(tangent);
+            bool hasBitangent = simdDot3(bitangentSum, bitangentSum) > 1e-24f;
+            vertex.bitangent = simdStore3(hasBitangent ? simdNormalize3(bitangentSum, zero)
+                                                       : simdCross3(normal, tangent));
+            return;
+        }
+
+        // Orthonormal frame: Gram-Schmidt the tangent against the normal, then rebuild the bitangent with
+        // the handedness the accumulated bitangent points to
+        simd4f tangent = tangentSum - normal * simdSplat(simdDot3(normal, tangentSum));
+        tangent = normalizeOrPerpendicular(tangent, normal);
+        simd4f bitangent = simdCross3(normal, tangent);
+        float handedness = simdDot3(bitangent, bitangentSum) < 0.0f ? -1.0f : 1.0f;
+        vertex.tangent = simdStore3(tangent);
+        vertex.bitangent = simdStore3(bitangent * simdSplat(handedness));
+    });
+}
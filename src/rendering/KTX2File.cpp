@@ -0,0 +1,255 @@
+#include "rendering/KTX2File.h"
+#include "utils/MappedFile.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+    constexpr unsigned char ktx2Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    constexpr size_t headerSize = 80;      // Identifier, nine header words and the index
+    constexpr size_t levelIndexEntry = 24;  // byteOffset, byteLength, uncompressedByteLength
+
+    // VkFormat values
+    uint32_t vkFormatFor(BlockFormat format) {
+        switch (format) {
+            case BlockFormat::BC1: return 131;       // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+            case BlockFormat::BC1_SRGB: return 132;  // VK_FORMAT_BC1_RGB_SRGB_BLOCK
+            case BlockFormat::BC4: return 139;       // VK_FORMAT_BC4_UNORM_BLOCK
+            case BlockFormat::BC5: return 141;       // VK_FORMAT_BC5_UNORM_BLOCK
+            case BlockFormat::BC7: return 145;       // VK_FORMAT_BC7_UNORM_BLOCK
+            case BlockFormat::BC7_SRGB: return 146;  // VK_FORMAT_BC7_SRGB_BLOCK
+        }
+        return 0;
+    }
+
+    bool blockFormatFor(uint32_t vkFormat, BlockFormat& format) {
+        for (BlockFormat candidate : {BlockFormat::BC1, BlockFormat::BC1_SRGB, BlockFormat::BC4, BlockFormat::BC5,
+                                      BlockFormat::BC7, BlockFormat::BC7_SRGB}) {
+            if (vkFormatFor(candidate) == vkFormat) {
+                format = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Khronos Data Format descriptor color models
+    uint8_t colorModelFor(BlockFormat format) {
+        switch (format) {
+            case BlockFormat::BC1:
+            case BlockFormat::BC1_SRGB: return 128;  // KHR_DF_MODEL_BC1A
+            case BlockFormat::BC4: return 131;       // KHR_DF_MODEL_BC4
+            case BlockFormat::BC5: return 132;       // KHR_DF_MODEL_BC5
+            default: return 134;                     // KHR_DF_MODEL_BC7
+        }
+    }
+
+    void append(std::vector<unsigned char>& bytes, const void* data, size_t size) {
+        const unsigned char* source = static_cast<const unsigned char*>(data);
+        bytes.insert(bytes.end(), source, source + size);
+    }
+
+    void appendU32(std::vector<unsigned char>& bytes, uint32_t value) { append(bytes, &value, sizeof(value)); }
+    void appendU64(std::vector<unsigned char>& bytes, uint64_t value) { append(bytes, &value, sizeof(value)); }
+
+    void padTo(std::vector<unsigned char>& bytes, size_t alignment) {
+        bytes.resize((bytes.size() + alignment - 1) / alignment * alignment, 0);
+    }
+
+    uint32_t readU32(const char* data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint64_t readU64(const char* data) {
+        uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    // Basic data format descriptor: one sample per 64-bit block half the format has
+    std::vector<unsigned char> buildDataFormatDescriptor(BlockFormat format) {
+        uint32_t sampleCount = format == BlockFormat::BC5 ? 2 : 1;
+        uint32_t blockSize = 24 + 16 * sampleCount;
+
+        std::vector<unsigned char> dfd;
+        appendU32(dfd, 4 + blockSize);            // dfdTotalSize
+        appendU32(dfd, 0);                        // vendorId = Khronos, descriptorType = basic
+        appendU32(dfd, 2 | (blockSize << 16));    // versionNumber 1.3, descriptorBlockSize
+        uint8_t model[4] = {colorModelFor(format), 1, (uint8_t)(isSRGBFormat(format) ? 2 : 1), 0};  // BT.709 primaries
+        append(dfd, model, sizeof(model));
+        uint8_t blockDimensions[4] = {3, 3, 0, 0};  // 4x4x1x1, stored minus one
+        append(dfd, blockDimensions, sizeof(blockDimensions));
+        uint8_t bytesPlane[8] = {(uint8_t)blockBytes(format), 0, 0, 0, 0, 0, 0, 0};
+        append(dfd, bytesPlane, sizeof(bytesPlane));
+
+        bool wholeBlock = blockBytes(format) == 16 && sampleCount == 1;
+        for (uint32_t sample = 0; sample < sampleCount; ++sample) {
+            uint32_t bitOffset = sample * 64;
+            uint32_t bitLength = wholeBlock ? 127 : 63;  // Minus one
+            uint32_t channel = sample;                   // Color / red, then green
+            appendU32(dfd, bitOffset | (bitLength << 16) | (channel << 24));
+            appendU32(dfd, 0);           // samplePosition
+            appendU32(dfd, 0);           // sampleLower
+            appendU32(dfd, 0xFFFFFFFF);  // sampleUpper
+        }
+        return dfd;
+    }
+
+    // Format, size and level layout of a KTX2 file; level offsets are where readKTX2 puts the data
+    CompressedTexture parseHeader(const MappedFile& file, const std::string& path) {
+        if (!file.isOpen()) {
+            throw std::runtime_error("Failed to open texture: " + path);
+        }
+        if (file.size() < headerSize || std::memcmp(file.data(), ktx2Identifier, sizeof(ktx2Identifier)) != 0) {
+            throw std::runtime_error("Not a KTX2 file: " + path);
+        }
+
+        const char* header = file.data() + sizeof(ktx2Identifier);
+        CompressedTexture texture;
+        uint32_t vkFormat = readU32(header);
+        texture.width = readU32(header + 8);
+        texture.height = readU32(header + 12);
+        uint32_t depth = readU32(header + 16);
+        uint32_t layers = readU32(header + 20);
+        uint32_t faces = readU32(header + 24);
+        uint32_t levelCount = readU32(header + 28);
+        uint32_t supercompression = readU32(header + 32);
+        if (!blockFormatFor(vkFormat, texture.format)) {
+            throw std::runtime_error("Unsupported KTX2 format " + std::to_string(vkFormat) + ": " + path);
+        }
+        if (texture.width == 0 || texture.height == 0 || depth != 0 || layers > 1 || faces != 1 || levelCount == 0 ||
+            supercompression != 0) {
+            throw std::runtime_error("Only plain 2D KTX2 textures with mip levels are supported: " + path);
+        }
+        if (file.size() < headerSize + levelIndexEntry * levelCount) {
+            throw std::runtime_error("Truncated KTX2 file: " + path);
+        }
+
+        // The level index has level 0 first; sizes must match the block layout exactly
+        const char* levelIndex = file.data() + headerSize;
+        size_t dataSize = 0;
+        for (uint32_t level = 0; level < levelCount; ++level) {
+            uint32_t width = std::max(texture.width >> level, 1u), height = std::max(texture.height >> level, 1u);
+            uint64_t offset = readU64(levelIndex + level * levelIndexEntry);
+            uint64_t size = readU64(levelIndex + level * levelIndexEntry + 8);
+            uint64_t expected = (uint64_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes(texture.format);
+            if (size != expected || offset > file.size() || size > file.size() - offset) {
+                throw std::runtime_error("Corrupt KTX2 level index: " + path);
+            }
+            texture.levels.push_back({width, height, dataSize, (size_t)size});
+            dataSize += size;
+        }
+        return texture;
+    }
+}
+
+void writeKTX2(const std::string& path, const CompressedTexture& texture) {
+    if (texture.levels.empty()) {
+        throw std::runtime_error("No mip levels to write to " + path);
+    }
+
+    uint32_t levelCount = (uint32_t)texture.levels.size();
+    std::vector<unsigned char> dfd = buildDataFormatDescriptor(texture.format);
+    std::vector<unsigned char> keyValues;
+    {
+        const char orientation[] = "KTXorientation\0ru";
+        appendU32(keyValues, sizeof(orientation));
+        append(keyValues, orientation, sizeof(orientation));
+        padTo(keyValues, 4);
+    }
+
+    size_t dfdOffset = headerSize + levelIndexEntry * levelCount;
+    size_t keyValueOffset = dfdOffset + dfd.size();
+
+    // Level data follows, smallest level first, each aligned to the block size
+    size_t alignment = blockBytes(texture.format);
+    std::vector<uint64_t> levelOffsets(levelCount);
+    size_t offset = keyValueOffset + keyValues.size();
+    for (uint32_t level = levelCount; level-- > 0;) {
+        offset = (offset + alignment - 1) / alignment * alignment;
+        levelOffsets[level] = offset;
+        offset += texture.levels[level].size;
+    }
+
+    std::vector<unsigned char> bytes;
+    bytes.reserve(offset);
+    append(bytes, ktx2Identifier, sizeof(ktx2Identifier));
+    appendU32(bytes, vkFormatFor(texture.format));
+    appendU32(bytes, 1);  // typeSize
+    appendU32(bytes, texture.width);
+    appendU32(bytes, texture.height);
+    appendU32(bytes, 0);  // pixelDepth
+    appendU32(bytes, 0);  // layerCount
+    appendU32(bytes, 1);  // faceCount
+    appendU32(bytes, levelCount);
+    appendU32(bytes, 0);  // supercompressionScheme
+    appendU32(bytes, (uint32_t)dfdOffset);
+    appendU32(bytes, (uint32_t)dfd.size());
+    appendU32(bytes, (uint32_t)keyValueOffset);
+    appendU32(bytes, (uint32_t)keyValues.size());
+    appendU64(bytes, 0);  // Supercompression global data
+    appendU64(bytes, 0);
+    for (uint32_t level = 0; level < levelCount; ++level) {
+        appendU64(bytes, levelOffsets[level]);
+        appendU64(bytes, texture.levels[level].size);
+        appendU64(bytes, texture.levels[level].size);
+    }
+    append(bytes, dfd.data(), dfd.size());
+    append(bytes, keyValues.data(), keyValues.size());
+    for (uint32_t level = levelCount; level-- > 0;) {
+        bytes.resize(levelOffsets[level], 0);
+        append(bytes, texture.data.data() + texture.levels[level].offset, texture.levels[level].size);
+    }
+
+    // Write to a temporary file first so a reader never sees a partial texture
+    std::string temporaryPath = path + ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file || !file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size())) {
+            throw std::runtime_error("Failed to write texture: " + temporaryPath);
+        }
+    }
+    if (std::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        std::remove(temporaryPath.c_str());
+        throw std::runtime_error("Failed to write texture: " + path);
+    }
+}
+
+CompressedTexture readKTX2(const std::string& path, uint32_t firstLevel, uint32_t levelCount) {
+    MappedFile file(path);
+    CompressedTexture texture = parseHeader(file, path);
+    uint32_t available = (uint32_t)texture.levels.size();
+    if (levelCount == 0) {
+        levelCount = available > firstLevel ? available - firstLevel : 0;
+    }
+    if (levelCount == 0 || firstLevel + levelCount > available) {
+        throw std::runtime_error("KTX2 file doesn't have the requested mip levels: " + path);
+    }
+
+    // Keep just the requested levels, packed from offset 0
+    const char* levelIndex = file.data() + headerSize;
+    std::vector<CompressedLevel> levels(texture.levels.begin() + firstLevel,
+                                        texture.levels.begin() + firstLevel + levelCount);
+    size_t dataSize = 0;
+    for (CompressedLevel& level : levels) {
+        level.offset = dataSize;
+        dataSize += level.size;
+    }
+    texture.data.resize(dataSize);
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        uint64_t offset = readU64(levelIndex + (firstLevel + i) * levelIndexEntry);
+        std::memcpy(texture.data.data() + levels[i].offset, file.data() + offset, levels[i].size);
+    }
+    texture.firstLevel = firstLevel;
+    texture.levels = std::move(levels);
+    return texture;
+}
+
+CompressedTexture readKTX2Header(const std::string& path) {
+    MappedFile file(path);
+    return parseHeader(file, path);
+}
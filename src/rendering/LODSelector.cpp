@@ -0,0 +1,42 @@
+#include "rendering/LODSelector.h"
+#include <algorithm>
+#include <cmath>
+
+LODSelector::LODSelector(std::vector<float> switchPixels, float cullPixels, float hysteresis)
+    : switchPixels(std::move(switchPixels)), cullPixels(cullPixels), hysteresis(hysteresis) {
+}
+
+float LODSelector::projectedDiameter(const glm::vec3& center, float radius, const glm::vec3& cameraPosition,
+                                     float fovY, float viewportHeight) {
+    float distance = glm::length(center - cameraPosition);
+    // Camera inside the sphere: it covers the whole view
+    if (distance <= radius) {
+        return viewportHeight;
+    }
+    // Pixels per world unit at this distance, times the diameter
+    float pixelsPerUnit = viewportHeight / (2.0f * distance * std::tan(fovY * 0.5f));
+    return 2.0f * radius * pixelsPerUnit;
+}
+
+int LODSelector::select(float pixelDiameter, int previousLOD, int lodCount) const {
+    int maxLOD = std::min(lodCount - 1, (int)switchPixels.size());
+
+    // Culled instances must grow past the band to come back, drawn ones must shrink past it to go
+    float cullThreshold = cullPixels * ((previousLOD < 0) ? 1.0f + hysteresis : 1.0f - hysteresis);
+    if (pixelDiameter < cullThreshold) {
+        return -1;
+    }
+
+    // Newly visible instances use the plain thresholds; drawn ones have to cross the band to switch
+    float shrink = (previousLOD < 0) ? 1.0f : 1.0f - hysteresis;
+    float grow = (previousLOD < 0) ? 1.0f : 1.0f + hysteresis;
+
+    int lod = std::clamp(previousLOD, 0, maxLOD);
+    while (lod < maxLOD && pixelDiameter < switchPixels[lod] * shrink) {
+        ++lod;
+    }
+    while (lod > 0 && pixelDiameter > switchPixels[lod - 1] * grow) {
+        --lod;
+    }
+    return lod;
+}
@@ -0,0 +1,268 @@
+#include "rendering/MaterialPool.h"
+#include "rendering/KTX2File.h"
+#include "rendering/Texture.h"
+#include "rendering/TextureLoader.h"
+#include <stb_image.h>
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    using MapLayout = MaterialPool::MapLayout;
+
+    // Placeholder type of each pooled map: albedo, normal, ORM
+    constexpr TextureType mapTypes[3] = {TextureType::ALBEDO, TextureType::NORMAL, TextureType::ORM};
+
+    int fullMipCount(int width, int height) {
+        int levels = 1;
+        while (width > 1 || height > 1) {
+            width = std::max(width / 2, 1);
+            height = std::max(height / 2, 1);
+            ++levels;
+        }
+        return levels;
+    }
+
+    size_t levelBytes(const MapLayout& layout, int level) {
+        size_t width = std::max(layout.width >> level, 1), height = std::max(layout.height >> level, 1);
+        if (layout.compressed) {
+            return (width + 3) / 4 * ((height + 3) / 4) * blockBytes(layout.blockFormat);
+        }
+        return width * height * 4;
+    }
+
+    // A baked file the driver can sample
+    bool probeBaked(const std::string& bakedPath, MapLayout& layout) {
+        try {
+            CompressedTexture header = readKTX2Header(bakedPath);
+            if (!Texture::isCompressedFormatSupported(header.format)) {
+                return false;
+            }
+            layout = {(int)header.width, (int)header.height, (int)header.levels.size(),
+                      Texture::compressedFormat(header.format), true, header.format};
+            return true;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return false;
+        }
+    }
+
+    // A source image, expanded to RGBA with a generated mip chain
+    bool probeSource(const std::string& path, bool srgb, MapLayout& layout) {
+        int width, height, channels;
+        if (!stbi_info(path.c_str(), &width, &height, &channels)) {
+            return false;
+        }
+        layout = {width, height, fullMipCount(width, height), Texture::internalFormatFor(4, srgb), false};
+        return true;
+    }
+
+    // What the loader will upload for a map: its baked file if usable, otherwise the source
+    bool probeMap(const std::string& path, bool srgb, MapLayout& layout) {
+        std::string bakedPath = Texture::findBakedTexture(path);
+        return (!bakedPath.empty() && probeBaked(bakedPath, layout)) || probeSource(path, srgb, layout);
+    }
+
+    // The ORM cache, or what the loader will pack: BC7 when the driver can sample it, otherwise RGB
+    bool probeORM(const ORMSources& sources, MapLayout& layout) {
+        std::string cachePath = ormCachePath(sources);
+        if (isORMCacheFresh(cachePath, sources) && probeBaked(cachePath, layout)) {
+            return true;
+        }
+        if (!canPackORM(sources) || !probeSource(sources.ao, false, layout)) {
+            return false;
+        }
+        if (Texture::isCompressedFormatSupported(BlockFormat::BC7)) {
+            layout.compressed = true;
+            layout.blockFormat = BlockFormat::BC7;
+            layout.internalFormat = Texture::compressedFormat(BlockFormat::BC7);
+        }
+        return true;
+    }
+}
+
+MaterialPool::MaterialPool(int layersPerPool) : layersPerPool(std::max(layersPerPool, 1)) {}
+
+MaterialSlot MaterialPool::add(const std::string& albedoPath, const std::string& normalPath, const ORMSources& orm,
+                               TextureLoader& loader) {
+    MapLayout maps[3];
+    if (!probeMap(albedoPath, true, maps[0]) || !probeMap(normalPath, false, maps[1]) || !probeORM(orm, maps[2])) {
+        std::cout << "Material maps can't be pooled, keeping separate textures: " << albedoPath << std::endl;
+        return {};
+    }
+    for (const MapLayout& map : maps) {
+        if (map.width != maps[0].width || map.height != maps[0].height ||
+            map.levels != fullMipCount(map.width, map.height)) {
+            std::cout << "Material maps differ in size or mip chain, keeping separate textures: " << albedoPath
+                      << std::endl;
+            return {};
+        }
+    }
+
+    // First free layer of a pool with this layout, or a new pool
+    MaterialSlot slot;
+    for (size_t i = 0; i < pools.size() && !slot.isValid(); ++i) {
+        Pool& pool = pools[i];
+        if (!std::equal(std::begin(maps), std::end(maps), std::begin(pool.maps))) continue;
+        for (size_t layer = 0; layer < pool.layers.size(); ++layer) {
+            if (!pool.layers[layer].used) {
+                slot = {(int)i, (int)layer};
+                break;
+            }
+        }
+    }
+    if (!slot.isValid()) {
+        createPool(maps);
+        slot = {(int)pools.size() - 1, 0};
+    }
+
+    Pool& pool = pools[slot.pool];
+    Layer& layer = pool.layers[slot.layer];
+    layer.used = true;
+    TextureLayerTarget targets[3];
+    for (int map = 0; map < 3; ++map) {
+        fillPlaceholder(pool, map, slot.layer);
+        targets[map] = {slot.layer, pool.maps[map].internalFormat, pool.maps[map].width, pool.maps[map].height,
+                        pool.maps[map].levels};
+    }
+    layer.requests[0] = loader.load(pool.arrays[0], albedoPath, true, targets[0]);
+    layer.requests[1] = loader.load(pool.arrays[1], normalPath, false, targets[1]);
+    layer.requests[2] = loader.loadPacked(pool.arrays[2], orm, targets[2]);
+    return slot;
+}
+
+void MaterialPool::release(const MaterialSlot& slot) {
+    if (!slot.isValid() || slot.pool >= (int)pools.size()) return;
+    Layer& layer = pools[slot.pool].layers[slot.layer];
+
+    // A pending upload must not land in the layer's next material
+    for (auto& request : layer.requests) {
+        if (request) {
+            request->cancelled = true;
+            request.reset();
+        }
+    }
+    layer.used = false;
+}
+
+bool MaterialPool::isReady(const MaterialSlot& slot) const {
+    if (!slot.isValid() || slot.pool >= (int)pools.size()) return true;
+    for (const auto& request : pools[slot.pool].layers[slot.layer].requests) {
+        if (!request) continue;
+        auto state = request->state.load();
+        if (state != TextureRequest::State::Ready && state != TextureRequest::State::Failed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void MaterialPool::bind(int pool, GLenum firstUnit) const {
+    for (int map = 0; map < 3; ++map) {
+        glActiveTexture(firstUnit + map);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, pools[pool].arrays[map]);
+    }
+}
+
+int MaterialPool::getLayerCount() const {
+    int count = 0;
+    for (const Pool& pool : pools) {
+        for (const Layer& layer : pool.layers) {
+            count += layer.used ? 1 : 0;
+        }
+    }
+    return count;
+}
+
+size_t MaterialPool::getGPUMemorySize() const {
+    size_t bytes = 0;
+    for (const Pool& pool : pools) {
+        bytes += pool.gpuBytes;
+    }
+    return bytes;
+}
+
+void MaterialPool::createPool(const MapLayout (&maps)[3]) {
+    Pool pool;
+    pool.layers.resize(layersPerPool);
+    for (int map = 0; map < 3; ++map) {
+        const MapLayout& layout = maps[map];
+        pool.maps[map] = layout;
+
+        glGenTextures(1, &pool.arrays[map]);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, pool.arrays[map]);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        // Every level up front: layers are only ever written with sub-image uploads
+        for (int level = 0; level < layout.levels; ++level) {
+            GLsizei width = std::max(layout.width >> level, 1), height = std::max(layout.height >> level, 1);
+            size_t bytes = levelBytes(layout, level) * layersPerPool;
+            if (layout.compressed) {
+                glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, layout.internalFormat, width, height,
+                                       layersPerPool, 0, (GLsizei)bytes, nullptr);
+            } else {
+                glTexImage3D(GL_TEXTURE_2D_ARRAY, level, layout.internalFormat, width, height, layersPerPool, 0,
+                             GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            }
+            pool.gpuBytes += bytes;
+        }
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, layout.levels - 1);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    std::cout << "Material pool " << pools.size() << ": " << maps[0].width << "x" << maps[0].height << ", "
+              << layersPerPool << " layers, " << pool.gpuBytes / (1024 * 1024) << " MB" << std::endl;
+    pools.push_back(std::move(pool));
+}
+
+void MaterialPool::fillPlaceholder(const Pool& pool, int map, int layer) const {
+    const MapLayout& layout = pool.maps[map];
+    unsigned char color[4];
+    Texture::placeholderColor(mapTypes[map], color);
+
+    // Level 0's worth of the repeated texel (or block), reused for the smaller levels
+    std::vector<unsigned char> data(levelBytes(layout, 0));
+    if (layout.compressed) {
+        unsigned char texels[64], block[16];
+        for (int i = 0; i < 16; ++i) {
+            std::copy(color, color + 4, texels + i * 4);
+        }
+        encodeBlock(layout.blockFormat, texels, block);
+        size_t size = blockBytes(layout.blockFormat);
+        for (size_t offset = 0; offset < data.size(); offset += size) {
+            std::copy(block, block + size, data.begin() + offset);
+        }
+    } else {
+        for (size_t offset = 0; offset < data.size(); offset += 4) {
+            std::copy(color, color + 4, data.begin() + offset);
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, pool.arrays[map]);
+    for (int level = 0; level < layout.levels; ++level) {
+        GLsizei width = std::max(layout.width >> level, 1), height = std::max(layout.height >> level, 1);
+        if (layout.compressed) {
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1,
+                                      layout.internalFormat, (GLsizei)levelBytes(layout, level), data.data());
+        } else {
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                            data.data());
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+void MaterialPool::destroy() {
+    for (Pool& pool : pools) {
+        for (Layer& layer : pool.layers) {
+            for (auto& request : layer.requests) {
+                if (request) request->cancelled = true;
+            }
+        }
+        glDeleteTextures(3, pool.arrays);
+    }
+    pools.clear();
+}
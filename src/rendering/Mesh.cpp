@@ -1,52 +1,33 @@
 #include "rendering/Mesh.h"
+#include <algorithm>
 
+namespace {
+    const Uniform<bool> packedVerticesUniform("packedVertices");
+    const Uniform<glm::vec3> positionOffsetUniform("positionOffset");
+    const Uniform<glm::vec3> positionScaleUniform("positionScale");
+}
 
-Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices) 
-    : vertexCount(static_cast<GLsizei>(vertices.size())), 
-      indexCount(static_cast<GLsizei>(indices.size())) {
-    
-    // Calculate bounding box from vertices
-    std::vector<glm::vec3> positions;
-    positions.reserve(vertices.size());
-    for (const auto& vertex : vertices) {
-        positions.push_back(vertex.position);
-    }
-    boundingBox = BoundingBox::fromVertices(positions);
-    
-    // Create VAO, VBO, and EBO
-    vao = std::make_unique<VAO>();
-    vbo = std::make_unique<VBO>(vertices);
-    ebo = std::make_unique<EBO>(indices);
-    
-    // Bind VAO and setup vertex attributes
-    vao->bind();
-    vbo->bind();
-    ebo->bind();
-    
-    setupVertexAttributes();
-    
-    // Unbind everything
-    vao->unbind();
-    vbo->unbind();
-    ebo->unbind();
+
+Mesh::Mesh(std::span<const Vertex> vertices, std::span<const GLuint> indices) 
+    : Mesh(vertices, indices, computeBoundingBox(vertices)) {
 }
 
-Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices, const std::vector<Texture>& textures) 
-    : vertexCount(static_cast<GLsizei>(vertices.size())), 
+Mesh::Mesh(std::span<const Vertex> vertices, std::span<const GLuint> indices,
+           const std::vector<std::shared_ptr<Texture>>& textures) 
+    : textures(textures),
+      vertexCount(static_cast<GLsizei>(vertices.size())), 
       indexCount(static_cast<GLsizei>(indices.size())),
-      textures(textures) {
-    
-    // Calculate bounding box from vertices
-    std::vector<glm::vec3> positions;
-    positions.reserve(vertices.size());
-    for (const auto& vertex : vertices) {
-        positions.push_back(vertex.position);
-    }
-    boundingBox = BoundingBox::fromVertices(positions);
+      layout(vertexLayout<LitVertexFormat>()),
+      boundingBox(computeBoundingBox(vertices)) {
+    createBuffers(LitVertexFormat::encode(vertices, quantization), indices);
+}
+
+void Mesh::createBuffers(std::span<const std::byte> vertexData, std::span<const GLuint> indices) {
+    lods = {MeshLOD{0, (GLuint)indices.size(), 0.0f}};
     
     // Create VAO, VBO, and EBO
     vao = std::make_unique<VAO>();
-    vbo = std::make_unique<VBO>(vertices);
+    vbo = std::make_unique<VBO>(vertexData);
     ebo = std::make_unique<EBO>(indices);
     
     // Bind VAO and setup vertex attributes
@@ -66,20 +47,45 @@ Mesh::~Mesh() {
     destroy();
 }
 
-void Mesh::draw(Shader& shader) {
+void Mesh::draw(Shader& shader, int lod) {
     // Bind textures to texture units
     for (size_t i = 0; i < textures.size(); ++i) {
-        textures[i].bind(GL_TEXTURE0 + i);
+        textures[i]->bind(GL_TEXTURE0 + i);
     }
     
-    // Draw the mesh
+    setVertexDecodeUniforms(shader);
+    
+    // Draw the level's range of the index buffer
+    const MeshLOD& range = lods[std::clamp(lod, 0, getLODCount() - 1)];
     vao->bind();
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
+    glDrawElements(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT, (void*)(range.indexOffset * sizeof(GLuint)));
     vao->unbind();
     
     // Unbind textures
     for (size_t i = 0; i < textures.size(); ++i) {
-        textures[i].unbind();
+        textures[i]->unbind();
+    }
+}
+
+void Mesh::drawRanges(Shader& shader, const MeshletDrawList& ranges) {
+    if (ranges.empty()) {
+        return;
+    }
+    
+    // Bind textures to texture units
+    for (size_t i = 0; i < textures.size(); ++i) {
+        textures[i]->bind(GL_TEXTURE0 + i);
+    }
+    
+    setVertexDecodeUniforms(shader);
+    vao->bind();
+    glMultiDrawElements(GL_TRIANGLES, ranges.counts.data(), GL_UNSIGNED_INT, ranges.offsets.data(),
+                        (GLsizei)ranges.counts.size());
+    vao->unbind();
+    
+    // Unbind textures
+    for (size_t i = 0; i < textures.size(); ++i) {
+        textures[i]->unbind();
     }
 }
 
@@ -92,7 +98,7 @@ void Mesh::Draw(Shader& shader) {
     // Bind textures and upload to uniforms
     for (unsigned int i = 0; i < textures.size(); i++) {
         std::string num;
-        std::string type = textures[i].getTypeString();
+        std::string type = textures[i]->getTypeString();
         
         if (type == "diffuse") {
             num = std::to_string(numDiffuse++);
@@ -108,23 +114,32 @@ void Mesh::Draw(Shader& shader) {
         std::string uniformName = type + num;
 
         // Bind texture to texture unit
-        textures[i].bind(GL_TEXTURE0 + i);
+        textures[i]->bind(GL_TEXTURE0 + i);
         
         // Upload texture to uniform using the uploadToUniform method
-        textures[i].uploadToUniform(shader.id, uniformName.c_str(), GL_TEXTURE0 + i);
+        textures[i]->uploadToUniform(shader.id, uniformName.c_str(), GL_TEXTURE0 + i);
     }
     
     // Draw the mesh
+    setVertexDecodeUniforms(shader);
     vao->bind();
     glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
     vao->unbind();
     
     // Unbind textures
     for (size_t i = 0; i < textures.size(); ++i) {
-        textures[i].unbind();
+        textures[i]->unbind();
     }
 }
 
+void Mesh::setLODs(std::span<const MeshLOD> newLODs) {
+    if (newLODs.empty()) {
+        lods = {MeshLOD{0, (GLuint)indexCount, 0.0f}};
+        return;
+    }
+    lods.assign(newLODs.begin(), newLODs.end());
+}
+
 void Mesh::bind() {
     vao->bind();
 }
@@ -140,29 +155,28 @@ void Mesh::destroy() {
 }
 
 void Mesh::setupVertexAttributes() {
-    // Position attribute (location = 0)
-    vao->LinkAttrib(*vbo, 0, 3, GL_FLOAT, sizeof(Vertex), (void*)0);
-    
-    // Color attribute (location = 1)
-    vao->LinkAttrib(*vbo, 1, 3, GL_FLOAT, sizeof(Vertex), (void*)(3 * sizeof(float)));
-    
-    // Texture coordinate attribute (location = 2)
-    vao->LinkAttrib(*vbo, 2, 2, GL_FLOAT, sizeof(Vertex), (void*)(6 * sizeof(float)));
-    
-    // Normal attribute (location = 3)
-    vao->LinkAttrib(*vbo, 3, 3, GL_FLOAT, sizeof(Vertex), (void*)(8 * sizeof(float)));
-    
-    // Tangent attribute (location = 4)
-    vao->LinkAttrib(*vbo, 4, 3, GL_FLOAT, sizeof(Vertex), (void*)(11 * sizeof(float)));
-    
-    // Bitangent attribute (location = 5)
-    vao->LinkAttrib(*vbo, 5, 3, GL_FLOAT, sizeof(Vertex), (void*)(14 * sizeof(float)));
+    // Offsets and stride come from the format; attributes it leaves out stay disabled
+    vao->linkFormat(*vbo, layout);
+}
+
+void Mesh::setVertexDecodeUniforms(Shader& shader) {
+    shader.set(packedVerticesUniform, layout.quantized);
+    shader.set(positionOffsetUniform, quantization.offset);
+    shader.set(positionScaleUniform, quantization.scale);
 }
 
 BoundingBox Mesh::getBoundingBox() const {
     return boundingBox;
 }
 
+BoundingBox Mesh::computeBoundingBox(std::span<const Vertex> vertices) {
+    BoundingBox bounds;
+    for (const auto& vertex : vertices) {
+        bounds.expand(vertex.position);
+    }
+    return bounds;
+}
+
 bool Mesh::isVisibleInFrustum(const Frustum& frustum, const glm::mat4& modelMatrix) const {
     // Transform the bounding box by the model matrix
     BoundingBox transformedBox = boundingBox.transform(modelMatrix);
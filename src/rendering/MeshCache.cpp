@@ -0,0 +1,252 @@
+#include "rendering/MeshCache.h"
+#include "rendering/OBJLoader.h"
+#include "utils/Hash.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <tuple>
+
+namespace {
+    constexpr char meshCacheMagic[8] = {'G', 'L', 'O', 'W', 'M', 'E', 'S', 'H'};
+
+    // Bump whenever the layout or the cached processing changes so old files are rebuilt
+    constexpr uint32_t meshCacheVersion = 6;
+
+    // Arrays start on this boundary within the file
+    constexpr uint64_t meshCacheAlignment = 16;
+
+    // The arrays stored in a cache file, in file order
+    enum MeshCacheSectionId { VertexSection, IndexSection, LODSection, MeshletSection, SectionCount };
+
+    struct MeshCacheSection {
+        uint64_t offset;
+        uint64_t count;
+        uint64_t stride;  // Element size, so a changed struct layout invalidates the file
+    };
+
+    struct MeshCacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t sectionCount;
+        MeshCacheSection sections[SectionCount];
+        float boundsMin[3];
+        float boundsMax[3];
+        uint64_t sourceSize;
+        int64_t sourceModifiedTime;
+        uint64_t sourceHash;
+        uint64_t processKey;
+    };
+
+    constexpr uint64_t sectionStrides[SectionCount] = {
+        sizeof(Vertex), sizeof(GLuint), sizeof(MeshLOD), sizeof(Meshlet)
+    };
+
+    uint64_t alignOffset(uint64_t offset) {
+        return (offset + meshCacheAlignment - 1) & ~(meshCacheAlignment - 1);
+    }
+
+    template<typename T>
+    std::span<const T> mapSection(const MappedFile& file, const MeshCacheSection& section) {
+        return {reinterpret_cast<const T*>(file.data() + section.offset), (size_t) section.count};
+    }
+
+    // Size and modification time of a file, without reading it
+    bool statSource(const std::string& path, MeshSourceInfo& info) {
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        if (error) return false;
+        auto time = std::filesystem::last_write_time(path, error);
+        if (error) return false;
+
+        info.size = size;
+        info.modifiedTime = (int64_t) time.time_since_epoch().count();
+        return true;
+    }
+
+    bool hashSource(const std::string& path, uint64_t& hash) {
+        MappedFile source(path);
+        if (!source.isOpen()) return false;
+        hash = hashBytes(source.data(), source.size());
+        return true;
+    }
+}
+
+bool MeshCache::open(const std::string& cachePath, const std::string& sourcePath, uint64_t processKey) {
+    MappedFile mapped(cachePath);
+    if (!mapped.isOpen() || mapped.size() < sizeof(MeshCacheHeader)) {
+        return false;
+    }
+
+    MeshCacheHeader header;
+    std::memcpy(&header, mapped.data(), sizeof(header));
+    if (std::memcmp(header.magic, meshCacheMagic, sizeof(meshCacheMagic)) != 0 ||
+        header.version != meshCacheVersion || header.sectionCount != SectionCount ||
+        header.processKey != processKey) {
+        return false;
+    }
+
+    for (int i = 0; i < SectionCount; ++i) {
+        const MeshCacheSection& section = header.sections[i];
+        if (section.stride != sectionStrides[i] || section.offset % meshCacheAlignment != 0 ||
+            section.offset + section.count * section.stride > mapped.size()) {
+            return false;
+        }
+    }
+
+    // Ranges must stay inside the index buffer
+    uint64_t indexCount = header.sections[IndexSection].count;
+    for (const auto& lod : mapSection<MeshLOD>(mapped, header.sections[LODSection])) {
+        if ((uint64_t) lod.indexOffset + lod.indexCount > indexCount) {
+            return false;
+        }
+    }
+    for (const auto& meshlet : mapSection<Meshlet>(mapped, header.sections[MeshletSection])) {
+        if ((uint64_t) meshlet.indexOffset + meshlet.indexCount > indexCount) {
+            return false;
+        }
+    }
+
+    // Size and time are enough when they match; a touched-but-identical source is confirmed by its hash.
+    // A cache without its source (e.g. shipped on its own) is trusted as-is
+    MeshSourceInfo source;
+    if (statSource(sourcePath, source)) {
+        if (source.size != header.sourceSize) {
+            return false;
+        }
+        if (source.modifiedTime != header.sourceModifiedTime) {
+            uint64_t hash = 0;
+            if (!hashSource(sourcePath, hash) || hash != header.sourceHash) {
+                return false;
+            }
+        }
+    }
+
+    file = std::move(mapped);
+    owned = MeshData();
+    vertices = mapSection<Vertex>(file, header.sections[VertexSection]);
+    indices = mapSection<GLuint>(file, header.sections[IndexSection]);
+    lods = mapSection<MeshLOD>(file, header.sections[LODSection]);
+    meshlets = mapSection<Meshlet>(file, header.sections[MeshletSection]);
+    boundingBox = !vertices.empty()
+            ? BoundingBox(glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]),
+                          glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]))
+            : BoundingBox();
+    return true;
+}
+
+bool MeshCache::write(const std::string& cachePath, const std::string& sourcePath, const MeshData& mesh,
+                      const BoundingBox& bounds, uint64_t processKey) {
+    MeshSourceInfo source;
+    if (!statSource(sourcePath, source) || !hashSource(sourcePath, source.contentHash)) {
+        return false;
+    }
+
+    const std::span<const std::byte> sectionData[SectionCount] = {
+        std::as_bytes(std::span(mesh.vertices)),
+        std::as_bytes(std::span(mesh.indices)),
+        std::as_bytes(std::span(mesh.lods)),
+        std::as_bytes(std::span(mesh.meshlets)),
+    };
+
+    MeshCacheHeader header{};
+    std::memcpy(header.magic, meshCacheMagic, sizeof(meshCacheMagic));
+    header.version = meshCacheVersion;
+    header.sectionCount = SectionCount;
+    uint64_t offset = sizeof(MeshCacheHeader);
+    for (int i = 0; i < SectionCount; ++i) {
+        offset = alignOffset(offset);
+        header.sections[i] = {offset, sectionData[i].size() / sectionStrides[i], sectionStrides[i]};
+        offset += sectionData[i].size();
+    }
+    glm::vec3 boundsMin = bounds.getMin();
+    glm::vec3 boundsMax = bounds.getMax();
+    for (int i = 0; i < 3; ++i) {
+        header.boundsMin[i] = boundsMin[i];
+        header.boundsMax[i] = boundsMax[i];
+    }
+    header.sourceSize = source.size;
+    header.sourceModifiedTime = source.modifiedTime;
+    header.sourceHash = source.contentHash;
+    header.processKey = processKey;
+
+    // Write next to the destination and rename, so a crash never leaves a truncated cache behind
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+
+        const char padding[meshCacheAlignment] = {};
+        uint64_t written = sizeof(header);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (int i = 0; i < SectionCount; ++i) {
+            out.write(padding, header.sections[i].offset - written);
+            out.write(reinterpret_cast<const char*>(sectionData[i].data()), sectionData[i].size());
+            written = header.sections[i].offset + sectionData[i].size();
+        }
+        if (!out.good()) {
+            out.close();
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, cachePath, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+std::string MeshCache::cachePathFor(const std::string& sourcePath) {
+    return std::filesystem::path(sourcePath).replace_extension(".glowmesh").string();
+}
+
+void MeshCache::assign(MeshData&& mesh, const BoundingBox& bounds) {
+    file.close();
+    owned = std::move(mesh);
+    vertices = owned.vertices;
+    indices = owned.indices;
+    lods = owned.lods;
+    meshlets = owned.meshlets;
+    boundingBox = bounds;
+}
+
+MeshCache loadOBJCached(const std::string& objPath, const MeshPostProcess& postProcess, uint64_t processKey) {
+    auto start = std::chrono::steady_clock::now();
+    std::string cachePath = MeshCache::cachePathFor(objPath);
+
+    MeshCache cache;
+    if (cache.open(cachePath, objPath, processKey)) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Mesh cache hit: " << cachePath << " (" << ms << " ms)" << std::endl;
+        return cache;
+    }
+
+    MeshData mesh;
+    std::tie(mesh.vertices, mesh.indices) = loadOBJFile(objPath);
+    if (postProcess) {
+        postProcess(mesh);
+    }
+    BoundingBox bounds;
+    for (const auto& vertex : mesh.vertices) {
+        bounds.expand(vertex.position);
+    }
+
+    if (MeshCache::write(cachePath, objPath, mesh, bounds, processKey) &&
+        cache.open(cachePath, objPath, processKey)) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Mesh cache built: " << cachePath << " (" << ms << " ms)" << std::endl;
+        return cache;
+    }
+
+    std::cerr << "Warning: could not write mesh cache " << cachePath << std::endl;
+    cache.assign(std::move(mesh), bounds);
+    return cache;
+}
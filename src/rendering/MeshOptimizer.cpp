@@ -0,0 +1,270 @@
+#include "rendering/MeshOptimizer.h"
+#include "rendering/MeshAdjacency.h"
+#include <algorithm>
+
+namespace {
+    // FIFO cache simulation shared by the statistics and the cluster splitting
+    class FifoCacheSim {
+    public:
+        FifoCacheSim(size_t vertexCount, unsigned cacheSize) : stamps(vertexCount, 0), cacheSize(cacheSize) {}
+
+        // Returns true if the vertex had to be transformed
+        bool access(GLuint vertex) {
+            if (stamps[vertex] != 0 && time - stamps[vertex] < cacheSize) {
+                return false;
+            }
+            // A miss pushes the vertex into the FIFO; only misses advance the FIFO
+            stamps[vertex] = ++time;
+            return true;
+        }
+
+        // Forget everything, as if the cache had been filled with unrelated vertices
+        void flush() {
+            time += cacheSize;
+        }
+
+    private:
+        std::vector<unsigned> stamps;
+        unsigned time = 0;
+        unsigned cacheSize;
+    };
+
+    unsigned triangleMisses(FifoCacheSim& cache, const GLuint* triangle) {
+        return (unsigned)cache.access(triangle[0]) + cache.access(triangle[1]) + cache.access(triangle[2]);
+    }
+}
+
+VertexCacheStats analyzeVertexCache(std::span<const GLuint> indices, size_t vertexCount, unsigned cacheSize) {
+    VertexCacheStats stats;
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return stats;
+
+    FifoCacheSim cache(vertexCount, cacheSize);
+    std::vector<bool> referenced(vertexCount, false);
+    size_t misses = 0, referencedCount = 0;
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        misses += cache.access(indices[i]);
+        if (!referenced[indices[i]]) {
+            referenced[indices[i]] = true;
+            ++referencedCount;
+        }
+    }
+
+    stats.acmr = (float)misses / (float)triangleCount;
+    stats.atvr = (float)misses / (float)referencedCount;
+    return stats;
+}
+
+void optimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount, unsigned cacheSize) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return;
+
+    VertexTriangleAdjacency adjacency(indices, vertexCount);
+
+    // Remaining (not yet emitted) triangles per vertex, and when each vertex last entered the cache
+    std::vector<GLuint> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        liveTriangles[v] = adjacency.count((GLuint)v);
+    }
+    std::vector<unsigned> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+
+    std::vector<GLuint> deadEnd;  // Recently used vertices to fall back to when the fan runs dry
+    deadEnd.reserve(indices.size());
+    std::vector<GLuint> candidates;
+    candidates.reserve(64);
+
+    std::vector<GLuint> output;
+    output.reserve(triangleCount * 3);
+
+    unsigned timestamp = cacheSize + 1;
+    size_t cursor = 0;  // Scan position for the next vertex with live triangles
+
+    auto skipDeadEnd = [&]() -> long long {
+        while (!deadEnd.empty()) {
+            GLuint vertex = deadEnd.back();
+            deadEnd.pop_back();
+            if (liveTriangles[vertex] > 0) return vertex;
+        }
+        while (cursor < vertexCount) {
+            if (liveTriangles[cursor] > 0) return (long long)cursor;
+            ++cursor;
+        }
+        return -1;
+    };
+
+    long long fanning = skipDeadEnd();
+    while (fanning >= 0) {
+        GLuint vertex = (GLuint)fanning;
+        candidates.clear();
+
+        // Emit every remaining triangle around the fanning vertex
+        for (GLuint a = adjacency.offsets[vertex]; a < adjacency.offsets[vertex + 1]; ++a) {
+            GLuint triangle = adjacency.triangles[a];
+            if (emitted[triangle]) continue;
+            emitted[triangle] = true;
+
+            for (int k = 0; k < 3; ++k) {
+                GLuint corner = indices[triangle * 3 + k];
+                output.push_back(corner);
+                deadEnd.push_back(corner);
+                candidates.push_back(corner);
+                --liveTriangles[corner];
+                if (timestamp - cacheTime[corner] > cacheSize) {
+                    cacheTime[corner] = timestamp++;
+                }
+            }
+        }
+
+        // Pick the candidate that stays in cache through its remaining fan and entered it earliest
+        long long best = -1;
+        long long bestPriority = -1;
+        for (GLuint candidate : candidates) {
+            if (liveTriangles[candidate] == 0) continue;
+            long long priority = 0;
+            if (timestamp - cacheTime[candidate] + 2 * liveTriangles[candidate] <= cacheSize) {
+                priority = timestamp - cacheTime[candidate];
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = candidate;
+            }
+        }
+        fanning = (best >= 0) ? best : skipDeadEnd();
+    }
+
+    indices.swap(output);
+}
+
+size_t optimizeOverdraw(std::vector<GLuint>& indices, std::span<const Vertex> vertices, float threshold,
+                        unsigned cacheSize) {
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) return 0;
+
+    // Hard boundaries: triangles where all three vertices miss, i.e. the cache-optimized order restarted
+    std::vector<size_t> hardStarts;
+    {
+        FifoCacheSim sim(vertices.size(), cacheSize);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            if (triangleMisses(sim, &indices[t * 3]) == 3) hardStarts.push_back(t);
+        }
+        if (hardStarts.empty() || hardStarts.front() != 0) hardStarts.insert(hardStarts.begin(), 0);
+    }
+
+    // Soft boundaries: split each hard cluster further wherever the triangles so far already reach
+    // an ACMR within threshold of the whole cluster's, so smaller clusters cost little cache efficiency
+    std::vector<size_t> clusterStarts;
+    FifoCacheSim cache(vertices.size(), cacheSize);
+    for (size_t h = 0; h < hardStarts.size(); ++h) {
+        size_t begin = hardStarts[h];
+        size_t end = (h + 1 < hardStarts.size()) ? hardStarts[h + 1] : triangleCount;
+
+        cache.flush();
+        unsigned clusterMisses = 0;
+        for (size_t t = begin; t < end; ++t) {
+            clusterMisses += triangleMisses(cache, &indices[t * 3]);
+        }
+        float clusterThreshold = threshold * (float)clusterMisses / (float)(end - begin);
+
+        cache.flush();
+        size_t start = begin;
+        unsigned misses = 0;
+        clusterStarts.push_back(begin);
+        for (size_t t = begin; t < end; ++t) {
+            misses += triangleMisses(cache, &indices[t * 3]);
+            // Require a minimum size so tiny clusters don't fragment the order
+            if (t + 1 < end && t + 1 - start >= 8 && (float)misses / (float)(t + 1 - start) <= clusterThreshold) {
+                clusterStarts.push_back(t + 1);
+                start = t + 1;
+                misses = 0;
+                cache.flush();
+            }
+        }
+    }
+
+    // Mesh centroid, weighted by triangle area
+    glm::dvec3 meshCentroid(0.0);
+    double meshArea = 0.0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        glm::vec3 p0 = vertices[indices[t * 3]].position;
+        glm::vec3 p1 = vertices[indices[t * 3 + 1]].position;
+        glm::vec3 p2 = vertices[indices[t * 3 + 2]].position;
+        double area = glm::length(glm::cross(p1 - p0, p2 - p0));
+        meshCentroid += glm::dvec3(p0 + p1 + p2) * (area / 3.0);
+        meshArea += area;
+    }
+    if (meshArea > 0.0) meshCentroid /= meshArea;
+
+    // Sort key: how far the cluster sits out along its own average normal
+    struct Cluster {
+        size_t begin, end;
+        double sortKey;
+    };
+    std::vector<Cluster> clusters;
+    clusters.reserve(clusterStarts.size());
+    for (size_t c = 0; c < clusterStarts.size(); ++c) {
+        size_t begin = clusterStarts[c];
+        size_t end = (c + 1 < clusterStarts.size()) ? clusterStarts[c + 1] : triangleCount;
+
+        glm::dvec3 centroid(0.0), normal(0.0);
+        double area = 0.0;
+        for (size_t t = begin; t < end; ++t) {
+            glm::vec3 p0 = vertices[indices[t * 3]].position;
+            glm::vec3 p1 = vertices[indices[t * 3 + 1]].position;
+            glm::vec3 p2 = vertices[indices[t * 3 + 2]].position;
+            glm::dvec3 n = glm::dvec3(glm::cross(p1 - p0, p2 - p0));  // Length = 2 * area
+            double triangleArea = glm::length(n);
+            centroid += glm::dvec3(p0 + p1 + p2) * (triangleArea / 3.0);
+            normal += n;
+            area += triangleArea;
+        }
+        if (area > 0.0) centroid /= area;
+        double normalLength = glm::length(normal);
+        double key = normalLength > 0.0 ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0;
+        clusters.push_back({begin, end, key});
+    }
+
+    // Stable so equal keys keep the cache-optimized order and the result is deterministic
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) {
+        return a.sortKey > b.sortKey;
+    });
+
+    std::vector<GLuint> output;
+    output.reserve(indices.size());
+    for (const auto& cluster : clusters) {
+        output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+    }
+    indices.swap(output);
+    return clusters.size();
+}
+
+size_t optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<GLuint>& indices) {
+    constexpr GLuint unused = ~0u;
+    std::vector<GLuint> remap(vertices.size(), unused);
+    std::vector<Vertex> reordered;
+    reordered.reserve(vertices.size());
+
+    for (GLuint& index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = (GLuint)reordered.size();
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    size_t removed = vertices.size() - reordered.size();
+    vertices.swap(reordered);
+    return removed;
+}
+
+MeshOptimizationReport optimizeMesh(std::vector<Vertex>& vertices, std::vector<GLuint>& indices) {
+    MeshOptimizationReport report;
+    report.before = analyzeVertexCache(indices, vertices.size());
+
+    optimizeVertexCache(indices, vertices.size());
+    report.clusterCount = optimizeOverdraw(indices, vertices);
+    report.removedVertexCount = optimizeVertexFetch(vertices, indices);
+
+    report.after = analyzeVertexCache(indices, vertices.size());
+    return report;
+}
@@ -0,0 +1,268 @@
+#include "rendering/MeshSimplifier.h"
+#include "rendering/MeshOptimizer.h"
+#include "utils/FlatHashMap.h"
+#include "utils/Hash.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+    // Sum of squared distances to a set of planes, as a symmetric 4x4 matrix (upper triangle).
+    // Planes are weighted by triangle area; weight tracks the total so errors can be normalized
+    struct Quadric {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+        double weight = 0;
+
+        static Quadric fromPlane(const glm::dvec3& n, double d, double w) {
+            Quadric q;
+            q.a2 = n.x * n.x * w; q.ab = n.x * n.y * w; q.ac = n.x * n.z * w; q.ad = n.x * d * w;
+            q.b2 = n.y * n.y * w; q.bc = n.y * n.z * w; q.bd = n.y * d * w;
+            q.c2 = n.z * n.z * w; q.cd = n.z * d * w;
+            q.d2 = d * d * w;
+            q.weight = w;
+            return q;
+        }
+
+        Quadric& operator+=(const Quadric& o) {
+            a2 += o.a2; ab += o.ab; ac += o.ac; ad += o.ad;
+            b2 += o.b2; bc += o.bc; bd += o.bd;
+            c2 += o.c2; cd += o.cd;
+            d2 += o.d2;
+            weight += o.weight;
+            return *this;
+        }
+
+        // Weighted mean squared distance from p to the planes
+        double error(const glm::dvec3& p) const {
+            double e = a2 * p.x * p.x + 2.0 * ab * p.x * p.y + 2.0 * ac * p.x * p.z + 2.0 * ad * p.x
+                     + b2 * p.y * p.y + 2.0 * bc * p.y * p.z + 2.0 * bd * p.y
+                     + c2 * p.z * p.z + 2.0 * cd * p.z
+                     + d2;
+            return weight > 0.0 ? std::max(e, 0.0) / weight : 0.0;
+        }
+    };
+
+    struct PositionHash {
+        size_t operator()(const glm::vec3& p) const {
+            // + 0.0f folds -0.0 into 0.0 so equal positions hash equally
+            float components[3] = {p.x + 0.0f, p.y + 0.0f, p.z + 0.0f};
+            return (size_t)hashBytes(components, sizeof(components));
+        }
+    };
+
+    struct Collapse {
+        GLuint from;  // Canonical vertex that goes away
+        GLuint to;    // Vertex (actual index) it merges into
+        double cost;
+    };
+
+    uint64_t edgeKey(GLuint a, GLuint b) {
+        return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+    }
+
+    // Drop triangles that reference the same welded position twice
+    void removeDegenerates(std::vector<GLuint>& indices, const std::vector<GLuint>& weld) {
+        size_t write = 0;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            GLuint a = weld[indices[i]], b = weld[indices[i + 1]], c = weld[indices[i + 2]];
+            if (a == b || b == c || a == c) continue;
+            indices[write++] = indices[i];
+            indices[write++] = indices[i + 1];
+            indices[write++] = indices[i + 2];
+        }
+        indices.resize(write);
+    }
+}
+
+std::vector<GLuint> simplifyMesh(std::span<const Vertex> vertices, std::span<const GLuint> indices,
+                                 size_t targetIndexCount, float* resultError) {
+    size_t vertexCount = vertices.size();
+    std::vector<GLuint> result(indices.begin(), indices.end() - indices.size() % 3);
+    if (resultError) *resultError = 0.0f;
+
+    // Weld vertices by position: attributes may split a position into several vertices, but geometry
+    // decisions (quadrics, borders, collapses) are made once per position on its first ("canonical") vertex
+    std::vector<GLuint> weld(vertexCount);
+    std::vector<GLuint> groupSize(vertexCount, 0);
+    {
+        FlatHashMap<glm::vec3, GLuint, PositionHash> positions(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            weld[v] = *positions.tryEmplace(vertices[v].position, (GLuint)v).first;
+            ++groupSize[weld[v]];
+        }
+    }
+    removeDegenerates(result, weld);
+
+    // Vertices that must stay put: attribute seams, plus open or non-manifold edges
+    std::vector<bool> locked(vertexCount, false);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (groupSize[v] > 1) locked[v] = true;
+    }
+    {
+        FlatHashMap<uint64_t, GLuint> edgeUses(result.size());
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                ++edgeUses[edgeKey(weld[result[i + k]], weld[result[i + (k + 1) % 3]])];
+            }
+        }
+        edgeUses.forEach([&](uint64_t key, GLuint uses) {
+            if (uses != 2) {
+                locked[(GLuint)(key >> 32)] = true;
+                locked[(GLuint)key] = true;
+            }
+        });
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < result.size(); i += 3) {
+        glm::dvec3 p0 = vertices[result[i]].position;
+        glm::dvec3 p1 = vertices[result[i + 1]].position;
+        glm::dvec3 p2 = vertices[result[i + 2]].position;
+        glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+        double length = glm::length(n);
+        if (length == 0.0) continue;
+        n /= length;
+        Quadric q = Quadric::fromPlane(n, -glm::dot(n, p0), length * 0.5);
+        for (int k = 0; k < 3; ++k) {
+            quadrics[weld[result[i + k]]] += q;
+        }
+    }
+
+    constexpr GLuint noCollapse = ~0u;
+    std::vector<GLuint> collapseTo(vertexCount, noCollapse);
+    std::vector<bool> touched(vertexCount);
+    std::vector<GLuint> offsets(vertexCount + 1);
+    std::vector<GLuint> adjacency;
+    std::vector<Collapse> candidates;
+    size_t targetTriangles = targetIndexCount / 3;
+    double maxError = 0.0;
+
+    // Greedy passes: collapse the cheapest edges whose neighbourhoods don't overlap, then rebuild and repeat
+    while (result.size() / 3 > targetTriangles) {
+        size_t triangleCount = result.size() / 3;
+
+        // Triangles around each canonical vertex (CSR layout)
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (GLuint index : result) {
+            ++offsets[weld[index] + 1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        adjacency.resize(result.size());
+        {
+            std::vector<GLuint> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < result.size(); ++i) {
+                adjacency[fill[weld[result[i]]]++] = (GLuint)(i / 3);
+            }
+        }
+
+        // Every directed edge is a candidate collapse of its start onto its end
+        candidates.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; ++k) {
+                GLuint from = weld[result[i + k]];
+                GLuint to = result[i + (k + 1) % 3];
+                if (locked[from]) continue;
+                Quadric q = quadrics[from];
+                q += quadrics[weld[to]];
+                candidates.push_back({from, to, q.error(glm::dvec3(vertices[to].position))});
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) {
+            if (a.cost != b.cost) return a.cost < b.cost;
+            if (a.from != b.from) return a.from < b.from;
+            return a.to < b.to;
+        });
+
+        std::fill(touched.begin(), touched.end(), false);
+        size_t removedTriangles = 0;
+        size_t collapses = 0;
+        for (const Collapse& candidate : candidates) {
+            if (triangleCount - removedTriangles <= targetTriangles) break;
+            GLuint from = candidate.from;
+            GLuint to = weld[candidate.to];
+            if (touched[from] || touched[to]) continue;
+
+            // Reject collapses that would flip a surviving triangle around 'from'
+            glm::dvec3 target = vertices[candidate.to].position;
+            bool flips = false;
+            size_t removed = 0;
+            for (GLuint a = offsets[from]; a < offsets[from + 1] && !flips; ++a) {
+                const GLuint* triangle = &result[adjacency[a] * 3];
+                glm::dvec3 before[3], after[3];
+                bool sharesEdge = false;
+                for (int k = 0; k < 3; ++k) {
+                    GLuint corner = weld[triangle[k]];
+                    before[k] = vertices[triangle[k]].position;
+                    after[k] = (corner == from) ? target : before[k];
+                    sharesEdge |= (corner == to);
+                }
+                if (sharesEdge) {
+                    ++removed;
+                    continue;
+                }
+                glm::dvec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+                glm::dvec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+                flips = glm::dot(n0, n1) <= 0.0;
+            }
+            if (flips) continue;
+
+            // Lock the whole one-ring for the rest of the pass so later flip tests see current geometry
+            for (GLuint a = offsets[from]; a < offsets[from + 1]; ++a) {
+                const GLuint* triangle = &result[adjacency[a] * 3];
+                for (int k = 0; k < 3; ++k) {
+                    touched[weld[triangle[k]]] = true;
+                }
+            }
+            touched[to] = true;
+
+            collapseTo[from] = candidate.to;
+            quadrics[to] += quadrics[from];
+            maxError = std::max(maxError, candidate.cost);
+            removedTriangles += removed;
+            ++collapses;
+        }
+        if (collapses == 0) break;
+
+        // Apply this pass's collapses
+        for (GLuint& index : result) {
+            GLuint target = collapseTo[weld[index]];
+            if (target != noCollapse) index = target;
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            if (collapseTo[v] != noCollapse) {
+                collapseTo[v] = noCollapse;
+                locked[v] = true;  // Gone from the mesh
+            }
+        }
+        removeDegenerates(result, weld);
+    }
+
+    if (resultError) *resultError = (float)std::sqrt(maxError);
+    return result;
+}
+
+std::vector<MeshLOD> buildLODChain(std::span<const Vertex> vertices, std::vector<GLuint>& indices,
+                                   std::span<const float> ratios) {
+    std::vector<MeshLOD> lods;
+    lods.push_back({0, (GLuint)indices.size(), 0.0f});
+
+    // Every level is simplified from LOD 0 (not the previous level) so errors don't compound
+    std::vector<GLuint> base = indices;
+    size_t baseTriangles = base.size() / 3;
+    for (float ratio : ratios) {
+        size_t target = (size_t)(baseTriangles * ratio) * 3;
+        float error = 0.0f;
+        std::vector<GLuint> level = simplifyMesh(vertices, base, target, &error);
+
+        // Stop once simplification stalls (e.g. everything left is locked)
+        if (level.empty() || level.size() > lods.back().indexCount * 0.95) break;
+
+        optimizeVertexCache(level, vertices.size());
+        lods.push_back({(GLuint)indices.size(), (GLuint)level.size(), error});
+        indices.insert(indices.end(), level.begin(), level.end());
+    }
+    return lods;
+}
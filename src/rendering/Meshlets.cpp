@@ -0,0 +1,193 @@
+#include "rendering/Meshlets.h"
+#include "rendering/MeshAdjacency.h"
+#include "utils/FrustumCulling.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+    // Bounding sphere and normal cone of a run of triangles
+    void computeMeshletBounds(Meshlet& meshlet, std::span<const Vertex> vertices, std::span<const GLuint> indices) {
+        const GLuint* triangles = indices.data() + meshlet.indexOffset;
+
+        glm::vec3 boundsMin(std::numeric_limits<float>::max());
+        glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+        for (GLuint i = 0; i < meshlet.indexCount; ++i) {
+            boundsMin = glm::min(boundsMin, vertices[triangles[i]].position);
+            boundsMax = glm::max(boundsMax, vertices[triangles[i]].position);
+        }
+        meshlet.center = (boundsMin + boundsMax) * 0.5f;
+        meshlet.radius = 0.0f;
+        for (GLuint i = 0; i < meshlet.indexCount; ++i) {
+            meshlet.radius = std::max(meshlet.radius, glm::length(vertices[triangles[i]].position - meshlet.center));
+        }
+
+        // Cone axis: mean of the unit triangle normals; the cutoff follows from the widest deviation
+        std::vector<glm::vec3> normals;
+        normals.reserve(meshlet.indexCount / 3);
+        glm::vec3 axis(0.0f);
+        for (GLuint i = 0; i + 2 < meshlet.indexCount; i += 3) {
+            glm::vec3 p0 = vertices[triangles[i]].position;
+            glm::vec3 p1 = vertices[triangles[i + 1]].position;
+            glm::vec3 p2 = vertices[triangles[i + 2]].position;
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(n);
+            if (length == 0.0f) continue;
+            normals.push_back(n / length);
+            axis += normals.back();
+        }
+
+        float axisLength = glm::length(axis);
+        if (normals.empty() || axisLength == 0.0f) {
+            meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+            meshlet.coneCutoff = 1.0f;
+            return;
+        }
+        meshlet.coneAxis = axis / axisLength;
+
+        float minDot = 1.0f;
+        for (const auto& n : normals) {
+            minDot = std::min(minDot, glm::dot(n, meshlet.coneAxis));
+        }
+        // A cone of 90 degrees or wider always has a triangle facing the camera
+        meshlet.coneCutoff = (minDot <= 0.0f) ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+    }
+}
+
+std::vector<Meshlet> buildMeshlets(std::span<const Vertex> vertices, std::span<GLuint> indices,
+                                   GLuint indexOffset, GLuint indexCount) {
+    std::vector<Meshlet> meshlets;
+    std::span<const GLuint> source = indices.subspan(indexOffset, indexCount - indexCount % 3);
+    size_t triangleCount = source.size() / 3;
+    if (triangleCount == 0) return meshlets;
+
+    VertexTriangleAdjacency adjacency(source, vertices.size());
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<bool> inMeshlet(vertices.size(), false);
+    std::vector<GLuint> meshletVertices;
+    meshletVertices.reserve(maxMeshletVertices);
+
+    std::vector<GLuint> output;
+    output.reserve(source.size());
+    size_t seedCursor = 0;
+
+    while (output.size() < source.size()) {
+        Meshlet meshlet;
+        meshlet.indexOffset = indexOffset + (GLuint)output.size();
+        size_t meshletTriangles = 0;
+        glm::vec3 positionSum(0.0f);
+
+        auto newVertexCount = [&](size_t triangle) {
+            return (int)!inMeshlet[source[triangle * 3]] + (int)!inMeshlet[source[triangle * 3 + 1]] +
+                   (int)!inMeshlet[source[triangle * 3 + 2]];
+        };
+        auto addTriangle = [&](size_t triangle) {
+            emitted[triangle] = true;
+            for (int k = 0; k < 3; ++k) {
+                GLuint vertex = source[triangle * 3 + k];
+                output.push_back(vertex);
+                if (!inMeshlet[vertex]) {
+                    inMeshlet[vertex] = true;
+                    meshletVertices.push_back(vertex);
+                    positionSum += vertices[vertex].position;
+                }
+            }
+            ++meshletTriangles;
+        };
+
+        // Seed with the first unused triangle in the existing (cache-optimized) order
+        while (emitted[seedCursor]) ++seedCursor;
+        addTriangle(seedCursor);
+
+        // Grow across shared vertices: prefer triangles that add the fewest new vertices, then the closest
+        while (meshletTriangles < maxMeshletTriangles) {
+            glm::vec3 centroid = positionSum / (float)meshletVertices.size();
+            long long best = -1;
+            int bestNew = 4;
+            float bestDistance = std::numeric_limits<float>::max();
+
+            for (GLuint vertex : meshletVertices) {
+                for (GLuint a = adjacency.offsets[vertex]; a < adjacency.offsets[vertex + 1]; ++a) {
+                    GLuint triangle = adjacency.triangles[a];
+                    if (emitted[triangle]) continue;
+                    int added = newVertexCount(triangle);
+                    if (meshletVertices.size() + added > maxMeshletVertices || added > bestNew) continue;
+
+                    glm::vec3 triangleCenter = (vertices[source[triangle * 3]].position +
+                                                vertices[source[triangle * 3 + 1]].position +
+                                                vertices[source[triangle * 3 + 2]].position) / 3.0f;
+                    float distance = glm::length(triangleCenter - centroid);
+                    if (added < bestNew || distance < bestDistance ||
+                        (distance == bestDistance && (long long)triangle < best)) {
+                        best = triangle;
+                        bestNew = added;
+                        bestDistance = distance;
+                    }
+                }
+            }
+            if (best < 0) break;
+            addTriangle((size_t)best);
+        }
+
+        meshlet.indexCount = (GLuint)(meshletTriangles * 3);
+        meshlets.push_back(meshlet);
+
+        for (GLuint vertex : meshletVertices) {
+            inMeshlet[vertex] = false;
+        }
+        meshletVertices.clear();
+    }
+
+    std::copy(output.begin(), output.end(), indices.begin() + indexOffset);
+    for (auto& meshlet : meshlets) {
+        computeMeshletBounds(meshlet, vertices, indices);
+    }
+    return meshlets;
+}
+
+void cullMeshlets(std::span<const Meshlet> meshlets, const glm::mat4& viewProjection, const glm::mat4& model,
+                  const glm::vec3& cameraPosition, MeshletDrawList& drawList, MeshletCullStats& stats) {
+    // Work in mesh space: planes extracted from viewProjection * model are already in mesh space, and
+    // backfacing is preserved by affine transforms, so only the camera position needs transforming
+    Frustum frustum;
+    frustum.extractPlanes(viewProjection * model);
+    glm::vec3 camera = glm::vec3(glm::inverse(model) * glm::vec4(cameraPosition, 1.0f));
+
+    GLuint pendingOffset = 0, pendingCount = 0;
+    auto flush = [&]() {
+        if (pendingCount == 0) return;
+        drawList.counts.push_back((GLsizei)pendingCount);
+        drawList.offsets.push_back((const void*)(pendingOffset * sizeof(GLuint)));
+        pendingCount = 0;
+    };
+
+    for (const auto& meshlet : meshlets) {
+        ++stats.meshletsTested;
+        stats.trianglesTested += meshlet.indexCount / 3;
+
+        bool visible = frustum.isSphereInside(meshlet.center, meshlet.radius);
+        if (!visible) {
+            ++stats.meshletsFrustumCulled;
+        } else {
+            // Every triangle faces away when the camera is outside the cone widened by the sphere
+            glm::vec3 toMeshlet = meshlet.center - camera;
+            if (glm::dot(toMeshlet, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toMeshlet) + meshlet.radius) {
+                ++stats.meshletsConeCulled;
+                visible = false;
+            }
+        }
+
+        if (!visible) {
+            stats.trianglesRejected += meshlet.indexCount / 3;
+            continue;
+        }
+        if (pendingCount > 0 && pendingOffset + pendingCount == meshlet.indexOffset) {
+            pendingCount += meshlet.indexCount;
+        } else {
+            flush();
+            pendingOffset = meshlet.indexOffset;
+            pendingCount = meshlet.indexCount;
+        }
+    }
+    flush();
+}
@@ -0,0 +1,415 @@
+#include "rendering/MikkTSpace.h"
+#include "utils/FlatHashMap.h"
+#include "utils/Hash.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <numeric>
+#include <glm/glm.hpp>
+
+// A port of the MikkTSpace reference implementation (Morten S. Mikkelsen's mikktspace.c) for triangle lists.
+// The steps and their order follow genTangSpace: weld corners, set degenerate triangles aside, evaluate each
+// triangle's dP/ds and dP/dt, match neighbours, grow groups around each vertex, split groups into subgroups and
+// average a frame per subgroup, then give degenerate triangles a frame from a good triangle. Which corners share
+// a frame depends on triangle order, neighbour matching and group traversal order, so all of them are kept.
+// Only the tangent and its sign are output, so the magnitudes and the bitangent average the reference also
+// computes are left out; the per-triangle bitangent direction still decides how groups split.
+
+namespace {
+    constexpr GLuint noIndex = ~0u;
+
+    // genTangSpaceDefault's 180 degree angular threshold, as the cosine groups are compared against
+    constexpr float thresholdCos = -1.0f;
+
+    // Corners are welded when position, normal and texture coordinate are all equal
+    struct WeldKey {
+        glm::vec3 position;
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+
+        bool operator==(const WeldKey& other) const {
+            return position == other.position && normal == other.normal && texCoord == other.texCoord;
+        }
+    };
+
+    struct WeldKeyHash {
+        size_t operator()(const WeldKey& key) const {
+            // + 0.0f folds -0.0 into 0.0 so equal keys hash equally
+            float components[8] = {key.position.x + 0.0f, key.position.y + 0.0f, key.position.z + 0.0f,
+                                   key.normal.x + 0.0f, key.normal.y + 0.0f, key.normal.z + 0.0f,
+                                   key.texCoord.x + 0.0f, key.texCoord.y + 0.0f};
+            return (size_t)hashBytes(components, sizeof(components));
+        }
+    };
+
+    bool notZero(float x) {
+        return std::fabs(x) > FLT_MIN;
+    }
+
+    bool notZero(const glm::vec3& v) {
+        return notZero(v.x) || notZero(v.y) || notZero(v.z);
+    }
+
+    // v scaled by 1 / |v|, or v itself when it's zero (the reference leaves those alone)
+    glm::vec3 normalizeNotZero(const glm::vec3& v) {
+        return notZero(v) ? v * (1.0f / glm::length(v)) : v;
+    }
+
+    // v with its component along the unit vector n removed
+    glm::vec3 project(const glm::vec3& n, const glm::vec3& v) {
+        return v - n * glm::dot(n, v);
+    }
+
+    struct TriangleInfo {
+        int neighbors[3] = {-1, -1, -1};  // Triangle across the edge from corner i to corner i + 1
+        int groups[3] = {-1, -1, -1};     // Group each corner joined
+        glm::vec3 os{0.0f};               // Unit dP/ds and dP/dt, negated when the UVs are mirrored
+        glm::vec3 ot{0.0f};
+        bool groupWithAny = true;         // Degenerate UVs: joins whichever group reaches it first
+        bool orientPreserving = false;    // UV winding agrees with the triangle's winding
+        GLuint source = 0;                // Triangle number in the input
+    };
+
+    struct Group {
+        GLuint vertex;          // Welded vertex whose corners the group covers
+        bool orientPreserving;
+        size_t first;           // Member triangles, in the shared member list
+        size_t count;
+    };
+
+    struct TangentSpace {
+        glm::vec3 tangent{1.0f, 0.0f, 0.0f};  // The reference's frame for corners no group reached
+        bool orientPreserving = false;
+    };
+
+    class MikkTSpaceBuilder {
+    public:
+        MikkTSpaceBuilder(const std::vector<Vertex>& vertices, const std::vector<GLuint>& indices)
+            : vertices(vertices), indices(indices) {}
+
+        // One frame per input corner (3 per triangle, in index order)
+        std::vector<TangentSpace> build() {
+            size_t triangleCount = indices.size() / 3;
+            weldVertices();
+
+            // Triangles with two welded corners at the same position go last, good triangles keep their order
+            std::vector<GLuint> degenerates;
+            triangles.reserve(triangleCount);
+            corners.reserve(triangleCount * 3);
+            for (GLuint t = 0; t < triangleCount; ++t) {
+                const glm::vec3& p0 = vertices[weld[indices[t * 3]]].position;
+                const glm::vec3& p1 = vertices[weld[indices[t * 3 + 1]]].position;
+                const glm::vec3& p2 = vertices[weld[indices[t * 3 + 2]]].position;
+                if (p0 == p1 || p0 == p2 || p1 == p2) {
+                    degenerates.push_back(t);
+                    continue;
+                }
+                TriangleInfo triangle;
+                triangle.source = t;
+                triangles.push_back(triangle);
+                for (int i = 0; i < 3; ++i) {
+                    corners.push_back(weld[indices[t * 3 + i]]);
+                }
+            }
+
+            initTriangles();
+            buildNeighbors();
+            buildGroups();
+
+            std::vector<TangentSpace> spaces(triangleCount * 3);
+            generateSpaces(spaces);
+
+            // Degenerate corners copy the frame of the first good corner on the same welded vertex
+            std::vector<GLuint> firstCorner(vertices.size(), noIndex);
+            for (size_t c = 0; c < corners.size(); ++c) {
+                if (firstCorner[corners[c]] == noIndex) firstCorner[corners[c]] = (GLuint)c;
+            }
+            for (GLuint t : degenerates) {
+                for (int i = 0; i < 3; ++i) {
+                    GLuint c = firstCorner[weld[indices[t * 3 + i]]];
+                    if (c != noIndex) spaces[t * 3 + i] = spaces[triangles[c / 3].source * 3 + c % 3];
+                }
+            }
+            return spaces;
+        }
+
+    private:
+        const std::vector<Vertex>& vertices;
+        const std::vector<GLuint>& indices;
+        std::vector<GLuint> weld;             // Welded vertex of each vertex
+        std::vector<TriangleInfo> triangles;  // Good triangles only
+        std::vector<GLuint> corners;          // Welded vertex of each good triangle corner
+        std::vector<Group> groups;
+        std::vector<int> members;             // Group member triangles, each group's contiguous
+
+        void weldVertices() {
+            weld.resize(vertices.size());
+            FlatHashMap<WeldKey, GLuint, WeldKeyHash> welded(vertices.size());
+            for (size_t v = 0; v < vertices.size(); ++v) {
+                WeldKey key{vertices[v].position, vertices[v].normal, vertices[v].texCoord};
+                weld[v] = *welded.tryEmplace(key, (GLuint)v).first;
+            }
+        }
+
+        int cornerOf(int t, GLuint vertex) const {
+            return corners[t * 3] == vertex ? 0 : corners[t * 3 + 1] == vertex ? 1 : 2;
+        }
+
+        // InitTriInfo: first order derivatives of position with respect to texture coordinates
+        void initTriangles() {
+            for (size_t f = 0; f < triangles.size(); ++f) {
+                TriangleInfo& triangle = triangles[f];
+                const Vertex& v1 = vertices[corners[f * 3]];
+                const Vertex& v2 = vertices[corners[f * 3 + 1]];
+                const Vertex& v3 = vertices[corners[f * 3 + 2]];
+                float t21x = v2.texCoord.x - v1.texCoord.x;
+                float t21y = v2.texCoord.y - v1.texCoord.y;
+                float t31x = v3.texCoord.x - v1.texCoord.x;
+                float t31y = v3.texCoord.y - v1.texCoord.y;
+                glm::vec3 d1 = v2.position - v1.position;
+                glm::vec3 d2 = v3.position - v1.position;
+
+                float signedAreaSTx2 = t21x * t31y - t21y * t31x;
+                glm::vec3 os = d1 * t31y - d2 * t21y;
+                glm::vec3 ot = d1 * -t31x + d2 * t21x;
+                triangle.orientPreserving = signedAreaSTx2 > 0.0f;
+
+                if (notZero(signedAreaSTx2)) {
+                    float absArea = std::fabs(signedAreaSTx2);
+                    float lengthOs = glm::length(os);
+                    float lengthOt = glm::length(ot);
+                    float sign = triangle.orientPreserving ? 1.0f : -1.0f;
+                    if (notZero(lengthOs)) triangle.os = os * (sign / lengthOs);
+                    if (notZero(lengthOt)) triangle.ot = ot * (sign / lengthOt);
+                    if (notZero(lengthOs / absArea) && notZero(lengthOt / absArea)) triangle.groupWithAny = false;
+                }
+            }
+        }
+
+        // BuildNeighborsFast: edges ordered by (lower vertex, upper vertex, triangle); each unmatched directed
+        // edge pairs with the first later triangle whose reverse edge is still unmatched. The reference sorts all
+        // edges; bucketing them by lower vertex in triangle order and sorting each small bucket by upper vertex
+        // gives the same order
+        void buildNeighbors() {
+            struct Edge {
+                GLuint hi;
+                int triangle;
+            };
+            std::vector<GLuint> offsets(vertices.size() + 1, 0);
+            for (size_t c = 0; c < corners.size(); ++c) {
+                size_t next = c % 3 == 2 ? c - 2 : c + 1;
+                ++offsets[std::min(corners[c], corners[next]) + 1];
+            }
+            std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+            std::vector<Edge> edges(corners.size());
+            std::vector<GLuint> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t c = 0; c < corners.size(); ++c) {
+                size_t next = c % 3 == 2 ? c - 2 : c + 1;
+                GLuint lo = std::min(corners[c], corners[next]);
+                edges[fill[lo]++] = {std::max(corners[c], corners[next]), (int)(c / 3)};
+            }
+
+            // GetEdge: which of t's edges joins lo and hi, and its direction in t
+            auto edgeOf = [&](int t, GLuint lo, GLuint hi, GLuint& from, GLuint& to) {
+                const GLuint* v = &corners[t * 3];
+                if (v[0] == lo || v[0] == hi) {
+                    if (v[1] == lo || v[1] == hi) {
+                        from = v[0]; to = v[1];
+                        return 0;
+                    }
+                    from = v[2]; to = v[0];
+                    return 2;
+                }
+                from = v[1]; to = v[2];
+                return 1;
+            };
+
+            for (GLuint lo = 0; lo < vertices.size(); ++lo) {
+                Edge* begin = edges.data() + offsets[lo];
+                Edge* end = edges.data() + offsets[lo + 1];
+                std::stable_sort(begin, end, [](const Edge& a, const Edge& b) { return a.hi < b.hi; });
+
+                for (Edge* edge = begin; edge != end; ++edge) {
+                    GLuint fromA, toA;
+                    int edgeA = edgeOf(edge->triangle, lo, edge->hi, fromA, toA);
+                    if (triangles[edge->triangle].neighbors[edgeA] != -1) continue;
+
+                    for (Edge* other = edge + 1; other != end && other->hi == edge->hi; ++other) {
+                        GLuint fromB, toB;
+                        int t = other->triangle;
+                        int edgeB = edgeOf(t, lo, edge->hi, fromB, toB);
+                        if (fromA == toB && toA == fromB && triangles[t].neighbors[edgeB] == -1) {
+                            triangles[edge->triangle].neighbors[edgeA] = t;
+                            triangles[t].neighbors[edgeB] = edge->triangle;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        // AssignRecur: add t to group g through its corner on the group's vertex, then spread to the triangles
+        // on either side of that corner. Stops at corners already grouped and at mirrored UVs
+        void assignRecursive(int t, int g) {
+            TriangleInfo& triangle = triangles[t];
+            Group& group = groups[g];
+            int i = cornerOf(t, group.vertex);
+            if (triangle.groups[i] != -1) return;
+
+            // The first group to reach a triangle with degenerate UVs decides its orientation
+            if (triangle.groupWithAny && triangle.groups[0] == -1 && triangle.groups[1] == -1 &&
+                triangle.groups[2] == -1) {
+                triangle.orientPreserving = group.orientPreserving;
+            }
+            if (triangle.orientPreserving != group.orientPreserving) return;
+
+            members.push_back(t);
+            ++group.count;
+            triangle.groups[i] = g;
+
+            int left = triangle.neighbors[i];
+            int right = triangle.neighbors[(i + 2) % 3];
+            if (left >= 0) assignRecursive(left, g);
+            if (right >= 0) assignRecursive(right, g);
+        }
+
+        // Build4RuleGroups: every ungrouped corner of a triangle with usable UVs starts a group
+        void buildGroups() {
+            groups.reserve(corners.size());
+            members.reserve(corners.size());
+            for (size_t f = 0; f < triangles.size(); ++f) {
+                for (int i = 0; i < 3; ++i) {
+                    TriangleInfo& triangle = triangles[f];
+                    if (triangle.groupWithAny || triangle.groups[i] != -1) continue;
+
+                    int g = (int)groups.size();
+                    groups.push_back({corners[f * 3 + i], triangle.orientPreserving, members.size(), 1});
+                    members.push_back((int)f);
+                    triangle.groups[i] = g;
+
+                    int left = triangle.neighbors[i];
+                    int right = triangle.neighbors[(i + 2) % 3];
+                    if (left >= 0) assignRecursive(left, g);
+                    if (right >= 0) assignRecursive(right, g);
+                }
+            }
+        }
+
+        // GenerateTSpaces: each member's corner gets the frame of the members whose projected derivatives
+        // agree with its own (within the threshold), averaged once per distinct subgroup
+        void generateSpaces(std::vector<TangentSpace>& spaces) {
+            std::vector<glm::vec3> projectedOs, projectedOt;
+            std::vector<int> subgroups;          // The group's distinct subgroups, back to back
+            std::vector<size_t> subgroupStarts;  // Where each one starts in subgroups, plus the end
+            std::vector<glm::vec3> subgroupTangents;
+            std::vector<int> subgroup;
+
+            for (size_t g = 0; g < groups.size(); ++g) {
+                const Group& group = groups[g];
+                const int* groupMembers = &members[group.first];
+                glm::vec3 n = vertices[group.vertex].normal;
+
+                projectedOs.resize(group.count);
+                projectedOt.resize(group.count);
+                for (size_t m = 0; m < group.count; ++m) {
+                    const TriangleInfo& triangle = triangles[groupMembers[m]];
+                    projectedOs[m] = normalizeNotZero(project(n, triangle.os));
+                    projectedOt[m] = normalizeNotZero(project(n, triangle.ot));
+                }
+
+                subgroups.clear();
+                subgroupStarts.assign(1, 0);
+                subgroupTangents.clear();
+                for (size_t m = 0; m < group.count; ++m) {
+                    int f = groupMembers[m];
+                    subgroup.clear();
+                    for (size_t k = 0; k < group.count; ++k) {
+                        int t = groupMembers[k];
+                        bool any = triangles[f].groupWithAny || triangles[t].groupWithAny;
+                        if (any || f == t || (glm::dot(projectedOs[m], projectedOs[k]) > thresholdCos &&
+                                              glm::dot(projectedOt[m], projectedOt[k]) > thresholdCos)) {
+                            subgroup.push_back(t);
+                        }
+                    }
+                    std::sort(subgroup.begin(), subgroup.end());
+
+                    size_t s = 0;
+                    while (s < subgroupTangents.size() &&
+                           !std::equal(subgroup.begin(), subgroup.end(), subgroups.begin() + subgroupStarts[s],
+                                       subgroups.begin() + subgroupStarts[s + 1])) {
+                        ++s;
+                    }
+                    if (s == subgroupTangents.size()) {
+                        subgroups.insert(subgroups.end(), subgroup.begin(), subgroup.end());
+                        subgroupStarts.push_back(subgroups.size());
+                        subgroupTangents.push_back(evalTangent(subgroup, group.vertex));
+                    }
+
+                    const TriangleInfo& triangle = triangles[f];
+                    int i = cornerOf(f, group.vertex);
+                    spaces[triangle.source * 3 + i] = {subgroupTangents[s], group.orientPreserving};
+                }
+            }
+        }
+
+        // EvalTspace: average of the members' projected dP/ds, weighted by the angle of their corner on vertex
+        glm::vec3 evalTangent(const std::vector<int>& subgroup, GLuint vertex) const {
+            glm::vec3 n = vertices[vertex].normal;
+            glm::vec3 sum(0.0f);
+            for (int t : subgroup) {
+                const TriangleInfo& triangle = triangles[t];
+                if (triangle.groupWithAny) continue;
+
+                int i = cornerOf(t, vertex);
+                glm::vec3 os = normalizeNotZero(project(n, triangle.os));
+                const glm::vec3& p0 = vertices[corners[t * 3 + (i + 2) % 3]].position;
+                const glm::vec3& p1 = vertices[corners[t * 3 + i]].position;
+                const glm::vec3& p2 = vertices[corners[t * 3 + (i + 1) % 3]].position;
+                glm::vec3 edge1 = normalizeNotZero(project(n, p0 - p1));
+                glm::vec3 edge2 = normalizeNotZero(project(n, p2 - p1));
+
+                float cosine = std::clamp(glm::dot(edge1, edge2), -1.0f, 1.0f);
+                float angle = (float)std::acos((double)cosine);
+                sum += os * angle;
+            }
+            return normalizeNotZero(sum);
+        }
+    };
+}
+
+void calculateTangentsMikkTSpace(std::vector<Vertex>& vertices, std::vector<GLuint>& indices) {
+    std::vector<TangentSpace> spaces = MikkTSpaceBuilder(vertices, indices).build();
+
+    // A vertex's first frame is written in place; other frames go to copies chained from it through nextCopy
+    size_t originalCount = vertices.size();
+    std::vector<GLuint> nextCopy(originalCount, noIndex);
+    std::vector<bool> written(originalCount, false);
+    for (size_t c = 0; c < spaces.size(); ++c) {
+        GLuint v = indices[c];
+        glm::vec3 tangent = spaces[c].tangent;
+        glm::vec3 bitangent = glm::cross(vertices[v].normal, tangent) * (spaces[c].orientPreserving ? 1.0f : -1.0f);
+        if (!written[v]) {
+            vertices[v].tangent = tangent;
+            vertices[v].bitangent = bitangent;
+            written[v] = true;
+            continue;
+        }
+
+        GLuint copy = v, last = v;
+        while (copy != noIndex && (vertices[copy].tangent != tangent || vertices[copy].bitangent != bitangent)) {
+            last = copy;
+            copy = nextCopy[copy];
+        }
+        if (copy == noIndex) {
+            Vertex split = vertices[v];
+            split.tangent = tangent;
+            split.bitangent = bitangent;
+            copy = (GLuint)vertices.size();
+            nextCopy[last] = copy;
+            vertices.push_back(split);
+            nextCopy.push_back(noIndex);
+        }
+        indices[c] = copy;
+    }
+}
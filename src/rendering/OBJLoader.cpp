@@ -1,188 +1,755 @@
 #include "rendering/OBJLoader.h"
+#include "rendering/GeometryProcessing.h"
+#include "utils/MappedFile.h"
+#include "utils/Parallel.h"
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <functional>
 #include <iostream>
+#include <stdexcept>
+#include <unordered_map>
 
-// Function to calculate normals from geometry when they're missing
-void calculateNormalsFromGeometry(std::vector<Vertex>& vertices, const std::vector<GLuint>& indices) {
-    // Initialize all normals to zero
-    for (auto& vertex : vertices) {
-        vertex.normal = glm::vec3(0.0f);
-    }
-    
-    // Calculate normals for each triangle
-    for (size_t i = 0; i < indices.size(); i += 3) {
-        if (i + 2 >= indices.size()) break;
-        
-        GLuint idx0 = indices[i];
-        GLuint idx1 = indices[i + 1];
-        GLuint idx2 = indices[i + 2];
-        
-        if (idx0 >= vertices.size() || idx1 >= vertices.size() || idx2 >= vertices.size()) continue;
-        
-        // Get the three vertices of the triangle
-        glm::vec3 v0 = vertices[idx0].position;
-        glm::vec3 v1 = vertices[idx1].position;
-        glm::vec3 v2 = vertices[idx2].position;
-        
-        // Calculate two edge vectors
-        glm::vec3 edge1 = v1 - v0;
-        glm::vec3 edge2 = v2 - v0;
-        
-        // Calculate the normal using cross product
-        glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
-        
-        // Add this normal to all three vertices (for smooth shading)
-        vertices[idx0].normal += normal;
-        vertices[idx1].normal += normal;
-        vertices[idx2].normal += normal;
-    }
-    
-    // Normalize all accumulated normals
-    for (auto& vertex : vertices) {
-        if (glm::length(vertex.normal) > 0.0f) {
-            vertex.normal = glm::normalize(vertex.normal);
+namespace {
+    using OBJMeshData = std::pair<std::vector<Vertex>, std::vector<GLuint>>;
+
+    // Number of each attribute defined so far, needed to resolve relative (negative) indices
+    struct OBJCounts {
+        size_t positions = 0;
+        size_t texCoords = 0;
+        size_t normals = 0;
+    };
+
+    // Build the interleaved vertex for a face corner, with defaults for missing attributes
+    Vertex makeVertex(const OBJKey& key,
+                      const std::vector<glm::vec3>& positions,
+                      const std::vector<glm::vec2>& texCoords,
+                      const std::vector<glm::vec3>& normals) {
+        Vertex vertex{};
+
+        // Set position
+        vertex.position = positions[key.positionIndex];
+
+        // Set texture coordinate (with default if missing)
+        if (key.texCoordIndex >= 0 && key.texCoordIndex < (int)texCoords.size()) {
+            vertex.texCoord = texCoords[key.texCoordIndex];
+        } else {
+            vertex.texCoord = glm::vec2(0.0f, 0.0f);  // Default
+        }
+
+        // Set normal (with default if missing)
+        if (key.normalIndex >= 0 && key.normalIndex < (int)normals.size()) {
+            vertex.normal = normals[key.normalIndex];
         } else {
-            // Fallback for vertices with no normal contribution
-            vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);  // Default up
         }
+
+        // Set color (OBJ files don't have colors, so use default)
+        vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);  // White
+
+        return vertex;
     }
-}
 
-std::pair<std::vector<Vertex>, std::vector<GLuint>> loadOBJFile(const std::string& filepath) {
-    std::ifstream file(filepath);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open OBJ file: " + filepath);
-    }
-
-    // Temporary storage for OBJ data
-    std::vector<glm::vec3> positions;
-    std::vector<glm::vec2> texCoords;
-    std::vector<glm::vec3> normals;
-    
-    // Final output
-    std::vector<Vertex> vertices;
-    std::vector<GLuint> indices;
-    
-    // For vertex deduplication
-    std::unordered_map<OBJKey, GLuint, OBJKeyHash> vertexMap;
-    vertexMap.reserve(1024);  // Reserve space for efficiency
-
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == '#') continue;  // Skip empty lines and comments
-        
-        std::istringstream lineStream(line);
-        std::string token;
-        lineStream >> token;
-        
-        if (token == "v") {
-            // Vertex position: v x y z
-            glm::vec3 position;
-            lineStream >> position.x >> position.y >> position.z;
-            positions.push_back(position);
-            
-        } else if (token == "vt") {
-            // Texture coordinate: vt u v
-            glm::vec2 texCoord;
-            lineStream >> texCoord.x >> texCoord.y;
-            texCoords.push_back(texCoord);
-            
-        } else if (token == "vn") {
-            // Normal: vn x y z
-            glm::vec3 normal;
-            lineStream >> normal.x >> normal.y >> normal.z;
-            normals.push_back(normal);
-            
-        } else if (token == "f") {
-            // Face: f v1/vt1/vn1 v2/vt2/vn2 v3/vt3/vn3
-            std::vector<std::string> faceTokens;
-            std::string faceToken;
-            
-            // Read all face tokens
-            while (lineStream >> faceToken) {
-                faceTokens.push_back(faceToken);
+    void checkPositionIndex(const OBJKey& key, size_t positionCount) {
+        if (key.positionIndex < 0 || key.positionIndex >= (int)positionCount) {
+            throw std::runtime_error("OBJ face references a missing vertex position");
+        }
+    }
+
+    // Collects the OBJ attribute streams and turns face corners into deduplicated vertices.
+    // Used by the serial load modes; the parallel mode reproduces its output exactly.
+    struct OBJMeshBuilder {
+        // Temporary storage for OBJ data
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> texCoords;
+        std::vector<glm::vec3> normals;
+
+        // Final output
+        std::vector<Vertex> vertices;
+        std::vector<GLuint> indices;
+
+        // For vertex deduplication
+        OBJVertexMap vertexMap;
+
+        explicit OBJMeshBuilder(size_t expectedVertices) : vertexMap(expectedVertices) {
+            vertices.reserve(expectedVertices);
+        }
+
+        OBJCounts counts() const {
+            return {positions.size(), texCoords.size(), normals.size()};
+        }
+
+        void addCorner(const OBJKey& key) {
+            // Check if we've seen this vertex combination before
+            if (const GLuint* existing = vertexMap.find(key)) {
+                // Reuse existing vertex
+                indices.push_back(*existing);
+                return;
             }
-            
-            // Process triangles (OBJ files can have quads or n-gons)
-            for (size_t i = 1; i + 1 < faceTokens.size(); ++i) {
-                std::string triangleVerts[3] = { faceTokens[0], faceTokens[i], faceTokens[i + 1] };
-                
-                // Process each vertex of the triangle
-                for (int k = 0; k < 3; ++k) {
-                    std::string& faceVert = triangleVerts[k];
-                    
-                    // Parse vertex format: v/vt/vn, v//vn, v/vt, or v
-                    int posIndex = 0, texIndex = -1, normIndex = -1;
-                    
-                    size_t firstSlash = faceVert.find('/');
-                    if (firstSlash == std::string::npos) {
-                        // Just vertex: "1"
-                        posIndex = parseIndex(faceVert);
-                    } else {
-                        // Has slashes: parse format
-                        size_t secondSlash = faceVert.find('/', firstSlash + 1);
-                        posIndex = parseIndex(faceVert.substr(0, firstSlash));
-                        
-                        if (secondSlash == std::string::npos) {
-                            // v/vt format: "1/1"
-                            std::string texStr = faceVert.substr(firstSlash + 1);
-                            if (!texStr.empty()) texIndex = parseIndex(texStr);
-                        } else {
-                            // v//vn or v/vt/vn format
-                            std::string mid = faceVert.substr(firstSlash + 1, secondSlash - firstSlash - 1);
-                            if (!mid.empty()) texIndex = parseIndex(mid);
-                            
-                            std::string normStr = faceVert.substr(secondSlash + 1);
-                            if (!normStr.empty()) normIndex = parseIndex(normStr);
-                        }
-                    }
-                    
-                    // Create key for deduplication
-                    OBJKey key{posIndex, texIndex, normIndex};
-                    
-                    // Check if we've seen this vertex combination before
-                    auto it = vertexMap.find(key);
-                    if (it != vertexMap.end()) {
-                        // Reuse existing vertex
-                        indices.push_back(it->second);
-                    } else {
-                        // Create new vertex
-                        Vertex vertex;
-                        
-                        // Set position
-                        vertex.position = positions[posIndex];
-                        
-                        // Set texture coordinate (with default if missing)
-                        if (texIndex >= 0 && texIndex < (int)texCoords.size()) {
-                            vertex.texCoord = texCoords[texIndex];
-                        } else {
-                            vertex.texCoord = glm::vec2(0.0f, 0.0f);  // Default
-                        }
-                        
-                        // Set normal (with default if missing)
-                        if (normIndex >= 0 && normIndex < (int)normals.size()) {
-                            vertex.normal = normals[normIndex];
+
+            checkPositionIndex(key, positions.size());
+
+            // Add vertex and track index
+            GLuint newIndex = (GLuint)vertices.size();
+            vertices.push_back(makeVertex(key, positions, texCoords, normals));
+            indices.push_back(newIndex);
+            vertexMap.tryEmplace(key, newIndex);
+        }
+
+        OBJMeshData finish() {
+            // If no normals were loaded from the file, calculate them from geometry
+            if (normals.empty()) {
+                calculateNormalsFromGeometry(vertices, indices);
+            }
+            return {std::move(vertices), std::move(indices)};
+        }
+    };
+
+    OBJMeshData loadOBJStream(const std::string& filepath) {
+        std::ifstream file(filepath);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open OBJ file: " + filepath);
+        }
+
+        OBJMeshBuilder builder(1024);
+
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty() || line[0] == '#') continue;  // Skip empty lines and comments
+
+            std::istringstream lineStream(line);
+            std::string token;
+            lineStream >> token;
+
+            if (token == "v") {
+                // Vertex position: v x y z
+                glm::vec3 position;
+                lineStream >> position.x >> position.y >> position.z;
+                builder.positions.push_back(position);
+
+            } else if (token == "vt") {
+                // Texture coordinate: vt u v
+                glm::vec2 texCoord;
+                lineStream >> texCoord.x >> texCoord.y;
+                builder.texCoords.push_back(texCoord);
+
+            } else if (token == "vn") {
+                // Normal: vn x y z
+                glm::vec3 normal;
+                lineStream >> normal.x >> normal.y >> normal.z;
+                builder.normals.push_back(normal);
+
+            } else if (token == "f") {
+                // Face: f v1/vt1/vn1 v2/vt2/vn2 v3/vt3/vn3
+                std::vector<std::string> faceTokens;
+                std::string faceToken;
+
+                // Read all face tokens
+                while (lineStream >> faceToken) {
+                    faceTokens.push_back(faceToken);
+                }
+
+                // Process triangles (OBJ files can have quads or n-gons)
+                for (size_t i = 1; i + 1 < faceTokens.size(); ++i) {
+                    std::string triangleVerts[3] = { faceTokens[0], faceTokens[i], faceTokens[i + 1] };
+
+                    // Process each vertex of the triangle
+                    for (int k = 0; k < 3; ++k) {
+                        std::string& faceVert = triangleVerts[k];
+
+                        // Parse vertex format: v/vt/vn, v//vn, v/vt, or v
+                        int posIndex = 0, texIndex = -1, normIndex = -1;
+
+                        size_t firstSlash = faceVert.find('/');
+                        if (firstSlash == std::string::npos) {
+                            // Just vertex: "1"
+                            posIndex = parseIndex(faceVert, builder.positions.size());
                         } else {
-                            vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);  // Default up
+                            // Has slashes: parse format
+                            size_t secondSlash = faceVert.find('/', firstSlash + 1);
+                            posIndex = parseIndex(faceVert.substr(0, firstSlash), builder.positions.size());
+
+                            if (secondSlash == std::string::npos) {
+                                // v/vt format: "1/1"
+                                std::string texStr = faceVert.substr(firstSlash + 1);
+                                if (!texStr.empty()) texIndex = parseIndex(texStr, builder.texCoords.size());
+                            } else {
+                                // v//vn or v/vt/vn format
+                                std::string mid = faceVert.substr(firstSlash + 1, secondSlash - firstSlash - 1);
+                                if (!mid.empty()) texIndex = parseIndex(mid, builder.texCoords.size());
+
+                                std::string normStr = faceVert.substr(secondSlash + 1);
+                                if (!normStr.empty()) normIndex = parseIndex(normStr, builder.normals.size());
+                            }
                         }
-                        
-                        // Set color (OBJ files don't have colors, so use default)
-                        vertex.color = glm::vec3(1.0f, 1.0f, 1.0f);  // White
-                        
-                        // Add vertex and track index
-                        GLuint newIndex = (GLuint)vertices.size();
-                        vertices.push_back(vertex);
-                        indices.push_back(newIndex);
-                        vertexMap.emplace(key, newIndex);
+
+                        builder.addCorner(OBJKey{posIndex, texIndex, normIndex});
                     }
                 }
             }
         }
+
+        return builder.finish();
+    }
+
+    // Same whitespace set that operator>> skips
+    inline bool isSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    inline const char* skipSpaces(const char* p, const char* end) {
+        while (p < end && isSpace(*p)) ++p;
+        return p;
+    }
+
+    inline const char* skipToken(const char* p, const char* end) {
+        while (p < end && !isSpace(*p)) ++p;
+        return p;
+    }
+
+    // Call fn(lineBegin, lineEnd) for every line in [p, end), without the trailing newline
+    template<typename Fn>
+    void forEachLine(const char* p, const char* end, Fn&& fn) {
+        while (p < end) {
+            const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+            if (!lineEnd) lineEnd = end;
+
+            fn(p, lineEnd);
+            p = (lineEnd < end) ? lineEnd + 1 : end;
+        }
+    }
+
+    enum class OBJRecord {
+        Other,
+        Position,
+        TexCoord,
+        Normal,
+        Face
+    };
+
+    // Identify a line by its leading token, leaving p just past the token
+    OBJRecord readRecordType(const char*& p, const char* end) {
+        if (p == end || *p == '#') return OBJRecord::Other;  // Skip empty lines and comments
+
+        const char* tokenStart = skipSpaces(p, end);
+        const char* tokenEnd = skipToken(tokenStart, end);
+        size_t tokenLength = tokenEnd - tokenStart;
+        p = tokenEnd;
+
+        if (tokenLength == 1 && tokenStart[0] == 'v') return OBJRecord::Position;
+        if (tokenLength == 1 && tokenStart[0] == 'f') return OBJRecord::Face;
+        if (tokenLength == 2 && tokenStart[0] == 'v') {
+            if (tokenStart[1] == 't') return OBJRecord::TexCoord;
+            if (tokenStart[1] == 'n') return OBJRecord::Normal;
+        }
+        return OBJRecord::Other;
+    }
+
+    // Parse the next whitespace-separated float in place, advancing p
+    inline bool parseFloat(const char*& p, const char* end, float& value) {
+        p = skipSpaces(p, end);
+        if (p < end && *p == '+') ++p;  // from_chars doesn't accept an explicit plus sign
+
+        auto [next, ec] = std::from_chars(p, end, value);
+        if (ec != std::errc()) {
+            value = 0.0f;
+            return false;
+        }
+        p = next;
+        return true;
+    }
+
+    // Parse "x y z" after a v/vn token
+    inline glm::vec3 parseVec3(const char* p, const char* end) {
+        glm::vec3 value(0.0f);
+        parseFloat(p, end, value.x);
+        parseFloat(p, end, value.y);
+        parseFloat(p, end, value.z);
+        return value;
     }
-    
-    // If no normals were loaded from the file, calculate them from geometry
-    if (normals.empty()) {
-        calculateNormalsFromGeometry(vertices, indices);
+
+    // Parse "u v" after a vt token
+    inline glm::vec2 parseVec2(const char* p, const char* end) {
+        glm::vec2 value(0.0f);
+        parseFloat(p, end, value.x);
+        parseFloat(p, end, value.y);
+        return value;
+    }
+
+    // Parse one face index field into a 0-based index
+    inline int parseIndexField(const char* p, const char* end, size_t count) {
+        if (p < end && *p == '+') ++p;
+
+        int value = 0;
+        auto [next, ec] = std::from_chars(p, end, value);
+        if (ec != std::errc()) {
+            throw std::runtime_error("Malformed face index in OBJ file");
+        }
+        return resolveOBJIndex(value, count);
     }
-    
-    return {vertices, indices};
-} 
\ No newline at end of file
+
+    // Parse a face corner token: v/vt/vn, v//vn, v/vt, or v
+    OBJKey parseFaceCorner(const char* p, const char* end, const OBJCounts& counts) {
+        OBJKey key{0, -1, -1};
+
+        const char* firstSlash = static_cast<const char*>(std::memchr(p, '/', end - p));
+        if (!firstSlash) {
+            key.positionIndex = parseIndexField(p, end, counts.positions);
+            return key;
+        }
+        key.positionIndex = parseIndexField(p, firstSlash, counts.positions);
+
+        const char* texStart = firstSlash + 1;
+        const char* secondSlash = static_cast<const char*>(std::memchr(texStart, '/', end - texStart));
+        const char* texEnd = secondSlash ? secondSlash : end;
+        if (texStart < texEnd) key.texCoordIndex = parseIndexField(texStart, texEnd, counts.texCoords);
+
+        if (secondSlash && secondSlash + 1 < end) {
+            key.normalIndex = parseIndexField(secondSlash + 1, end, counts.normals);
+        }
+        return key;
+    }
+
+    // Parse the corners after an f token, fan-triangulating as we go:
+    // (first, previous, current) is emitted for every corner after the second
+    template<typename Emit>
+    void parseFace(const char* p, const char* end, const OBJCounts& counts, Emit&& emit) {
+        OBJKey first{}, previous{};
+        int cornerCount = 0;
+
+        while (true) {
+            const char* cornerStart = skipSpaces(p, end);
+            if (cornerStart == end) break;
+            const char* cornerEnd = skipToken(cornerStart, end);
+            p = cornerEnd;
+
+            OBJKey corner = parseFaceCorner(cornerStart, cornerEnd, counts);
+            if (cornerCount >= 2) {
+                emit(first);
+                emit(previous);
+                emit(corner);
+            }
+            if (cornerCount == 0) first = corner;
+            previous = corner;
+            ++cornerCount;
+        }
+    }
+
+    OBJMeshData loadOBJMapped(const std::string& filepath) {
+        MappedFile file(filepath);
+        if (!file.isOpen()) {
+            throw std::runtime_error("Failed to open OBJ file: " + filepath);
+        }
+
+        // Roughly one unique vertex per 96 bytes of a typical v/vn/f file; the table grows if that's low
+        OBJMeshBuilder builder(file.size() / 96);
+
+        forEachLine(file.begin(), file.end(), [&](const char* p, const char* end) {
+            switch (readRecordType(p, end)) {
+                case OBJRecord::Position:
+                    builder.positions.push_back(parseVec3(p, end));
+                    break;
+                case OBJRecord::TexCoord:
+                    builder.texCoords.push_back(parseVec2(p, end));
+                    break;
+                case OBJRecord::Normal:
+                    builder.normals.push_back(parseVec3(p, end));
+                    break;
+                case OBJRecord::Face:
+                    parseFace(p, end, builder.counts(), [&](const OBJKey& key) { builder.addCorner(key); });
+                    break;
+                default:
+                    break;
+            }
+        });
+
+        return builder.finish();
+    }
+
+    // One line-aligned slice of the file, parsed by a single thread
+    struct OBJChunk {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+
+        // Attributes defined in this chunk and where they start in the merged arrays
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec2> texCoords;
+        std::vector<glm::vec3> normals;
+        OBJCounts base;
+        size_t faceCount = 0;
+
+        // Corners deduplicated within the chunk: distinct keys in first-use order,
+        // and one entry per corner pointing into that list
+        std::vector<OBJKey> uniqueKeys;
+        std::vector<GLuint> localIndices;
+
+        // Where each local key ended up in the merged vertex array
+        std::vector<GLuint> remap;
+        size_t indexOffset = 0;
+    };
+
+    // Split [begin, end) into roughly equal chunks that each start at the beginning of a line
+    std::vector<OBJChunk> splitIntoChunks(const char* begin, const char* end, size_t chunkCount) {
+        std::vector<OBJChunk> chunks;
+        const char* chunkStart = begin;
+        size_t size = end - begin;
+
+        for (size_t i = 1; i <= chunkCount && chunkStart < end; ++i) {
+            const char* chunkEnd = end;
+            if (i < chunkCount) {
+                chunkEnd = begin + size * i / chunkCount;
+                if (chunkEnd < chunkStart) chunkEnd = chunkStart;
+                const char* newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+                chunkEnd = newline ? newline + 1 : end;
+            }
+
+            OBJChunk chunk;
+            chunk.begin = chunkStart;
+            chunk.end = chunkEnd;
+            chunks.push_back(std::move(chunk));
+            chunkStart = chunkEnd;
+        }
+        return chunks;
+    }
+
+    template<typename T>
+    std::vector<T> concatenate(const std::vector<OBJChunk>& chunks, std::vector<T> OBJChunk::*member,
+                               size_t OBJCounts::*baseMember, size_t total) {
+        std::vector<T> merged(total);
+        parallelFor(chunks.size(), [&](size_t c) {
+            const std::vector<T>& part = chunks[c].*member;
+            std::copy(part.begin(), part.end(), merged.begin() + (chunks[c].base.*baseMember));
+        });
+        return merged;
+    }
+
+    OBJMeshData loadOBJParallel(const std::string& filepath, unsigned threadCount) {
+        MappedFile file(filepath);
+        if (!file.isOpen()) {
+            throw std::runtime_error("Failed to open OBJ file: " + filepath);
+        }
+        if (threadCount == 0) threadCount = defaultThreadCount();
+
+        // Small files aren't worth the thread startup cost
+        constexpr size_t minChunkBytes = 256 * 1024;
+        size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadCount, file.size() / minChunkBytes));
+        std::vector<OBJChunk> chunks = splitIntoChunks(file.begin(), file.end(), chunkCount);
+
+        // Pass 1: parse attribute records per chunk
+        parallelFor(chunks.size(), [&](size_t c) {
+            OBJChunk& chunk = chunks[c];
+            forEachLine(chunk.begin, chunk.end, [&](const char* p, const char* end) {
+                switch (readRecordType(p, end)) {
+                    case OBJRecord::Position:
+                        chunk.positions.push_back(parseVec3(p, end));
+                        break;
+                    case OBJRecord::TexCoord:
+                        chunk.texCoords.push_back(parseVec2(p, end));
+                        break;
+                    case OBJRecord::Normal:
+                        chunk.normals.push_back(parseVec3(p, end));
+                        break;
+                    case OBJRecord::Face:
+                        ++chunk.faceCount;
+                        break;
+                    default:
+                        break;
+                }
+            });
+        }, threadCount);
+
+        // Each chunk's attributes start after everything defined in the chunks before it
+        OBJCounts totals;
+        for (auto& chunk : chunks) {
+            chunk.base = totals;
+            totals.positions += chunk.positions.size();
+            totals.texCoords += chunk.texCoords.size();
+            totals.normals += chunk.normals.size();
+        }
+
+        // Pass 2: parse faces with absolute indices and deduplicate within each chunk
+        parallelFor(chunks.size(), [&](size_t c) {
+            OBJChunk& chunk = chunks[c];
+            // Size the table from the face count: a closed triangle mesh has about half as many vertices as faces
+            OBJVertexMap localMap(chunk.faceCount);
+            chunk.uniqueKeys.reserve(chunk.faceCount);
+            chunk.localIndices.reserve(chunk.faceCount * 3);
+            OBJCounts counts = chunk.base;
+
+            forEachLine(chunk.begin, chunk.end, [&](const char* p, const char* end) {
+                switch (readRecordType(p, end)) {
+                    case OBJRecord::Position:
+                        ++counts.positions;
+                        break;
+                    case OBJRecord::TexCoord:
+                        ++counts.texCoords;
+                        break;
+                    case OBJRecord::Normal:
+                        ++counts.normals;
+                        break;
+                    case OBJRecord::Face:
+                        parseFace(p, end, counts, [&](const OBJKey& key) {
+                            auto [local, inserted] = localMap.tryEmplace(key, (GLuint)chunk.uniqueKeys.size());
+                            if (inserted) chunk.uniqueKeys.push_back(key);
+                            chunk.localIndices.push_back(*local);
+                        });
+                        break;
+                    default:
+                        break;
+                }
+            });
+        }, threadCount);
+
+        // Merge: visiting chunks in file order, and each chunk's keys in first-use order, assigns
+        // vertex ids in exactly the order a single pass over the file would, for any chunk count
+        std::vector<OBJKey> vertexKeys;
+        size_t localKeyCount = 0;
+        for (const auto& chunk : chunks) localKeyCount += chunk.uniqueKeys.size();
+        OBJVertexMap vertexMap(localKeyCount);
+        vertexKeys.reserve(localKeyCount);
+
+        size_t indexCount = 0;
+        for (auto& chunk : chunks) {
+            chunk.remap.resize(chunk.uniqueKeys.size());
+            for (size_t k = 0; k < chunk.uniqueKeys.size(); ++k) {
+                const OBJKey& key = chunk.uniqueKeys[k];
+                auto [global, inserted] = vertexMap.tryEmplace(key, (GLuint)vertexKeys.size());
+                if (inserted) {
+                    checkPositionIndex(key, totals.positions);
+                    vertexKeys.push_back(key);
+                }
+                chunk.remap[k] = *global;
+            }
+            chunk.indexOffset = indexCount;
+            indexCount += chunk.localIndices.size();
+        }
+
+        std::vector<glm::vec3> positions = concatenate(chunks, &OBJChunk::positions, &OBJCounts::positions, totals.positions);
+        std::vector<glm::vec2> texCoords = concatenate(chunks, &OBJChunk::texCoords, &OBJCounts::texCoords, totals.texCoords);
+        std::vector<glm::vec3> normals = concatenate(chunks, &OBJChunk::normals, &OBJCounts::normals, totals.normals);
+
+        // Build the final vertex and index arrays in parallel
+        std::vector<Vertex> vertices(vertexKeys.size());
+        std::vector<GLuint> indices(indexCount);
+
+        constexpr size_t verticesPerTask = 64 * 1024;
+        size_t vertexTasks = (vertexKeys.size() + verticesPerTask - 1) / verticesPerTask;
+        parallelFor(vertexTasks + chunks.size(), [&](size_t task) {
+            if (task < vertexTasks) {
+                size_t first = task * verticesPerTask;
+                size_t last = std::min(first + verticesPerTask, vertexKeys.size());
+                for (size_t v = first; v < last; ++v) {
+                    vertices[v] = makeVertex(vertexKeys[v], positions, texCoords, normals);
+                }
+            } else {
+                const OBJChunk& chunk = chunks[task - vertexTasks];
+                for (size_t i = 0; i < chunk.localIndices.size(); ++i) {
+                    indices[chunk.indexOffset + i] = chunk.remap[chunk.localIndices[i]];
+                }
+            }
+        }, threadCount);
+
+        // If no normals were loaded from the file, calculate them from geometry
+        if (normals.empty()) {
+            calculateNormalsFromGeometry(vertices, indices);
+        }
+
+        return {std::move(vertices), std::move(indices)};
+    }
+
+    bool sameMeshData(const OBJMeshData& a, const OBJMeshData& b) {
+        return a.first.size() == b.first.size() && a.second.size() == b.second.size() &&
+               std::memcmp(a.first.data(), b.first.data(), a.first.size() * sizeof(Vertex)) == 0 &&
+               std::memcmp(a.second.data(), b.second.data(), a.second.size() * sizeof(GLuint)) == 0;
+    }
+}
+
+std::pair<std::vector<Vertex>, std::vector<GLuint>> loadOBJFile(const std::string& filepath, OBJLoadMode mode) {
+    switch (mode) {
+        case OBJLoadMode::Stream:
+            return loadOBJStream(filepath);
+        case OBJLoadMode::Mapped:
+            return loadOBJMapped(filepath);
+        case OBJLoadMode::Parallel:
+        default:
+            return loadOBJParallel(filepath, 0);
+    }
+}
+
+std::pair<std::vector<Vertex>, std::vector<GLuint>> loadOBJFileParallel(const std::string& filepath,
+                                                                        unsigned threadCount) {
+    return loadOBJParallel(filepath, threadCount);
+}
+
+bool compareOBJLoadModes(const std::string& filepath) {
+    constexpr int runsPerMode = 3;
+    unsigned cores = defaultThreadCount();
+
+    struct ModeInfo {
+        std::string name;
+        std::function<OBJMeshData()> load;
+    };
+    std::vector<ModeInfo> modes = {
+        {"stream", [&]() { return loadOBJFile(filepath, OBJLoadMode::Stream); }},
+        {"mapped", [&]() { return loadOBJFile(filepath, OBJLoadMode::Mapped); }},
+    };
+    // Every thread count must reproduce the serial output bit for bit
+    for (unsigned threads = 1; threads < cores; threads *= 2) {
+        modes.push_back({"parallel x" + std::to_string(threads), [&, threads]() {
+            return loadOBJFileParallel(filepath, threads);
+        }});
+    }
+    modes.push_back({"parallel x" + std::to_string(cores), [&]() { return loadOBJFileParallel(filepath, cores); }});
+
+    OBJMeshData reference;
+    bool allMatch = true;
+
+    std::cout << "OBJ load comparison: " << filepath << std::endl;
+    for (size_t m = 0; m < modes.size(); ++m) {
+        // Take the best of a few runs so the page cache is warm for every mode
+        double bestMs = 0.0;
+        OBJMeshData result;
+        for (int run = 0; run < runsPerMode; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            result = modes[m].load();
+            auto end = std::chrono::steady_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(end - start).count();
+            if (run == 0 || ms < bestMs) bestMs = ms;
+        }
+
+        std::cout << "  " << modes[m].name << ": " << bestMs << " ms, " << result.first.size() << " vertices, "
+                  << result.second.size() / 3 << " triangles";
+        if (m == 0) {
+            reference = std::move(result);
+        } else {
+            bool matches = sameMeshData(reference, result);
+            allMatch = allMatch && matches;
+            std::cout << (matches ? " (identical)" : " (MISMATCH)");
+        }
+        std::cout << std::endl;
+    }
+
+    return allMatch;
+}
+
+namespace {
+    // The hash the loader used before FlatHashMap, kept as the benchmark baseline
+    struct LegacyOBJKeyHash {
+        size_t operator()(const OBJKey& key) const noexcept {
+            return ((size_t)key.positionIndex * 73856093u) ^ 
+                   ((size_t)key.texCoordIndex * 19349663u) ^ 
+                   ((size_t)key.normalIndex * 83492791u);
+        }
+    };
+
+    // Corners of an n x n grid mesh in row order: each interior vertex is shared by six corners
+    std::vector<OBJKey> makeGridCorners(int n) {
+        std::vector<OBJKey> corners;
+        corners.reserve((size_t)(n - 1) * (n - 1) * 6);
+        for (int row = 0; row + 1 < n; ++row) {
+            for (int col = 0; col + 1 < n; ++col) {
+                int a = row * n + col, b = a + 1, c = a + n + 1, d = a + n;
+                for (int index : {a, b, c, a, c, d}) {
+                    corners.push_back(OBJKey{index, index, index});
+                }
+            }
+        }
+        return corners;
+    }
+
+    std::vector<OBJKey> readFaceCorners(const std::string& filepath) {
+        MappedFile file(filepath);
+        if (!file.isOpen()) {
+            throw std::runtime_error("Failed to open OBJ file: " + filepath);
+        }
+
+        std::vector<OBJKey> corners;
+        OBJCounts counts;
+        forEachLine(file.begin(), file.end(), [&](const char* p, const char* end) {
+            switch (readRecordType(p, end)) {
+                case OBJRecord::Position: ++counts.positions; break;
+                case OBJRecord::TexCoord: ++counts.texCoords; break;
+                case OBJRecord::Normal: ++counts.normals; break;
+                case OBJRecord::Face:
+                    parseFace(p, end, counts, [&](const OBJKey& key) { corners.push_back(key); });
+                    break;
+                default: break;
+            }
+        });
+        return corners;
+    }
+
+    // Run the loader's dedup loop with the given insert function; returns the best time in ms
+    template<typename MakeMap, typename Insert>
+    double timeDedup(const std::vector<OBJKey>& corners, MakeMap&& makeMap, Insert&& insert, size_t& uniqueCount) {
+        constexpr int runs = 3;
+        double bestMs = 0.0;
+        for (int run = 0; run < runs; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            auto map = makeMap();
+            GLuint nextIndex = 0;
+            for (const OBJKey& key : corners) {
+                if (insert(map, key, nextIndex)) ++nextIndex;
+            }
+            auto end = std::chrono::steady_clock::now();
+
+            double ms = std::chrono::duration<double, std::milli>(end - start).count();
+            if (run == 0 || ms < bestMs) bestMs = ms;
+            uniqueCount = nextIndex;
+        }
+        return bestMs;
+    }
+}
+
+void benchmarkOBJDedup(const std::string& filepath) {
+    std::vector<std::pair<std::string, std::vector<OBJKey>>> workloads;
+    workloads.emplace_back("synthetic grid 512x512", makeGridCorners(512));
+    workloads.emplace_back("synthetic grid 2048x2048", makeGridCorners(2048));
+    if (!filepath.empty()) {
+        workloads.emplace_back(filepath, readFaceCorners(filepath));
+    }
+
+    using LegacyMap = std::unordered_map<OBJKey, GLuint, LegacyOBJKeyHash>;
+    using StdMap = std::unordered_map<OBJKey, GLuint, OBJKeyHash>;
+
+    std::cout << "OBJ vertex dedup benchmark" << std::endl;
+    for (const auto& [name, corners] : workloads) {
+        // Sized the way the loader sizes it: about one vertex per two faces, from the face count
+        size_t expected = corners.size() / 6;
+        size_t legacyUnique = 0, stdUnique = 0, flatUnique = 0;
+
+        double legacyMs = timeDedup(corners, [] {
+            LegacyMap map;
+            map.reserve(1024);  // What loadOBJFile originally reserved
+            return map;
+        }, [](LegacyMap& map, const OBJKey& key, GLuint next) {
+            return map.try_emplace(key, next).second;
+        }, legacyUnique);
+
+        double stdMs = timeDedup(corners, [&] {
+            StdMap map;
+            map.reserve(expected);
+            return map;
+        }, [](StdMap& map, const OBJKey& key, GLuint next) {
+            return map.try_emplace(key, next).second;
+        }, stdUnique);
+
+        double flatMs = timeDedup(corners, [&] {
+            return OBJVertexMap(expected);
+        }, [](OBJVertexMap& map, const OBJKey& key, GLuint next) {
+            return map.tryEmplace(key, next).second;
+        }, flatUnique);
+
+        double cornersM = corners.size() / 1.0e6;
+        std::cout << "  " << name << ": " << corners.size() << " corners, " << flatUnique << " vertices" << std::endl;
+        std::cout << "    unordered_map (legacy hash, reserve 1024): " << legacyMs << " ms ("
+                  << cornersM / (legacyMs / 1000.0) << " M corners/s)" << std::endl;
+        std::cout << "    unordered_map (OBJKeyHash, sized):         " << stdMs << " ms ("
+                  << cornersM / (stdMs / 1000.0) << " M corners/s)" << std::endl;
+        std::cout << "    FlatHashMap (OBJKeyHash, sized):           " << flatMs << " ms ("
+                  << cornersM / (flatMs / 1000.0) << " M corners/s)" << std::endl;
+        if (legacyUnique != flatUnique || stdUnique != flatUnique) {
+            std::cout << "    MISMATCH in unique vertex count" << std::endl;
+        }
+    }
+}
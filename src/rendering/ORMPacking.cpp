@@ -0,0 +1,97 @@
+#include "rendering/ORMPacking.h"
+#include "utils/Hash.h"
+#include <stb_image.h>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+
+std::string ormCachePath(const ORMSources& sources) {
+    std::filesystem::path ao(sources.ao);
+    std::string stems[3] = {ao.stem().string(), std::filesystem::path(sources.roughness).stem().string(),
+                            std::filesystem::path(sources.metallic).stem().string()};
+
+    // Longest common prefix of the file names, without the separator before the differing suffixes
+    size_t length = stems[0].size();
+    for (int i = 1; i < 3; ++i) {
+        size_t shared = 0;
+        while (shared < length && shared < stems[i].size() && stems[i][shared] == stems[0][shared]) ++shared;
+        length = shared;
+    }
+    std::string name = stems[0].substr(0, length);
+    while (!name.empty() && (name.back() == '_' || name.back() == '-' || name.back() == '.')) name.pop_back();
+
+    if (name.empty()) {
+        // Unrelated names: identify the combination instead
+        uint64_t hash = hashCombine(hashCombine(hashString(sources.ao), hashString(sources.roughness)),
+                                    hashString(sources.metallic));
+        char hex[17];
+        std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+        name = std::string("material_") + hex;
+    }
+    return (ao.parent_path() / (name + "_orm.ktx2")).string();
+}
+
+bool isORMCacheFresh(const std::string& cachePath, const ORMSources& sources) {
+    std::error_code error;
+    auto cacheTime = std::filesystem::last_write_time(cachePath, error);
+    if (error) {
+        return false;
+    }
+    for (const std::string* source : {&sources.ao, &sources.roughness, &sources.metallic}) {
+        auto sourceTime = std::filesystem::last_write_time(*source, error);
+        if (!error && sourceTime > cacheTime) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool canPackORM(const ORMSources& sources) {
+    if (isORMCacheFresh(ormCachePath(sources), sources)) {
+        return true;
+    }
+
+    int width = 0, height = 0;
+    for (const std::string* source : {&sources.ao, &sources.roughness, &sources.metallic}) {
+        int w, h, channels;
+        if (!stbi_info(source->c_str(), &w, &h, &channels)) {
+            return false;
+        }
+        if (width != 0 && (w != width || h != height)) {
+            return false;
+        }
+        width = w;
+        height = h;
+    }
+    return true;
+}
+
+std::vector<unsigned char> packORM(const ORMSources& sources, int& width, int& height) {
+    stbi_set_flip_vertically_on_load_thread(true);
+
+    std::vector<unsigned char> packed;
+    const std::string* paths[3] = {&sources.ao, &sources.roughness, &sources.metallic};
+    for (int channel = 0; channel < 3; ++channel) {
+        int w, h, channels;
+        std::unique_ptr<unsigned char, void (*)(void*)> pixels(stbi_load(paths[channel]->c_str(), &w, &h, &channels, 0),
+                                                                stbi_image_free);
+        if (!pixels) {
+            throw std::runtime_error("Failed to load texture: " + *paths[channel] + " (" + stbi_failure_reason() + ")");
+        }
+        if (channel == 0) {
+            width = w;
+            height = h;
+            packed.resize((size_t)width * height * 3);
+        } else if (w != width || h != height) {
+            throw std::runtime_error("Can't pack maps of different sizes: " + *paths[channel]);
+        }
+
+        // The first channel carries the value (grey maps may still be stored as RGB)
+        size_t texels = (size_t)width * height;
+        for (size_t i = 0; i < texels; ++i) {
+            packed[i * 3 + channel] = pixels.get()[i * channels];
+        }
+    }
+    return packed;
+}
@@ -1,6 +1,26 @@
 #include "rendering/PBRMaterial.h"
+#include "rendering/AssetRegistry.h"
+#include "rendering/ShaderPermutations.h"
+#include "rendering/TextureLoader.h"
 #include <iostream>
 
+namespace {
+    // Whether every map of a material would stream (see Texture's loader constructors): each has a baked .ktx2,
+    // and the metallic, roughness and AO maps a packed cache when they can be packed. The cache is only written
+    // by the first load, so what counts is that it will be (the driver samples BC7), not that it exists yet:
+    // otherwise a material would be pooled on the first run and streamed on the next
+    bool streamsEveryMap(const std::string& albedoPath, const std::string& normalPath, const ORMSources& orm,
+                         const TextureLoader& loader) {
+        if (!loader.isStreaming()) {
+            return false;
+        }
+        auto baked = [](const std::string& path) { return !Texture::findBakedTexture(path).empty(); };
+        bool ormStreams = canPackORM(orm) ? Texture::isCompressedFormatSupported(BlockFormat::BC7)
+                                          : baked(orm.ao) && baked(orm.roughness) && baked(orm.metallic);
+        return baked(albedoPath) && baked(normalPath) && ormStreams;
+    }
+}
+
 PBRMaterial::PBRMaterial() 
     : hasAlbedo(false), hasNormal(false), hasMetallic(false), hasRoughness(false), hasAO(false) {
     // Initialize all texture pointers to nullptr
@@ -23,14 +43,50 @@ PBRMaterial::PBRMaterial(const std::string& albedoPath,
     setAO(aoPath);
 }
 
+PBRMaterial::PBRMaterial(const std::string& albedoPath, 
+                         const std::string& normalPath,
+                         const std::string& metallicPath,
+                         const std::string& roughnessPath,
+                         const std::string& aoPath,
+                         TextureLoader& loader,
+                         AssetRegistry* registry,
+                         MaterialPool* pool) {
+    ORMSources orm{aoPath, roughnessPath, metallicPath};
+    // Pool arrays keep every level resident, so only materials that would stream all their maps keep
+    // textures of their own; the rest share the pool's binds
+    if (pool && !streamsEveryMap(albedoPath, normalPath, orm, loader)) {
+        poolSlot = pool->add(albedoPath, normalPath, orm, loader);
+        if (poolSlot.isValid()) {
+            this->pool = pool;
+            hasAlbedo = hasNormal = hasMetallic = hasRoughness = hasAO = false;
+            return;
+        }
+    }
+
+    setAlbedo(albedoPath, &loader, registry);
+    setNormal(normalPath, &loader, registry);
+
+    // Packed: one bind and one fetch instead of three
+    if (canPackORM(orm)) {
+        setORM(orm, loader, registry);
+    } else {
+        std::cout << "Material maps can't be packed, keeping them separate: " << aoPath << std::endl;
+        setMetallic(metallicPath, &loader, registry);
+        setRoughness(roughnessPath, &loader, registry);
+        setAO(aoPath, &loader, registry);
+    }
+}
+
 PBRMaterial::PBRMaterial(PBRMaterial&& other) noexcept
     : hasAlbedo(other.hasAlbedo), hasNormal(other.hasNormal), 
-      hasMetallic(other.hasMetallic), hasRoughness(other.hasRoughness), hasAO(other.hasAO) {
+      hasMetallic(other.hasMetallic), hasRoughness(other.hasRoughness), hasAO(other.hasAO), hasORM(other.hasORM),
+      pool(other.pool), poolSlot(other.poolSlot) {
     albedoTexture = std::move(other.albedoTexture);
     normalTexture = std::move(other.normalTexture);
     metallicTexture = std::move(other.metallicTexture);
     roughnessTexture = std::move(other.roughnessTexture);
     aoTexture = std::move(other.aoTexture);
+    ormTexture = std::move(other.ormTexture);
     
     // Reset other's flags
     other.hasAlbedo = false;
@@ -38,6 +94,9 @@ PBRMaterial::PBRMaterial(PBRMaterial&& other) noexcept
     other.hasMetallic = false;
     other.hasRoughness = false;
     other.hasAO = false;
+    other.hasORM = false;
+    other.pool = nullptr;
+    other.poolSlot = {};
 }
 
 PBRMaterial& PBRMaterial::operator=(PBRMaterial&& other) noexcept {
@@ -51,12 +110,16 @@ PBRMaterial& PBRMaterial::operator=(PBRMaterial&& other) noexcept {
         hasMetallic = other.hasMetallic;
         hasRoughness = other.hasRoughness;
         hasAO = other.hasAO;
+        hasORM = other.hasORM;
+        pool = other.pool;
+        poolSlot = other.poolSlot;
         
         albedoTexture = std::move(other.albedoTexture);
         normalTexture = std::move(other.normalTexture);
         metallicTexture = std::move(other.metallicTexture);
         roughnessTexture = std::move(other.roughnessTexture);
         aoTexture = std::move(other.aoTexture);
+        ormTexture = std::move(other.ormTexture);
         
         // Reset other's flags
         other.hasAlbedo = false;
@@ -64,6 +127,9 @@ PBRMaterial& PBRMaterial::operator=(PBRMaterial&& other) noexcept {
         other.hasMetallic = false;
         other.hasRoughness = false;
         other.hasAO = false;
+        other.hasORM = false;
+        other.pool = nullptr;
+        other.poolSlot = {};
     }
     return *this;
 }
@@ -84,6 +150,9 @@ void PBRMaterial::bindTextures() {
     if (hasAO && aoTexture) {
         aoTexture->bind(GL_TEXTURE4);
     }
+    if (hasORM && ormTexture) {
+        ormTexture->bind(GL_TEXTURE2);
+    }
 }
 
 void PBRMaterial::unbindTextures() {
@@ -102,11 +171,14 @@ void PBRMaterial::unbindTextures() {
     if (hasAO && aoTexture) {
         aoTexture->unbind();
     }
+    if (hasORM && ormTexture) {
+        ormTexture->unbind();
+    }
 }
 
-void PBRMaterial::setAlbedo(const std::string& path) {
+void PBRMaterial::setAlbedo(const std::string& path, TextureLoader* loader, AssetRegistry* registry) {
     try {
-        albedoTexture = std::make_unique<Texture>(path.c_str(), TextureType::ALBEDO);
+        albedoTexture = loadTexture(path, TextureType::ALBEDO, loader, registry);
         hasAlbedo = true;
     } catch (...) {
         std::cerr << "Failed to load albedo texture: " << path << std::endl;
@@ -114,9 +186,9 @@ void PBRMaterial::setAlbedo(const std::string& path) {
     }
 }
 
-void PBRMaterial::setNormal(const std::string& path) {
+void PBRMaterial::setNormal(const std::string& path, TextureLoader* loader, AssetRegistry* registry) {
     try {
-        normalTexture = std::make_unique<Texture>(path.c_str(), TextureType::NORMAL);
+        normalTexture = loadTexture(path, TextureType::NORMAL, loader, registry);
         hasNormal = true;
     } catch (...) {
         std::cerr << "Failed to load normal texture: " << path << std::endl;
@@ -124,9 +196,9 @@ void PBRMaterial::setNormal(const std::string& path) {
     }
 }
 
-void PBRMaterial::setMetallic(const std::string& path) {
+void PBRMaterial::setMetallic(const std::string& path, TextureLoader* loader, AssetRegistry* registry) {
     try {
-        metallicTexture = std::make_unique<Texture>(path.c_str(), TextureType::METALLIC);
+        metallicTexture = loadTexture(path, TextureType::METALLIC, loader, registry);
         hasMetallic = true;
     } catch (...) {
         std::cerr << "Failed to load metallic texture: " << path << std::endl;
@@ -134,9 +206,9 @@ void PBRMaterial::setMetallic(const std::string& path) {
     }
 }
 
-void PBRMaterial::setRoughness(const std::string& path) {
+void PBRMaterial::setRoughness(const std::string& path, TextureLoader* loader, AssetRegistry* registry) {
     try {
-        roughnessTexture = std::make_unique<Texture>(path.c_str(), TextureType::ROUGHNESS);
+        roughnessTexture = loadTexture(path, TextureType::ROUGHNESS, loader, registry);
         hasRoughness = true;
     } catch (...) {
         std::cerr << "Failed to load roughness texture: " << path << std::endl;
@@ -144,9 +216,9 @@ void PBRMaterial::setRoughness(const std::string& path) {
     }
 }
 
-void PBRMaterial::setAO(const std::string& path) {
+void PBRMaterial::setAO(const std::string& path, TextureLoader* loader, AssetRegistry* registry) {
     try {
-        aoTexture = std::make_unique<Texture>(path.c_str(), TextureType::AO);
+        aoTexture = loadTexture(path, TextureType::AO, loader, registry);
         hasAO = true;
     } catch (...) {
         std::cerr << "Failed to load AO texture: " << path << std::endl;
@@ -154,21 +226,83 @@ void PBRMaterial::setAO(const std::string& path) {
     }
 }
 
+void PBRMaterial::setORM(const ORMSources& sources, TextureLoader& loader, AssetRegistry* registry) {
+    ormTexture = registry ? registry->getORMTexture(sources, loader)
+                          : std::shared_ptr<Texture>(new Texture(sources, loader), TextureDeleter());
+    hasORM = true;
+
+    metallicTexture.reset();
+    roughnessTexture.reset();
+    aoTexture.reset();
+    hasMetallic = false;
+    hasRoughness = false;
+    hasAO = false;
+}
+
+std::shared_ptr<Texture> PBRMaterial::loadTexture(const std::string& path, TextureType type, TextureLoader* loader,
+                                                  AssetRegistry* registry) {
+    if (registry) {
+        return registry->getTexture(path, type, loader);
+    }
+    return std::shared_ptr<Texture>(loader ? new Texture(path.c_str(), type, *loader) : new Texture(path.c_str(), type),
+                                    TextureDeleter());
+}
+
+uint32_t PBRMaterial::getShaderFeatures() const {
+    // Pool layers always hold a normal map (a flat one until it loads)
+    if (usesMaterialPool()) {
+        return ShaderFeatureMaterialArray | ShaderFeatureNormalMap;
+    }
+    uint32_t features = 0;
+    if (hasNormal) features |= ShaderFeatureNormalMap;
+    if (hasORM) features |= ShaderFeaturePackedORM;
+    return features;
+}
+
 bool PBRMaterial::isValid() const {
-    return hasAlbedo && hasNormal && hasMetallic && hasRoughness && hasAO;
+    return poolSlot.isValid() || (hasAlbedo && hasNormal && (hasORM || (hasMetallic && hasRoughness && hasAO)));
+}
+
+bool PBRMaterial::isReady() const {
+    if (pool && !pool->isReady(poolSlot)) {
+        return false;
+    }
+    for (const auto* texture : {albedoTexture.get(), normalTexture.get(), metallicTexture.get(),
+                                roughnessTexture.get(), aoTexture.get(), ormTexture.get()}) {
+        if (texture && !texture->isReady()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PBRMaterial::requestResolution(float pixels) const {
+    for (const auto* texture : {albedoTexture.get(), normalTexture.get(), metallicTexture.get(),
+                                roughnessTexture.get(), aoTexture.get(), ormTexture.get()}) {
+        if (texture) {
+            texture->requestResolution(pixels);
+        }
+    }
 }
 
 void PBRMaterial::destroy() {
-    // unique_ptr will automatically clean up the textures
+    // Textures are released along with their last handle
     albedoTexture.reset();
     normalTexture.reset();
     metallicTexture.reset();
     roughnessTexture.reset();
     aoTexture.reset();
+    ormTexture.reset();
+    if (pool) {
+        pool->release(poolSlot);
+        pool = nullptr;
+    }
+    poolSlot = {};
     
     hasAlbedo = false;
     hasNormal = false;
     hasMetallic = false;
     hasRoughness = false;
     hasAO = false;
+    hasORM = false;
 } 
\ No newline at end of file
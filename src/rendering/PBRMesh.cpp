@@ -1,7 +1,17 @@
 #include "rendering/PBRMesh.h"
 
-PBRMesh::PBRMesh(const std::vector<Vertex>& vertices, 
-                   const std::vector<GLuint>& indices, 
+namespace {
+    const Uniform<int> materialLayerUniform("materialLayer");
+    const Uniform<int> albedoMapUniform("albedoMap");
+    const Uniform<int> normalMapUniform("normalMap");
+    const Uniform<int> ormMapUniform("ormMap");
+    const Uniform<int> metallicMapUniform("metallicMap");
+    const Uniform<int> roughnessMapUniform("roughnessMap");
+    const Uniform<int> aoMapUniform("aoMap");
+}
+
+PBRMesh::PBRMesh(std::span<const Vertex> vertices, 
+                   std::span<const GLuint> indices, 
                    PBRMaterial&& material)
     : Mesh(vertices, indices), pbrMaterial(std::move(material)) {
     setupPBRVertexAttributes();
@@ -11,24 +21,48 @@ PBRMesh::~PBRMesh() {
     destroy();
 }
 
-void PBRMesh::drawPBR(Shader& pbrShader) {
-    // Bind PBR material textures
-    pbrMaterial.bindTextures();
-    
-    // Set texture uniforms
-    pbrShader.setInt("albedoMap", 0);
-    pbrShader.setInt("normalMap", 1);
-    pbrShader.setInt("metallicMap", 2);
-    pbrShader.setInt("roughnessMap", 3);
-    pbrShader.setInt("aoMap", 4);
+void PBRMesh::drawPBR(Shader& pbrShader, int lod) {
+    bindMaterial(pbrShader);
     
     // Draw the mesh
-    draw(pbrShader);
+    draw(pbrShader, lod);
     
     // Unbind textures
     pbrMaterial.unbindTextures();
 }
 
+void PBRMesh::drawPBR(Shader& pbrShader, const MeshletDrawList& ranges) {
+    bindMaterial(pbrShader);
+    
+    // Draw the visible ranges
+    drawRanges(pbrShader, ranges);
+    
+    // Unbind textures
+    pbrMaterial.unbindTextures();
+}
+
+void PBRMesh::bindMaterial(Shader& pbrShader) {
+    // Pooled maps are already bound as arrays for the whole pass; only the layer changes
+    if (pbrMaterial.usesMaterialPool()) {
+        pbrShader.set(materialLayerUniform, pbrMaterial.getPoolSlot().layer);
+        return;
+    }
+    
+    // Bind PBR material textures
+    pbrMaterial.bindTextures();
+    
+    // Set texture uniforms (uploaded only when a program doesn't have them yet)
+    pbrShader.set(albedoMapUniform, 0);
+    pbrShader.set(normalMapUniform, 1);
+    if (pbrMaterial.usesPackedORM()) {
+        pbrShader.set(ormMapUniform, 2);
+    } else {
+        pbrShader.set(metallicMapUniform, 2);
+        pbrShader.set(roughnessMapUniform, 3);
+        pbrShader.set(aoMapUniform, 4);
+    }
+}
+
 void PBRMesh::setMaterial(PBRMaterial&& material) {
     pbrMaterial = std::move(material);
 }
@@ -0,0 +1,152 @@
+#include "rendering/ProgramCache.h"
+#include "utils/Hash.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace {
+    constexpr char programCacheMagic[8] = {'G', 'L', 'O', 'W', 'P', 'R', 'O', 'G'};
+    constexpr uint32_t programCacheVersion = 1;
+    constexpr const char* programCacheDirectory = "ShaderCache";
+
+    struct ProgramCacheHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t binaryFormat;
+        uint64_t key;
+        uint64_t binarySize;
+        double buildMs;
+    };
+
+    ProgramCacheStats stats;
+
+    std::string cachePathFor(uint64_t key) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+        return (std::filesystem::path(programCacheDirectory) / name).string();
+    }
+
+    // Drivers may support no binary formats at all, in which case nothing is cached
+    bool driverSupportsBinaries() {
+        static GLint formats = -1;
+        if (formats < 0) {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        }
+        return formats > 0;
+    }
+
+    uint64_t driverKey() {
+        static uint64_t key = 0;
+        if (key == 0) {
+            for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION}) {
+                const char* text = reinterpret_cast<const char*>(glGetString(name));
+                key = hashCombine(key, hashString(text ? text : ""));
+            }
+        }
+        return key;
+    }
+}
+
+uint64_t programCacheKey(const std::string& vertexSource, const std::string& fragmentSource) {
+    uint64_t key = hashCombine(driverKey(), hashString(vertexSource));
+    return hashCombine(key, hashString(fragmentSource));
+}
+
+bool loadCachedProgram(GLuint program, uint64_t key) {
+    if (!driverSupportsBinaries()) {
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::string path = cachePathFor(key);
+
+    ProgramCacheHeader header{};
+    std::vector<char> binary;
+    std::ifstream file(path, std::ios::binary);
+    if (file && file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+        std::equal(std::begin(programCacheMagic), std::end(programCacheMagic), header.magic) &&
+        header.version == programCacheVersion && header.key == key) {
+        binary.resize(header.binarySize);
+        if (!file.read(binary.data(), (std::streamsize)binary.size())) {
+            binary.clear();
+        }
+    }
+    if (binary.empty()) {
+        ++stats.misses;
+        std::cout << "Shader program cache miss: " << path << std::endl;
+        return false;
+    }
+
+    glProgramBinary(program, header.binaryFormat, binary.data(), (GLsizei)binary.size());
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        // Stale for this driver; it's rebuilt from source and overwritten
+        ++stats.misses;
+        ++stats.rejected;
+        std::cout << "Shader program cache entry rejected by the driver, recompiling: " << path << std::endl;
+        return false;
+    }
+
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    double savedMs = std::max(header.buildMs - loadMs, 0.0);
+    ++stats.hits;
+    stats.savedMs += savedMs;
+    std::cout << "Shader program cache hit: " << path << " (" << loadMs << " ms, saved " << savedMs << " ms)"
+              << std::endl;
+    return true;
+}
+
+void prepareProgramForCache(GLuint program) {
+    if (driverSupportsBinaries()) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+}
+
+void storeCachedProgram(GLuint program, uint64_t key, double buildMs) {
+    if (!driverSupportsBinaries()) {
+        return;
+    }
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    ProgramCacheHeader header{};
+    std::copy(std::begin(programCacheMagic), std::end(programCacheMagic), header.magic);
+    header.version = programCacheVersion;
+    header.binaryFormat = format;
+    header.key = key;
+    header.binarySize = (uint64_t)length;
+    header.buildMs = buildMs;
+
+    // Written under a temporary name and renamed, so an interrupted write never leaves a truncated entry
+    std::error_code error;
+    std::filesystem::create_directories(programCacheDirectory, error);
+    std::string path = cachePathFor(key);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file) {
+            std::cerr << "Failed to write shader program cache: " << tempPath << std::endl;
+            return;
+        }
+    }
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::cerr << "Failed to write shader program cache: " << path << std::endl;
+    }
+}
+
+const ProgramCacheStats& getProgramCacheStats() {
+    return stats;
+}
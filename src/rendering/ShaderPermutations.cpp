@@ -0,0 +1,55 @@
+#include "rendering/ShaderPermutations.h"
+#include "rendering/AssetRegistry.h"
+#include <algorithm>
+#include <iostream>
+
+std::vector<std::string> ShaderVariantKey::defines() const {
+    std::vector<std::string> result;
+    if (features & ShaderFeatureNormalMap) result.push_back("NORMAL_MAP");
+    if (features & ShaderFeaturePackedORM) result.push_back("ORM_MAP");
+    if (features & ShaderFeatureMaterialArray) result.push_back("MATERIAL_ARRAY");
+    if (features & ShaderFeatureDirLight) result.push_back("DIR_LIGHT");
+    if (features & ShaderFeatureClustered) result.push_back("CLUSTERED");
+    if (features & ShaderFeatureLightVolumes) result.push_back("LIGHT_VOLUMES");
+    if (features & ShaderFeaturePointVolume) result.push_back("POINT_VOLUME");
+    if (features & ShaderFeatureSpotVolume) result.push_back("SPOT_VOLUME");
+    if (features & ShaderFeatureShadows) result.push_back("SHADOWS");
+    result.push_back("QUALITY " + std::to_string((int)quality));
+    return result;
+}
+
+ShaderPermutations::ShaderPermutations(AssetRegistry& registry, std::string vertexPath, std::string fragmentPath)
+    : registry(registry), vertexPath(std::move(vertexPath)), fragmentPath(std::move(fragmentPath)) {
+}
+
+Shader& ShaderPermutations::get(const ShaderVariantKey& key) {
+    for (auto& [variantKey, shader] : variants) {
+        if (variantKey == key) {
+            return *shader;
+        }
+    }
+
+    std::vector<std::string> defines = key.defines();
+    std::cout << "Compiling shader variant " << fragmentPath << " [";
+    for (size_t i = 0; i < defines.size(); ++i) {
+        std::cout << (i ? ", " : "") << defines[i];
+    }
+    std::cout << "]" << std::endl;
+    variants.emplace_back(key, registry.getShader(vertexPath, fragmentPath, defines));
+    return *variants.back().second;
+}
+
+void ShaderPermutations::prepare(const std::vector<ShaderVariantKey>& keys) {
+    for (const ShaderVariantKey& key : keys) {
+        get(key);
+    }
+}
+
+bool ShaderPermutations::isReady(const ShaderVariantKey& key) {
+    return get(key).isReady();
+}
+
+size_t ShaderPermutations::getPendingCount() const {
+    return std::count_if(variants.begin(), variants.end(),
+                         [](const auto& variant) { return !variant.second->isReady(); });
+}
@@ -1,7 +1,33 @@
 #include "rendering/Texture.h"
+#include "rendering/TextureLoader.h"
+#include "rendering/KTX2File.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <vector>
+
+namespace {
+    // Formats from extensions GL 4.1 core doesn't define (S3TC, and BPTC which became core in 4.2)
+    constexpr GLenum COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+    constexpr GLenum COMPRESSED_SRGB_S3TC_DXT1 = 0x8C4C;
+    constexpr GLenum COMPRESSED_RGBA_BPTC_UNORM = 0x8E8C;
+    constexpr GLenum COMPRESSED_SRGB_ALPHA_BPTC_UNORM = 0x8E8D;
+
+    bool hasExtension(const char* name) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (extension && std::strcmp(extension, name) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+}
 
 Texture::Texture(const char* filePath) : type(TextureType::DIFFUSE), path(filePath) {
     // Generate texture ID
@@ -14,25 +40,7 @@ Texture::Texture(const char* filePath) : type(TextureType::DIFFUSE), path(filePa
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     
-    // Load image data
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(filePath, &width, &height, &nrChannels, 0);
-    if (data) {
-        GLenum format = GL_RGB;
-        if (nrChannels == 1)
-            format = GL_RED;
-        else if (nrChannels == 3)
-            format = GL_RGB;
-        else if (nrChannels == 4)
-            format = GL_RGBA;
-            
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
-        std::cerr << "Failed to load texture: " << filePath << std::endl;
-    }
-    
-    stbi_image_free(data);
+    loadFile();
 }
 
 Texture::Texture(const char* filePath, TextureType textureType) : type(textureType), path(filePath) {
@@ -46,28 +54,138 @@ Texture::Texture(const char* filePath, TextureType textureType) : type(textureTy
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     
+    loadFile();
+}
+
+Texture::Texture(const char* filePath, TextureType textureType, TextureLoader& loader)
+    : width(1), height(1), nrChannels(4), type(textureType), path(filePath) {
+    // Generate texture ID
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    
+    // Set default texture parameters
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    
+    // A single texel is a complete mip chain, so the placeholder samples correctly with mipmap filtering
+    unsigned char placeholder[4];
+    placeholderColor(textureType, placeholder);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormatFor(4, isSRGBType(type)), 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 placeholder);
+    gpuMemorySize = 4;
+    
+    // Baked files can be streamed a level at a time; anything else loads whole
+    std::string bakedPath = loader.isStreaming() ? findBakedTexture(path) : std::string();
+    if (!bakedPath.empty()) {
+        stream = loader.stream(id, bakedPath);
+    }
+    request = stream ? stream->pending : loader.load(id, path, isSRGBType(type));
+}
+
+Texture::Texture(const ORMSources& sources, TextureLoader& loader)
+    : width(1), height(1), nrChannels(4), type(TextureType::ORM), path(ormCachePath(sources)) {
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    
+    unsigned char placeholder[4];
+    placeholderColor(type, placeholder);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+    gpuMemorySize = 4;
+    
+    if (loader.isStreaming() && isORMCacheFresh(path, sources)) {
+        stream = loader.stream(id, path);
+    }
+    request = stream ? stream->pending : loader.loadPacked(id, sources);
+}
+
+void Texture::loadFile() {
+    // Prefer the baked, block-compressed file with its precomputed mip chain
+    std::string bakedPath = findBakedTexture(path);
+    if (!bakedPath.empty()) {
+        try {
+            CompressedTexture baked = readKTX2(bakedPath);
+            if (isCompressedFormatSupported(baked.format)) {
+                uploadCompressedLevels(baked, baked.data.data());
+                width = (int)baked.width;
+                height = (int)baked.height;
+                nrChannels = baked.format == BlockFormat::BC4 ? 1 : baked.format == BlockFormat::BC5 ? 2 : 4;
+                gpuMemorySize = baked.data.size();
+                return;
+            }
+            std::cerr << "Baked texture format not supported by the driver, loading the source: " << bakedPath
+                      << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
     // Load image data
     stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(filePath, &width, &height, &nrChannels, 0);
+    unsigned char* data = stbi_load(path.c_str(), &width, &height, &nrChannels, 0);
     if (data) {
-        GLenum format = GL_RGB;
-        if (nrChannels == 1)
-            format = GL_RED;
-        else if (nrChannels == 3)
-            format = GL_RGB;
-        else if (nrChannels == 4)
-            format = GL_RGBA;
-            
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+        GLenum format = formatForChannels(nrChannels);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormatFor(nrChannels, isSRGBType(type)), width, height, 0, format,
+                     GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
         glGenerateMipmap(GL_TEXTURE_2D);
+        gpuMemorySize = (size_t)width * height * nrChannels * 4 / 3;  // A full mip chain adds a third
     } else {
-        std::cerr << "Failed to load texture: " << filePath << std::endl;
+        std::cerr << "Failed to load texture: " << path << std::endl;
     }
     
     stbi_image_free(data);
 }
 
+// Neutral stand-in while the real image loads: grey albedo, flat normal, rough dielectric, no occlusion
+void Texture::placeholderColor(TextureType type, unsigned char rgba[4]) {
+    unsigned char value = 128;
+    switch (type) {
+        case TextureType::METALLIC:
+        case TextureType::SPECULAR:
+            value = 0;
+            break;
+        case TextureType::ROUGHNESS:
+        case TextureType::AO:
+            value = 255;
+            break;
+        default:
+            break;
+    }
+    rgba[0] = rgba[1] = rgba[2] = value;
+    rgba[3] = 255;
+    if (type == TextureType::NORMAL) {
+        rgba[2] = 255;
+    } else if (type == TextureType::ORM) {
+        rgba[0] = rgba[1] = 255;
+        rgba[2] = 0;
+    }
+}
+
+bool Texture::isReady() const {
+    if (!request) return true;
+    auto state = request->state.load();
+    return state == TextureRequest::State::Ready || state == TextureRequest::State::Failed;
+}
+
 void Texture::bind(GLenum textureUnit) {
+    // Pick up the real image's size once the loader has uploaded it
+    if (request && request->state == TextureRequest::State::Ready) {
+        width = request->width;
+        height = request->height;
+        nrChannels = request->channels;
+        gpuMemorySize = request->gpuBytes;
+        request.reset();
+    }
+    
     glActiveTexture(textureUnit);
     glBindTexture(GL_TEXTURE_2D, id);
 }
@@ -111,7 +229,139 @@ void Texture::uploadToUniform(GLuint shaderProgram, const char* uniformName, GLe
     glUniform1i(uniformLocation, textureUnitNumber);
 }
 
+void Texture::requestResolution(float pixels) const {
+    if (stream) {
+        stream->requestResolution(pixels);
+    }
+}
+
+size_t Texture::getGPUMemorySize() const {
+    if (stream) {
+        return stream->residentBytes();
+    }
+    // The real size may not have been picked up by bind() yet
+    if (request && request->state == TextureRequest::State::Ready) {
+        return request->gpuBytes;
+    }
+    return gpuMemorySize;
+}
+
+GLenum Texture::formatForChannels(int channels) {
+    switch (channels) {
+        case 1:
+            return GL_RED;
+        case 2:
+            return GL_RG;
+        case 4:
+            return GL_RGBA;
+        default:
+            return GL_RGB;
+    }
+}
+
+GLenum Texture::internalFormatFor(int channels, bool srgb) {
+    if (srgb && channels == 3) return GL_SRGB8;
+    if (srgb && channels == 4) return GL_SRGB8_ALPHA8;
+    return formatForChannels(channels);
+}
+
+GLenum Texture::compressedFormat(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1:
+            return COMPRESSED_RGB_S3TC_DXT1;
+        case BlockFormat::BC1_SRGB:
+            return COMPRESSED_SRGB_S3TC_DXT1;
+        case BlockFormat::BC4:
+            return GL_COMPRESSED_RED_RGTC1;
+        case BlockFormat::BC5:
+            return GL_COMPRESSED_RG_RGTC2;
+        case BlockFormat::BC7:
+            return COMPRESSED_RGBA_BPTC_UNORM;
+        default:
+            return COMPRESSED_SRGB_ALPHA_BPTC_UNORM;
+    }
+}
+
+bool Texture::isCompressedFormatSupported(BlockFormat format) {
+    // RGTC (BC4/BC5) is core; the rest must be listed by the driver or come with their extension
+    static const std::vector<GLint> listedFormats = []() {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+        std::vector<GLint> formats(std::max(count, 0));
+        if (count > 0) {
+            glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+        }
+        return formats;
+    }();
+    static const bool s3tc = hasExtension("GL_EXT_texture_compression_s3tc");
+    static const bool s3tcSRGB = s3tc && (hasExtension("GL_EXT_texture_sRGB") ||
+                                          hasExtension("GL_EXT_texture_compression_s3tc_srgb"));
+    static const bool bptc = hasExtension("GL_ARB_texture_compression_bptc");
+
+    if (std::find(listedFormats.begin(), listedFormats.end(), (GLint)compressedFormat(format)) != listedFormats.end()) {
+        return true;
+    }
+    switch (format) {
+        case BlockFormat::BC1:
+            return s3tc;
+        case BlockFormat::BC1_SRGB:
+            return s3tcSRGB;
+        case BlockFormat::BC4:
+        case BlockFormat::BC5:
+            return true;
+        default:
+            return bptc;
+    }
+}
+
+std::string Texture::findBakedTexture(const std::string& sourcePath) {
+    std::filesystem::path bakedPath(sourcePath);
+    if (bakedPath.extension() == ".ktx2") {
+        return sourcePath;
+    }
+    bakedPath.replace_extension(".ktx2");
+
+    std::error_code error;
+    auto bakedTime = std::filesystem::last_write_time(bakedPath, error);
+    if (error) {
+        return {};
+    }
+    auto sourceTime = std::filesystem::last_write_time(sourcePath, error);
+    if (!error && sourceTime > bakedTime) {
+        std::cerr << "Baked texture is older than its source, re-run the texture baker: " << bakedPath.string()
+                  << std::endl;
+        return {};
+    }
+    return bakedPath.string();
+}
+
+void Texture::uploadCompressedLevels(const CompressedTexture& texture, const unsigned char* data,
+                                     bool clampToLevels) {
+    // Exactly the levels in the file, so the texture is complete without glGenerateMipmap
+    GLenum internalFormat = compressedFormat(texture.format);
+    for (size_t i = 0; i < texture.levels.size(); ++i) {
+        const CompressedLevel& mip = texture.levels[i];
+        const void* source = data ? static_cast<const void*>(data + mip.offset)
+                                  : reinterpret_cast<const void*>((uintptr_t)mip.offset);
+        glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)(texture.firstLevel + i), internalFormat, (GLsizei)mip.width,
+                               (GLsizei)mip.height, 0, (GLsizei)mip.size, source);
+    }
+    if (clampToLevels) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)texture.firstLevel);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)(texture.firstLevel + texture.levels.size()) - 1);
+    }
+}
+
 void Texture::destroy() {
+    // Don't let a pending upload land in a deleted (or reused) texture name
+    if (request) {
+        request->cancelled = true;
+        request.reset();
+    }
+    if (stream) {
+        if (stream->pending) stream->pending->cancelled = true;
+        stream.reset();
+    }
     glDeleteTextures(1, &id);
 }
 
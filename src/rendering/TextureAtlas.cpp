@@ -0,0 +1,130 @@
+#include "rendering/TextureAtlas.h"
+#include <stb_image.h>
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+// ImGui compiles its copy of stb_rect_pack as static functions, so this file needs its own
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <imstb_rectpack.h>
+
+namespace {
+    int roundUpToPowerOfTwo(int value) {
+        int power = 1;
+        while (power < value) power *= 2;
+        return power;
+    }
+}
+
+struct TextureAtlas::Packer {
+    stbrp_context context;
+    std::vector<stbrp_node> nodes;
+};
+
+TextureAtlas::TextureAtlas(int size, bool srgb, int gutter)
+    : packer(std::make_unique<Packer>()), size(size), gutter(roundUpToPowerOfTwo(gutter)) {
+    int cells = size / this->gutter;
+    packer->nodes.resize(cells);
+    stbrp_init_target(&packer->context, cells, cells, packer->nodes.data(), cells);
+
+    glGenTextures(1, &id);
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Levels below one texel per gutter would mix neighbouring images
+    int maxLevel = 0;
+    while ((1 << maxLevel) < this->gutter) ++maxLevel;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+
+    std::vector<unsigned char> clear((size_t)size * size * 4, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                 clear.data());
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+TextureAtlas::~TextureAtlas() = default;
+
+AtlasRegion TextureAtlas::add(const std::string& path) {
+    auto found = regions.find(path);
+    if (found != regions.end()) {
+        return found->second;
+    }
+
+    stbi_set_flip_vertically_on_load(true);
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(path.c_str(), &width, &height, &channels, 4);
+    if (!pixels) {
+        std::cerr << "Failed to load texture: " << path << std::endl;
+        return {};
+    }
+    AtlasRegion region = add(pixels, width, height);
+    stbi_image_free(pixels);
+
+    if (!region.isValid()) {
+        std::cerr << "Texture doesn't fit in the atlas: " << path << std::endl;
+        return region;
+    }
+    regions[path] = region;
+    return region;
+}
+
+AtlasRegion TextureAtlas::add(const unsigned char* rgba, int width, int height) {
+    if (!rgba || width <= 0 || height <= 0) {
+        return {};
+    }
+
+    // The image plus a gutter on every side, rounded up to whole cells
+    int cellsX = (width + 2 * gutter + gutter - 1) / gutter;
+    int cellsY = (height + 2 * gutter + gutter - 1) / gutter;
+    stbrp_rect rect = {};
+    rect.w = cellsX;
+    rect.h = cellsY;
+    if (!stbrp_pack_rects(&packer->context, &rect, 1) || !rect.was_packed) {
+        return {};
+    }
+
+    // Edge texels repeated into the gutter (and the rounding beyond it)
+    int paddedWidth = cellsX * gutter, paddedHeight = cellsY * gutter;
+    std::vector<unsigned char> padded((size_t)paddedWidth * paddedHeight * 4);
+    for (int y = 0; y < paddedHeight; ++y) {
+        int sourceY = std::clamp(y - gutter, 0, height - 1);
+        for (int x = 0; x < paddedWidth; ++x) {
+            int sourceX = std::clamp(x - gutter, 0, width - 1);
+            std::copy_n(rgba + ((size_t)sourceY * width + sourceX) * 4, 4,
+                        padded.data() + ((size_t)y * paddedWidth + x) * 4);
+        }
+    }
+
+    int x = rect.x * gutter, y = rect.y * gutter;
+    glBindTexture(GL_TEXTURE_2D, id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, padded.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+    mipsDirty = true;
+    usedArea += (size_t)paddedWidth * paddedHeight;
+
+    AtlasRegion region;
+    region.offset = glm::vec2(x + gutter, y + gutter) / (float)size;
+    region.scale = glm::vec2(width, height) / (float)size;
+    return region;
+}
+
+void TextureAtlas::bind(GLenum textureUnit) {
+    glActiveTexture(textureUnit);
+    glBindTexture(GL_TEXTURE_2D, id);
+    if (mipsDirty) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+        mipsDirty = false;
+    }
+}
+
+void TextureAtlas::destroy() {
+    glDeleteTextures(1, &id);
+    id = 0;
+    regions.clear();
+}
@@ -0,0 +1,559 @@
+#include "rendering/TextureCompression.h"
+#include "utils/Parallel.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    // BC7 4-bit index interpolation weights, out of 64
+    constexpr int bc7Weights[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    // Writes little-endian bit fields, lowest bit first (the layout of every BC format)
+    class BitWriter {
+    public:
+        explicit BitWriter(unsigned char* output) : bytes(output) {}
+
+        void write(uint32_t value, int bitCount) {
+            for (int i = 0; i < bitCount; ++i, ++position) {
+                if (value & (1u << i)) {
+                    bytes[position >> 3] |= (unsigned char)(1u << (position & 7));
+                }
+            }
+        }
+
+    private:
+        unsigned char* bytes;
+        int position = 0;
+    };
+
+    float squaredError(float a, float b) { return (a - b) * (a - b); }
+    float squaredError(const glm::vec3& a, const glm::vec3& b) { glm::vec3 d = a - b; return glm::dot(d, d); }
+    float squaredError(const glm::vec4& a, const glm::vec4& b) { glm::vec4 d = a - b; return glm::dot(d, d); }
+
+    // Direction of greatest variance (power iteration on the covariance), or zero for a flat block
+    template<typename Vec>
+    Vec principalAxis(const Vec* texels, int count, const Vec& mean) {
+        using Mat = std::conditional_t<std::is_same_v<Vec, glm::vec3>, glm::mat3, glm::mat4>;
+        Mat covariance(0.0f);
+        for (int i = 0; i < count; ++i) {
+            Vec d = texels[i] - mean;
+            covariance += glm::outerProduct(d, d);
+        }
+
+        Vec axis(1.0f);
+        for (int iteration = 0; iteration < 8; ++iteration) {
+            axis = covariance * axis;
+            float length = glm::length(axis);
+            if (length < 1e-6f) {
+                return Vec(0.0f);
+            }
+            axis /= length;
+        }
+        return axis;
+    }
+
+    // Endpoints spanning the texels' projections onto their principal axis
+    template<typename Vec>
+    void fitPrincipalAxis(const Vec* texels, int count, Vec& low, Vec& high) {
+        Vec mean(0.0f);
+        for (int i = 0; i < count; ++i) mean += texels[i];
+        mean /= (float)count;
+
+        Vec axis = principalAxis(texels, count, mean);
+        float minT = 0.0f, maxT = 0.0f;
+        for (int i = 0; i < count; ++i) {
+            float t = glm::dot(texels[i] - mean, axis);
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        low = glm::clamp(mean + axis * minT, Vec(0.0f), Vec(255.0f));
+        high = glm::clamp(mean + axis * maxT, Vec(0.0f), Vec(255.0f));
+    }
+
+    // Endpoints a, b minimizing the squared error of (1 - w) * a + w * b for fixed per-texel weights.
+    // False when the weights don't constrain both endpoints (every texel on the same one)
+    template<typename Vec>
+    bool leastSquaresEndpoints(const Vec* texels, const float* weights, int count, Vec& a, Vec& b) {
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        Vec ax(0.0f), bx(0.0f);
+        for (int i = 0; i < count; ++i) {
+            float w = weights[i];
+            float u = 1.0f - w;
+            aa += u * u;
+            ab += u * w;
+            bb += w * w;
+            ax += texels[i] * u;
+            bx += texels[i] * w;
+        }
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) < 1e-6f) {
+            return false;
+        }
+        a = glm::clamp((ax * bb - bx * ab) / determinant, Vec(0.0f), Vec(255.0f));
+        b = glm::clamp((bx * aa - ax * ab) / determinant, Vec(0.0f), Vec(255.0f));
+        return true;
+    }
+
+    // ----- BC1 -----
+
+    uint16_t packRGB565(const glm::vec3& color) {
+        int r = (int)std::lround(color.r * 31.0f / 255.0f);
+        int g = (int)std::lround(color.g * 63.0f / 255.0f);
+        int b = (int)std::lround(color.b * 31.0f / 255.0f);
+        return (uint16_t)((std::clamp(r, 0, 31) << 11) | (std::clamp(g, 0, 63) << 5) | std::clamp(b, 0, 31));
+    }
+
+    glm::vec3 unpackRGB565(uint16_t packed) {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        return glm::vec3((float)((r << 3) | (r >> 2)), (float)((g << 2) | (g >> 4)), (float)((b << 3) | (b >> 2)));
+    }
+
+    struct BC1Candidate {
+        uint16_t color0 = 0;
+        uint16_t color1 = 0;
+        uint8_t indices[16] = {};
+        float error = INFINITY;
+    };
+
+    // Index 0 and 1 are the endpoints, 2 and 3 the thirds between them (four-color mode)
+    BC1Candidate evaluateBC1(const glm::vec3* texels, uint16_t color0, uint16_t color1) {
+        BC1Candidate candidate;
+        candidate.color0 = color0;
+        candidate.color1 = color1;
+        candidate.error = 0.0f;
+
+        glm::vec3 a = unpackRGB565(color0), b = unpackRGB565(color1);
+        glm::vec3 palette[4] = {a, b, (2.0f * a + b) / 3.0f, (a + 2.0f * b) / 3.0f};
+        int paletteSize = color0 == color1 ? 1 : 4;
+        for (int i = 0; i < 16; ++i) {
+            float best = INFINITY;
+            for (int p = 0; p < paletteSize; ++p) {
+                float error = squaredError(texels[i], palette[p]);
+                if (error < best) {
+                    best = error;
+                    candidate.indices[i] = (uint8_t)p;
+                }
+            }
+            candidate.error += best;
+        }
+        return candidate;
+    }
+
+    // ----- BC4 -----
+
+    struct BC4Candidate {
+        int value0 = 0;
+        int value1 = 0;
+        uint8_t indices[16] = {};
+        float error = INFINITY;
+    };
+
+    // Eight-value mode (value0 > value1): indices 2-7 step from value0 toward value1 in sevenths
+    float bc4PaletteWeight(int index) {
+        return index == 0 ? 0.0f : index == 1 ? 1.0f : (float)(index - 1) / 7.0f;
+    }
+
+    BC4Candidate evaluateBC4(const float* texels, int value0, int value1) {
+        BC4Candidate candidate;
+        candidate.value0 = value0;
+        candidate.value1 = value1;
+        candidate.error = 0.0f;
+
+        float palette[8];
+        for (int p = 0; p < 8; ++p) {
+            float w = bc4PaletteWeight(p);
+            palette[p] = (1.0f - w) * value0 + w * value1;
+        }
+        for (int i = 0; i < 16; ++i) {
+            float best = INFINITY;
+            for (int p = 0; p < 8; ++p) {
+                float error = squaredError(texels[i], palette[p]);
+                if (error < best) {
+                    best = error;
+                    candidate.indices[i] = (uint8_t)p;
+                }
+            }
+            candidate.error += best;
+        }
+        return candidate;
+    }
+
+    // ----- BC7 (mode 6: one subset, RGBA 7.7.7.7 endpoints plus a p-bit each, 4-bit indices) -----
+
+    struct BC7Candidate {
+        int endpoints[2][4] = {};  // 7-bit
+        int pBits[2] = {};
+        uint8_t indices[16] = {};
+        float error = INFINITY;
+    };
+
+    glm::vec4 bc7Endpoint(const BC7Candidate& candidate, int e) {
+        glm::vec4 value;
+        for (int c = 0; c < 4; ++c) {
+            value[c] = (float)((candidate.endpoints[e][c] << 1) | candidate.pBits[e]);
+        }
+        return value;
+    }
+
+    // Quantize both endpoints for the given p-bits and pick each texel's closest palette entry
+    BC7Candidate evaluateBC7(const glm::vec4* texels, const glm::vec4& low, const glm::vec4& high, int p0, int p1) {
+        BC7Candidate candidate;
+        candidate.pBits[0] = p0;
+        candidate.pBits[1] = p1;
+        for (int c = 0; c < 4; ++c) {
+            candidate.endpoints[0][c] = std::clamp((int)std::lround((low[c] - p0) * 0.5f), 0, 127);
+            candidate.endpoints[1][c] = std::clamp((int)std::lround((high[c] - p1) * 0.5f), 0, 127);
+        }
+
+        // Exact decoder interpolation
+        glm::vec4 e0 = bc7Endpoint(candidate, 0), e1 = bc7Endpoint(candidate, 1);
+        glm::vec4 palette[16];
+        for (int p = 0; p < 16; ++p) {
+            for (int c = 0; c < 4; ++c) {
+                palette[p][c] = (float)((((64 - bc7Weights[p]) * (int)e0[c] + bc7Weights[p] * (int)e1[c]) + 32) >> 6);
+            }
+        }
+
+        // Project onto the endpoint line for a first guess, then check its neighbours
+        glm::vec4 direction = e1 - e0;
+        float lengthSquared = glm::dot(direction, direction);
+        candidate.error = 0.0f;
+        for (int i = 0; i < 16; ++i) {
+            int guess = 0;
+            if (lengthSquared > 0.0f) {
+                float t = std::clamp(glm::dot(texels[i] - e0, direction) / lengthSquared, 0.0f, 1.0f) * 64.0f;
+                guess = (int)(std::lower_bound(bc7Weights, bc7Weights + 16, (int)t) - bc7Weights);
+            }
+            float best = INFINITY;
+            for (int p = std::max(guess - 1, 0); p <= std::min(guess + 1, 15); ++p) {
+                float error = squaredError(texels[i], palette[p]);
+                if (error < best) {
+                    best = error;
+                    candidate.indices[i] = (uint8_t)p;
+                }
+            }
+            candidate.error += best;
+        }
+        return candidate;
+    }
+
+    // ----- Mip chain -----
+
+    float srgbToLinear(float value) {
+        return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    float linearToSRGB(float value) {
+        return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    }
+
+    unsigned char toByte(float value) {
+        return (unsigned char)std::clamp((int)std::lround(value * 255.0f), 0, 255);
+    }
+
+    struct MipImage {
+        int width;
+        int height;
+        std::vector<glm::vec4> texels;
+    };
+
+    // Decode 8-bit texels into the space they are filtered in
+    MipImage decodeLevel0(const unsigned char* pixels, int width, int height, int channels, MipContent content,
+                          unsigned threadCount) {
+        std::array<float, 256> srgbTable;
+        for (int i = 0; i < 256; ++i) {
+            srgbTable[i] = srgbToLinear(i / 255.0f);
+        }
+
+        MipImage image{width, height, std::vector<glm::vec4>((size_t)width * height)};
+        parallelFor((size_t)height, [&](size_t y) {
+            for (int x = 0; x < width; ++x) {
+                const unsigned char* source = pixels + ((size_t)y * width + x) * channels;
+                unsigned char rgba[4] = {source[0], source[0], source[0], 255};
+                if (channels == 2) {
+                    rgba[1] = source[1];  // Two channels hold grey and alpha for stb_image; keep them as red and green
+                    rgba[2] = 0;
+                } else if (channels >= 3) {
+                    rgba[1] = source[1];
+                    rgba[2] = source[2];
+                    if (channels == 4) rgba[3] = source[3];
+                }
+
+                glm::vec4& texel = image.texels[y * width + x];
+                for (int c = 0; c < 4; ++c) {
+                    texel[c] = rgba[c] / 255.0f;
+                }
+                if (content == MipContent::SRGB) {
+                    texel = glm::vec4(srgbTable[rgba[0]], srgbTable[rgba[1]], srgbTable[rgba[2]], texel.a);
+                } else if (content == MipContent::NormalMap) {
+                    glm::vec3 normal = glm::vec3(texel) * 2.0f - 1.0f;
+                    float length = glm::length(normal);
+                    texel = glm::vec4(length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f), texel.a);
+                }
+            }
+        }, threadCount);
+        return image;
+    }
+
+    // Halve each dimension with the separable [1 3 3 1] / 8 filter, wrapping at the edges
+    MipImage downsample(const MipImage& source, MipContent content, unsigned threadCount) {
+        constexpr float taps[4] = {0.125f, 0.375f, 0.375f, 0.125f};
+        MipImage image{std::max(source.width / 2, 1), std::max(source.height / 2, 1), {}};
+        image.texels.resize((size_t)image.width * image.height);
+
+        auto wrap = [](int value, int size) { return ((value % size) + size) % size; };
+        parallelFor((size_t)image.height, [&](size_t y) {
+            for (int x = 0; x < image.width; ++x) {
+                glm::vec4 sum(0.0f);
+                for (int j = 0; j < 4; ++j) {
+                    // A dimension that is already 1 is left alone
+                    int sy = source.height > 1 ? wrap(2 * (int)y - 1 + j, source.height) : 0;
+                    for (int i = 0; i < 4; ++i) {
+                        int sx = source.width > 1 ? wrap(2 * x - 1 + i, source.width) : 0;
+                        sum += source.texels[(size_t)sy * source.width + sx] * (taps[i] * taps[j]);
+                    }
+                }
+                if (content == MipContent::NormalMap) {
+                    float length = glm::length(glm::vec3(sum));
+                    sum = glm::vec4(length > 0.0f ? glm::vec3(sum) / length : glm::vec3(0.0f, 0.0f, 1.0f), sum.a);
+                }
+                image.texels[y * image.width + x] = sum;
+            }
+        }, threadCount);
+        return image;
+    }
+
+    // Re-encode a filtered texel as the 8-bit RGBA the block encoders take
+    void encodeTexel(const glm::vec4& texel, MipContent content, unsigned char* rgba) {
+        glm::vec4 value = texel;
+        if (content == MipContent::SRGB) {
+            value = glm::vec4(linearToSRGB(std::max(texel.r, 0.0f)), linearToSRGB(std::max(texel.g, 0.0f)),
+                              linearToSRGB(std::max(texel.b, 0.0f)), texel.a);
+        } else if (content == MipContent::NormalMap) {
+            value = glm::vec4(glm::vec3(texel) * 0.5f + 0.5f, texel.a);
+        }
+        for (int c = 0; c < 4; ++c) {
+            rgba[c] = toByte(value[c]);
+        }
+    }
+}
+
+size_t blockBytes(BlockFormat format) {
+    switch (format) {
+        case BlockFormat::BC1:
+        case BlockFormat::BC1_SRGB:
+        case BlockFormat::BC4:
+            return 8;
+        default:
+            return 16;
+    }
+}
+
+bool isSRGBFormat(BlockFormat format) {
+    return format == BlockFormat::BC1_SRGB || format == BlockFormat::BC7_SRGB;
+}
+
+void encodeBC1Block(const unsigned char* rgba, unsigned char* block) {
+    glm::vec3 texels[16];
+    for (int i = 0; i < 16; ++i) {
+        texels[i] = glm::vec3(rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2]);
+    }
+
+    glm::vec3 low, high;
+    fitPrincipalAxis(texels, 16, low, high);
+    BC1Candidate best = evaluateBC1(texels, packRGB565(high), packRGB565(low));
+
+    // Refit the endpoints to the chosen indices while that keeps helping
+    constexpr float weights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+    for (int iteration = 0; iteration < 2 && best.error > 0.0f; ++iteration) {
+        float texelWeights[16];
+        for (int i = 0; i < 16; ++i) texelWeights[i] = weights[best.indices[i]];
+        glm::vec3 a, b;
+        if (!leastSquaresEndpoints(texels, texelWeights, 16, a, b)) break;
+        BC1Candidate refined = evaluateBC1(texels, packRGB565(a), packRGB565(b));
+        if (refined.error >= best.error) break;
+        best = refined;
+    }
+
+    // Four-color mode needs color0 > color1; swapping the endpoints swaps index pairs 0/1 and 2/3
+    if (best.color0 < best.color1) {
+        std::swap(best.color0, best.color1);
+        for (uint8_t& index : best.indices) index ^= 1;
+    }
+
+    std::memset(block, 0, 8);
+    BitWriter bits(block);
+    bits.write(best.color0, 16);
+    bits.write(best.color1, 16);
+    for (uint8_t index : best.indices) {
+        bits.write(index, 2);
+    }
+}
+
+void encodeBC4Block(const unsigned char* rgba, unsigned char* block, int channel) {
+    float texels[16];
+    float minimum = 255.0f, maximum = 0.0f;
+    for (int i = 0; i < 16; ++i) {
+        texels[i] = rgba[i * 4 + channel];
+        minimum = std::min(minimum, texels[i]);
+        maximum = std::max(maximum, texels[i]);
+    }
+
+    std::memset(block, 0, 8);
+    if (minimum == maximum) {
+        // Every index 0: the first endpoint exactly
+        block[0] = block[1] = (unsigned char)maximum;
+        return;
+    }
+
+    BC4Candidate best = evaluateBC4(texels, (int)maximum, (int)minimum);
+    float texelWeights[16];
+    for (int i = 0; i < 16; ++i) texelWeights[i] = bc4PaletteWeight(best.indices[i]);
+    float a, b;
+    if (leastSquaresEndpoints(texels, texelWeights, 16, a, b)) {
+        int value0 = (int)std::lround(a), value1 = (int)std::lround(b);
+        if (value0 != value1) {
+            BC4Candidate refined = evaluateBC4(texels, std::max(value0, value1), std::min(value0, value1));
+            if (refined.error < best.error) best = refined;
+        }
+    }
+
+    BitWriter bits(block);
+    bits.write((uint32_t)best.value0, 8);
+    bits.write((uint32_t)best.value1, 8);
+    for (uint8_t index : best.indices) {
+        bits.write(index, 3);
+    }
+}
+
+void encodeBC5Block(const unsigned char* rgba, unsigned char* block) {
+    encodeBC4Block(rgba, block, 0);
+    encodeBC4Block(rgba, block + 8, 1);
+}
+
+void encodeBC7Block(const unsigned char* rgba, unsigned char* block) {
+    glm::vec4 texels[16];
+    for (int i = 0; i < 16; ++i) {
+        texels[i] = glm::vec4(rgba[i * 4], rgba[i * 4 + 1], rgba[i * 4 + 2], rgba[i * 4 + 3]);
+    }
+
+    // Try every p-bit pair for the principal-axis endpoints, then refit to the best indices
+    glm::vec4 low, high;
+    fitPrincipalAxis(texels, 16, low, high);
+    BC7Candidate best;
+    for (int iteration = 0; iteration < 3 && best.error > 0.0f; ++iteration) {
+        BC7Candidate round;
+        for (int p = 0; p < 4; ++p) {
+            BC7Candidate candidate = evaluateBC7(texels, low, high, p & 1, p >> 1);
+            if (candidate.error < round.error) round = candidate;
+        }
+        if (round.error >= best.error) break;
+        best = round;
+
+        float texelWeights[16];
+        for (int i = 0; i < 16; ++i) texelWeights[i] = bc7Weights[best.indices[i]] / 64.0f;
+        if (!leastSquaresEndpoints(texels, texelWeights, 16, low, high)) break;
+    }
+
+    // The first texel's index is stored without its top bit, so it must be below 8
+    if (best.indices[0] >= 8) {
+        std::swap(best.endpoints[0], best.endpoints[1]);
+        std::swap(best.pBits[0], best.pBits[1]);
+        for (uint8_t& index : best.indices) index = (uint8_t)(15 - index);
+    }
+
+    std::memset(block, 0, 16);
+    BitWriter bits(block);
+    bits.write(1u << 6, 7);  // Mode 6
+    for (int c = 0; c < 4; ++c) {
+        bits.write((uint32_t)best.endpoints[0][c], 7);
+        bits.write((uint32_t)best.endpoints[1][c], 7);
+    }
+    bits.write((uint32_t)best.pBits[0], 1);
+    bits.write((uint32_t)best.pBits[1], 1);
+    for (int i = 0; i < 16; ++i) {
+        bits.write(best.indices[i], i == 0 ? 3 : 4);
+    }
+}
+
+void encodeBlock(BlockFormat format, const unsigned char* rgba, unsigned char* block) {
+    switch (format) {
+        case BlockFormat::BC1:
+        case BlockFormat::BC1_SRGB:
+            encodeBC1Block(rgba, block);
+            break;
+        case BlockFormat::BC4:
+            encodeBC4Block(rgba, block);
+            break;
+        case BlockFormat::BC5:
+            encodeBC5Block(rgba, block);
+            break;
+        case BlockFormat::BC7:
+        case BlockFormat::BC7_SRGB:
+            encodeBC7Block(rgba, block);
+            break;
+    }
+}
+
+CompressedTexture compressTexture(const unsigned char* pixels, int width, int height, int channels,
+                                  BlockFormat format, MipContent content, unsigned threadCount) {
+    if (!pixels || width <= 0 || height <= 0 || channels < 1 || channels > 4) {
+        throw std::runtime_error("Can't compress an empty image");
+    }
+
+    // Whole mip chain down to 1x1, filtered in float
+    std::vector<MipImage> mips;
+    mips.push_back(decodeLevel0(pixels, width, height, channels, content, threadCount));
+    while (mips.back().width > 1 || mips.back().height > 1) {
+        mips.push_back(downsample(mips.back(), content, threadCount));
+    }
+
+    CompressedTexture texture;
+    texture.format = format;
+    texture.width = (uint32_t)width;
+    texture.height = (uint32_t)height;
+
+    // Levels are stored back to back; one task per row of blocks in any level
+    struct BlockRow {
+        size_t level;
+        int y;
+    };
+    std::vector<BlockRow> rows;
+    size_t bytesPerBlock = blockBytes(format);
+    size_t offset = 0;
+    for (size_t level = 0; level < mips.size(); ++level) {
+        int blocksX = (mips[level].width + 3) / 4, blocksY = (mips[level].height + 3) / 4;
+        size_t size = (size_t)blocksX * blocksY * bytesPerBlock;
+        texture.levels.push_back({(uint32_t)mips[level].width, (uint32_t)mips[level].height, offset, size});
+        offset += size;
+        for (int y = 0; y < blocksY; ++y) {
+            rows.push_back({level, y});
+        }
+    }
+    texture.data.resize(offset);
+
+    parallelFor(rows.size(), [&](size_t task) {
+        const MipImage& mip = mips[rows[task].level];
+        const CompressedLevel& level = texture.levels[rows[task].level];
+        int blockY = rows[task].y;
+        int blocksX = (mip.width + 3) / 4;
+        unsigned char* output = texture.data.data() + level.offset + (size_t)blockY * blocksX * bytesPerBlock;
+
+        unsigned char rgba[64];
+        for (int blockX = 0; blockX < blocksX; ++blockX) {
+            // Blocks hanging over the edge of small levels repeat the last row/column
+            for (int j = 0; j < 4; ++j) {
+                int y = std::min(blockY * 4 + j, mip.height - 1);
+                for (int i = 0; i < 4; ++i) {
+                    int x = std::min(blockX * 4 + i, mip.width - 1);
+                    encodeTexel(mip.texels[(size_t)y * mip.width + x], content, rgba + (j * 4 + i) * 4);
+                }
+            }
+            encodeBlock(format, rgba, output + blockX * bytesPerBlock);
+        }
+    }, threadCount);
+    return texture;
+}
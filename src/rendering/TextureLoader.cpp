@@ -0,0 +1,553 @@
+#include "rendering/TextureLoader.h"
+#include "rendering/Texture.h"
+#include "rendering/KTX2File.h"
+#include "utils/Parallel.h"
+#include <stb_image.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    // Bytes copied into the PBO per step; the budget is checked between slices
+    constexpr size_t sliceBytes = 1 << 20;
+
+    // Streamed textures keep every level up to this size resident
+    constexpr int streamingTailSize = 128;
+
+    // Streamed levels in flight at once, so a burst of demand doesn't crowd out whole-texture loads
+    constexpr int maxStreamingRequests = 4;
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+TextureRequest::~TextureRequest() {
+    releasePixels();
+}
+
+void TextureRequest::releasePixels() {
+    if (pixels) {
+        stbi_image_free(pixels);
+        pixels = nullptr;
+    }
+    std::vector<unsigned char>().swap(baked.data);
+    std::vector<unsigned char>().swap(packedPixels);
+}
+
+const unsigned char* TextureRequest::uploadData() const {
+    if (!baked.levels.empty()) return baked.data.data();
+    if (!packedPixels.empty()) return packedPixels.data();
+    return pixels;
+}
+
+size_t TextureRequest::uploadSize() const {
+    return baked.levels.empty() ? (size_t)width * height * channels : baked.data.size();
+}
+
+void StreamedTexture::requestResolution(float pixels) {
+    // The level whose texels are about as big as the pixels they cover
+    float texels = (float)std::max(width, height);
+    int level = (int)std::floor(std::log2(texels / std::max(pixels, 1.0f)));
+    wantedLevel = std::min(wantedLevel, std::clamp(level, 0, levelCount() - 1));
+}
+
+size_t StreamedTexture::residentBytes() const {
+    size_t bytes = 0;
+    for (int level = residentLevel; level < levelCount(); ++level) {
+        bytes += levelBytes[level];
+    }
+    return bytes;
+}
+
+TextureLoader::TextureLoader(unsigned threadCount) {
+    // Decoding is mostly inflate; a few threads saturate the disk and leave cores for the main thread
+    if (threadCount == 0) {
+        threadCount = std::clamp(defaultThreadCount() - 1, 1u, 4u);
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&TextureLoader::workerLoop, this);
+    }
+}
+
+TextureLoader::~TextureLoader() {
+    stopWorkers();
+}
+
+void TextureLoader::queryBlockFormats() {
+    if (formatsQueried) return;
+    for (BlockFormat format : {BlockFormat::BC1, BlockFormat::BC1_SRGB, BlockFormat::BC4, BlockFormat::BC5,
+                               BlockFormat::BC7, BlockFormat::BC7_SRGB}) {
+        if (Texture::isCompressedFormatSupported(format)) {
+            supportedBlockFormats |= 1u << (int)format;
+        }
+    }
+    formatsQueried = true;
+}
+
+std::shared_ptr<TextureRequest> TextureLoader::load(GLuint texture, const std::string& filePath, bool srgb,
+                                                    const std::optional<TextureLayerTarget>& layer) {
+    auto request = std::make_shared<TextureRequest>();
+    request->path = filePath;
+    request->bakedPath = Texture::findBakedTexture(filePath);
+    request->srgb = srgb;
+    request->texture = texture;
+    request->layerTarget = layer;
+    return enqueue(std::move(request));
+}
+
+std::shared_ptr<TextureRequest> TextureLoader::loadPacked(GLuint texture, const ORMSources& sources,
+                                                          const std::optional<TextureLayerTarget>& layer) {
+    auto request = std::make_shared<TextureRequest>();
+    request->path = ormCachePath(sources);
+    if (isORMCacheFresh(request->path, sources)) {
+        request->bakedPath = request->path;
+    }
+    request->ormSources = sources;
+    request->texture = texture;
+    request->layerTarget = layer;
+    return enqueue(std::move(request));
+}
+
+std::shared_ptr<TextureRequest> TextureLoader::enqueue(std::shared_ptr<TextureRequest> request) {
+    // Workers need to know what the driver can sample, which only the GL thread can ask
+    queryBlockFormats();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        decodeQueue.push_back(request);
+    }
+    wakeWorkers.notify_one();
+    ++stats.pending;
+    return request;
+}
+
+void TextureLoader::workerLoop() {
+    // Flip per thread: the global stb setting isn't safe to share between decoders
+    stbi_set_flip_vertically_on_load_thread(true);
+
+    while (true) {
+        std::shared_ptr<TextureRequest> request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeWorkers.wait(lock, [&]() { return stopping || !decodeQueue.empty(); });
+            if (stopping) return;
+            request = std::move(decodeQueue.front());
+            decodeQueue.pop_front();
+        }
+
+        // The baked file when it's usable, otherwise the source image (or the maps to pack)
+        if ((request->bakedPath.empty() || !readBaked(*request)) && !request->streamed) {
+            if (request->ormSources) {
+                packORMTexture(*request);
+            } else {
+                request->pixels = stbi_load(request->path.c_str(), &request->width, &request->height,
+                                            &request->channels, 0);
+                if (!request->pixels) {
+                    std::cerr << "Failed to load texture: " << request->path << " (" << stbi_failure_reason() << ")"
+                              << std::endl;
+                }
+            }
+        }
+        request->state = request->uploadData() ? TextureRequest::State::Decoded : TextureRequest::State::Failed;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        uploadQueue.push_back(std::move(request));
+    }
+}
+
+bool TextureLoader::readBaked(TextureRequest& request) {
+    try {
+        CompressedTexture baked = readKTX2(request.bakedPath, request.firstLevel, request.levelCount);
+        if (!(supportedBlockFormats & (1u << (int)baked.format))) {
+            std::cerr << "Baked texture format not supported by the driver, loading the source: "
+                      << request.bakedPath << std::endl;
+            return false;
+        }
+        request.width = (int)baked.width;
+        request.height = (int)baked.height;
+        request.channels = baked.format == BlockFormat::BC4 ? 1 : baked.format == BlockFormat::BC5 ? 2 : 4;
+        request.baked = std::move(baked);
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool TextureLoader::packORMTexture(TextureRequest& request) {
+    try {
+        std::vector<unsigned char> packed = packORM(*request.ormSources, request.width, request.height);
+        request.channels = 3;
+
+        // Compressed and cached when the driver can sample it, so later runs skip packing and encoding
+        if (supportedBlockFormats & (1u << (int)BlockFormat::BC7)) {
+            request.baked = compressTexture(packed.data(), request.width, request.height, 3, BlockFormat::BC7,
+                                            MipContent::Linear);
+            try {
+                writeKTX2(request.path, request.baked);
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+            }
+        } else {
+            request.packedPixels = std::move(packed);
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+    }
+}
+
+void TextureLoader::update(double budgetMs) {
+    auto start = std::chrono::steady_clock::now();
+    updateStreaming();
+
+    do {
+        if (!current && !beginUpload()) {
+            break;
+        }
+
+        size_t totalBytes = current->uploadSize();
+        size_t slice = std::min(sliceBytes, totalBytes - copiedBytes);
+        std::memcpy(mapped + copiedBytes, current->uploadData() + copiedBytes, slice);
+        copiedBytes += slice;
+        if (copiedBytes == totalBytes) {
+            finishUpload();
+        }
+    } while (millisecondsSince(start) < budgetMs);
+
+    stats.lastUpdateMs = millisecondsSince(start);
+    stats.maxUpdateMs = std::max(stats.maxUpdateMs, stats.lastUpdateMs);
+}
+
+bool TextureLoader::beginUpload() {
+    while (true) {
+        std::shared_ptr<TextureRequest> request;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (uploadQueue.empty()) return false;
+            request = std::move(uploadQueue.front());
+            uploadQueue.pop_front();
+        }
+
+        // Failed decodes and destroyed textures keep whatever they have
+        if (request->state == TextureRequest::State::Failed || request->cancelled) {
+            if (request->state == TextureRequest::State::Failed) ++stats.failed;
+            request->releasePixels();
+            --stats.pending;
+            continue;
+        }
+
+        size_t totalBytes = request->uploadSize();
+        if (pixelBuffer == 0) {
+            glGenBuffers(1, &pixelBuffer);
+        }
+
+        // Orphan the previous storage so mapping never waits on an earlier upload
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, totalBytes, nullptr, GL_STREAM_DRAW);
+        mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, totalBytes,
+                                                  GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (!mapped) {
+            std::cerr << "Failed to map pixel buffer for texture: " << request->path << std::endl;
+            request->state = TextureRequest::State::Failed;
+            request->releasePixels();
+            ++stats.failed;
+            --stats.pending;
+            continue;
+        }
+
+        current = std::move(request);
+        copiedBytes = 0;
+        return true;
+    }
+}
+
+void TextureLoader::finishUpload() {
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+    bool intact = glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+    mapped = nullptr;
+
+    if (!intact && !current->cancelled) {
+        // The driver lost the mapped contents (e.g. a display mode change): start over from the decoded copy
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        std::lock_guard<std::mutex> lock(mutex);
+        uploadQueue.push_front(std::move(current));
+        return;
+    }
+
+    if (!current->cancelled && current->layerTarget) {
+        if (uploadLayer(*current)) {
+            current->gpuBytes = copiedBytes;
+            stats.bytesUploaded += copiedBytes;
+            ++stats.uploaded;
+            current->state = TextureRequest::State::Ready;
+        } else {
+            current->state = TextureRequest::State::Failed;
+            ++stats.failed;
+        }
+    } else if (!current->cancelled) {
+        // Offsets into the bound PBO; the copy into the texture happens asynchronously
+        glBindTexture(GL_TEXTURE_2D, current->texture);
+        if (current->streamed) {
+            // Finer levels go below the resident ones, and the base level moves down only once they're in
+            Texture::uploadCompressedLevels(current->baked, nullptr, current->levelCount == 0);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, (GLint)current->firstLevel);
+            current->gpuBytes = copiedBytes;
+        } else if (!current->baked.levels.empty()) {
+            Texture::uploadCompressedLevels(current->baked, nullptr);
+            current->gpuBytes = copiedBytes;
+        } else {
+            GLenum format = Texture::formatForChannels(current->channels);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, 0, Texture::internalFormatFor(current->channels, current->srgb), current->width,
+                         current->height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glGenerateMipmap(GL_TEXTURE_2D);
+            current->gpuBytes = copiedBytes * 4 / 3;  // A full mip chain adds a third
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+        stats.bytesUploaded += copiedBytes;
+        ++stats.uploaded;
+        current->state = TextureRequest::State::Ready;
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    current->releasePixels();
+    current.reset();
+    --stats.pending;
+}
+
+bool TextureLoader::uploadLayer(TextureRequest& request) {
+    const TextureLayerTarget& target = *request.layerTarget;
+    bool compressed = !request.baked.levels.empty();
+    GLenum internalFormat = compressed ? Texture::compressedFormat(request.baked.format)
+                                       : Texture::internalFormatFor(4, request.srgb);
+    if (internalFormat != target.internalFormat || request.width != target.width ||
+        request.height != target.height || (compressed && (int)request.baked.levels.size() != target.levels)) {
+        std::cerr << "Texture doesn't match the format or size of its array layer: " << request.path << std::endl;
+        return false;
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, request.texture);
+    if (compressed) {
+        for (size_t level = 0; level < request.baked.levels.size(); ++level) {
+            const CompressedLevel& mip = request.baked.levels[level];
+            glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)level, 0, 0, target.layer, (GLsizei)mip.width,
+                                      (GLsizei)mip.height, 1, internalFormat, (GLsizei)mip.size,
+                                      reinterpret_cast<const void*>((uintptr_t)mip.offset));
+        }
+    } else {
+        // Fewer channels than the array are expanded by GL; mipmaps are rebuilt for the whole array
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, target.layer, request.width, request.height, 1,
+                        Texture::formatForChannels(request.channels), GL_UNSIGNED_BYTE, nullptr);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return true;
+}
+
+std::shared_ptr<StreamedTexture> TextureLoader::stream(GLuint texture, const std::string& bakedPath) {
+    queryBlockFormats();
+    CompressedTexture header;
+    try {
+        header = readKTX2Header(bakedPath);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return nullptr;
+    }
+    if (!(supportedBlockFormats & (1u << (int)header.format)) || header.levels.empty()) {
+        return nullptr;
+    }
+
+    auto streamed = std::make_shared<StreamedTexture>();
+    streamed->texture = texture;
+    streamed->path = bakedPath;
+    streamed->width = (int)header.width;
+    streamed->height = (int)header.height;
+    streamed->format = header.format;
+    for (const CompressedLevel& level : header.levels) {
+        streamed->levelBytes.push_back(level.size);
+    }
+    streamed->tailLevel = streamed->levelCount() - 1;
+    for (int level = 0; level < streamed->levelCount(); ++level) {
+        if ((int)std::max(header.levels[level].width, header.levels[level].height) <= streamingTailSize) {
+            streamed->tailLevel = level;
+            break;
+        }
+    }
+    streamed->residentLevel = streamed->wantedLevel = streamed->demandLevel = streamed->levelCount();
+
+    auto request = std::make_shared<TextureRequest>();
+    request->path = bakedPath;
+    request->bakedPath = bakedPath;
+    request->texture = texture;
+    request->streamed = true;
+    request->firstLevel = (uint32_t)streamed->tailLevel;
+    streamed->pending = enqueue(std::move(request));
+    streamed->pendingLevel = streamed->tailLevel;
+
+    streamedTextures.push_back(streamed);
+    return streamed;
+}
+
+void TextureLoader::updateStreaming() {
+    ++frame;
+    std::vector<std::shared_ptr<StreamedTexture>> textures;
+    std::erase_if(streamedTextures, [&](const std::weak_ptr<StreamedTexture>& weak) {
+        if (auto texture = weak.lock()) {
+            textures.push_back(std::move(texture));
+            return false;
+        }
+        return true;
+    });
+
+    // Levels that arrived, and the resolution each texture was asked for last frame
+    size_t resident = 0;
+    int inFlight = 0;
+    for (auto& texture : textures) {
+        if (texture->pending) {
+            TextureRequest::State state = texture->pending->state;
+            if (state == TextureRequest::State::Ready) {
+                if (texture->pendingLevel < texture->tailLevel) ++streamingStats.levelsStreamed;
+                texture->residentLevel = texture->pendingLevel;
+                texture->pending.reset();
+            } else if (state == TextureRequest::State::Failed) {
+                texture->failed = true;
+                texture->pending.reset();
+            } else {
+                resident += texture->levelBytes[texture->pendingLevel];
+                ++inFlight;
+            }
+        }
+        texture->demandLevel = texture->wantedLevel;
+        texture->wantedLevel = texture->levelCount();
+        if (texture->demandLevel < texture->levelCount()) {
+            texture->lastUsedFrame = frame;
+        }
+        resident += texture->residentBytes();
+    }
+
+    // Back under budget first (it may have been lowered, or pinned memory grown)
+    size_t budget = streamingStats.budgetBytes > streamingStats.pinnedBytes
+                        ? streamingStats.budgetBytes - streamingStats.pinnedBytes : 0;
+    while (resident > budget) {
+        size_t freed = evictLevel(textures, nullptr, false);
+        if (freed == 0) break;
+        resident -= freed;
+    }
+
+    // Textures asking for more than they have, the biggest shortfall first. One level at a time, so a
+    // texture gains detail progressively and a level's request never waits on the ones below it
+    std::vector<StreamedTexture*> wanting;
+    for (auto& texture : textures) {
+        if (!texture->pending && !texture->failed && texture->residentLevel <= texture->tailLevel &&
+            texture->demandLevel < texture->residentLevel) {
+            wanting.push_back(texture.get());
+        }
+    }
+    std::stable_sort(wanting.begin(), wanting.end(), [](const StreamedTexture* a, const StreamedTexture* b) {
+        return a->residentLevel - a->demandLevel > b->residentLevel - b->demandLevel;
+    });
+    for (StreamedTexture* texture : wanting) {
+        if (inFlight >= maxStreamingRequests) break;
+
+        int level = texture->residentLevel - 1;
+        size_t bytes = texture->levelBytes[level];
+        while (resident + bytes > budget) {
+            size_t freed = evictLevel(textures, texture, true);
+            if (freed == 0) break;
+            resident -= freed;
+        }
+        if (resident + bytes > budget) {
+            continue;  // Everything resident is in use: stay at the current level
+        }
+
+        auto request = std::make_shared<TextureRequest>();
+        request->path = texture->path;
+        request->bakedPath = texture->path;
+        request->texture = texture->texture;
+        request->streamed = true;
+        request->firstLevel = (uint32_t)level;
+        request->levelCount = 1;
+        texture->pending = enqueue(std::move(request));
+        texture->pendingLevel = level;
+        resident += bytes;
+        ++inFlight;
+    }
+
+    // What last frame's draws sampled, out of what's resident
+    size_t used = 0;
+    for (auto& texture : textures) {
+        if (texture->lastUsedFrame == frame) {
+            for (int level = std::max(texture->demandLevel, texture->residentLevel); level < texture->levelCount();
+                 ++level) {
+                used += texture->levelBytes[level];
+            }
+        }
+    }
+    streamingStats.residentBytes = resident;
+    streamingStats.usedBytes = used;
+    streamingStats.textures = textures.size();
+}
+
+size_t TextureLoader::evictLevel(const std::vector<std::shared_ptr<StreamedTexture>>& textures,
+                                 const StreamedTexture* keep, bool onlyUnneeded) {
+    StreamedTexture* victim = nullptr;
+    for (const auto& texture : textures) {
+        if (texture.get() == keep || texture->pending || texture->residentLevel >= texture->tailLevel) continue;
+        bool unneeded = texture->lastUsedFrame < frame || texture->residentLevel < texture->demandLevel;
+        if (onlyUnneeded && !unneeded) continue;
+        if (!victim || texture->lastUsedFrame < victim->lastUsedFrame) {
+            victim = texture.get();
+        }
+    }
+    if (!victim) return 0;
+
+    // Move the base level off the level first, then redefine it as empty to release its storage
+    int level = victim->residentLevel;
+    glBindTexture(GL_TEXTURE_2D, victim->texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+    glCompressedTexImage2D(GL_TEXTURE_2D, level, Texture::compressedFormat(victim->format), 0, 0, 0, 0, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    victim->residentLevel = level + 1;
+    ++streamingStats.levelsEvicted;
+    return victim->levelBytes[level];
+}
+
+void TextureLoader::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeWorkers.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+void TextureLoader::destroy() {
+    stopWorkers();
+
+    if (mapped) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        mapped = nullptr;
+    }
+    if (pixelBuffer != 0) {
+        glDeleteBuffers(1, &pixelBuffer);
+        pixelBuffer = 0;
+    }
+
+    current.reset();
+    decodeQueue.clear();
+    uploadQueue.clear();
+}
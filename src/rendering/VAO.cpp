@@ -10,13 +10,21 @@ VAO::VAO() {
 }
 
 
-void VAO::LinkAttrib(VBO& vbo, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset) {
+void VAO::LinkAttrib(VBO& vbo, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset,
+                     GLboolean normalized) {
 	vbo.bind();
-	glVertexAttribPointer(layout, numComponents, type, GL_FALSE, stride, offset);
+	glVertexAttribPointer(layout, numComponents, type, normalized, stride, offset);
 	glEnableVertexAttribArray(layout);
 	vbo.unbind();
 }
 
+void VAO::linkFormat(VBO& vbo, const VertexLayout& layout) {
+	for (const auto& attribute : layout.attributes) {
+		LinkAttrib(vbo, attribute.location, attribute.components, attribute.type, layout.stride,
+		           (void*)attribute.offset, attribute.normalized);
+	}
+}
+
 void VAO::bind() {
 	glBindVertexArray(id);
 }
@@ -1,10 +1,13 @@
 #include "rendering/VBO.h"
 
-VBO::VBO(const std::vector<Vertex>& vertices) {
+VBO::VBO(std::span<const Vertex> vertices) : VBO(std::as_bytes(vertices)) {
+}
+
+VBO::VBO(std::span<const std::byte> data) {
 	glGenBuffers(1, &id);
 	
 	glBindBuffer(GL_ARRAY_BUFFER, id);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, data.size_bytes(), data.data(), GL_STATIC_DRAW);
 }
 
 void VBO::bind() {
@@ -0,0 +1,147 @@
+#include "rendering/VertexCompression.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    float signNotZero(float value) {
+        return value >= 0.0f ? 1.0f : -1.0f;
+    }
+
+    int16_t toSnorm16(float value) {
+        return (int16_t)std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f);
+    }
+
+    uint16_t toUnorm16(float value) {
+        return (uint16_t)std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f);
+    }
+}
+
+VertexQuantization VertexQuantization::fromBounds(const BoundingBox& bounds) {
+    VertexQuantization quantization;
+    if (bounds.isValid()) {
+        quantization.offset = bounds.getMin();
+        quantization.scale = bounds.getMax() - bounds.getMin();
+    }
+    return quantization;
+}
+
+glm::vec2 octEncode(const glm::vec3& direction) {
+    float sum = std::fabs(direction.x) + std::fabs(direction.y) + std::fabs(direction.z);
+    if (sum == 0.0f) {
+        return glm::vec2(0.0f);  // Decodes to +Z
+    }
+
+    // Project onto the octahedron, then fold the lower hemisphere over the diagonals
+    glm::vec2 encoded(direction.x / sum, direction.y / sum);
+    if (direction.z < 0.0f) {
+        encoded = glm::vec2((1.0f - std::fabs(encoded.y)) * signNotZero(encoded.x),
+                            (1.0f - std::fabs(encoded.x)) * signNotZero(encoded.y));
+    }
+    return encoded;
+}
+
+glm::vec3 octDecode(const glm::vec2& encoded) {
+    glm::vec3 direction(encoded.x, encoded.y, 1.0f - std::fabs(encoded.x) - std::fabs(encoded.y));
+    if (direction.z < 0.0f) {
+        direction.x = (1.0f - std::fabs(encoded.y)) * signNotZero(encoded.x);
+        direction.y = (1.0f - std::fabs(encoded.x)) * signNotZero(encoded.y);
+    }
+    return glm::normalize(direction);
+}
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t exponent = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    // Infinity and NaN (keeping NaNs quiet)
+    if (exponent == 0xff) {
+        return (uint16_t)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    }
+
+    int halfExponent = (int)exponent - 127 + 15;
+    if (halfExponent >= 31) {
+        return (uint16_t)(sign | 0x7c00);  // Too large: infinity
+    }
+
+    // Subnormal half (or zero): shift the full mantissa, implicit bit included, into place
+    if (halfExponent <= 0) {
+        if (halfExponent < -10) {
+            return (uint16_t)sign;
+        }
+        mantissa |= 0x800000;
+        uint32_t shift = (uint32_t)(14 - halfExponent);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) {
+            ++half;
+        }
+        return (uint16_t)(sign | half);
+    }
+
+    // Normal half. A rounding carry correctly bumps the exponent (up to infinity)
+    uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        ++half;
+    }
+    return (uint16_t)(sign | half);
+}
+
+float halfToFloat(uint16_t value) {
+    uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    uint32_t exponent = (value >> 10) & 0x1f;
+    uint32_t mantissa = value & 0x3ff;
+
+    if (exponent == 0) {
+        float magnitude = std::ldexp((float)mantissa, -24);
+        return sign ? -magnitude : magnitude;
+    }
+
+    uint32_t bits = (exponent == 31) ? (sign | 0x7f800000 | (mantissa << 13))
+                                     : (sign | ((exponent + 112) << 23) | (mantissa << 13));
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+std::vector<std::byte> PackedVertexFormat::encode(std::span<const Vertex> vertices,
+                                                  const VertexQuantization& quantization) {
+    // Flat axes (zero extent) quantize to 0 and decode to the offset
+    glm::vec3 inverseScale(0.0f);
+    for (int axis = 0; axis < 3; ++axis) {
+        if (quantization.scale[axis] > 0.0f) {
+            inverseScale[axis] = 1.0f / quantization.scale[axis];
+        }
+    }
+
+    std::vector<std::byte> data(vertices.size() * sizeof(PackedVertex));
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const Vertex& vertex = vertices[i];
+        PackedVertex out;
+
+        glm::vec3 position = (vertex.position - quantization.offset) * inverseScale;
+        glm::vec2 normal = octEncode(vertex.normal);
+        glm::vec2 tangent = octEncode(vertex.tangent);
+
+        // Handedness of the original frame: does the stored bitangent agree with cross(normal, tangent)?
+        bool rightHanded = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent) >= 0.0f;
+
+        out.position[0] = toUnorm16(position.x);
+        out.position[1] = toUnorm16(position.y);
+        out.position[2] = toUnorm16(position.z);
+        out.position[3] = rightHanded ? 65535 : 0;
+        out.texCoord[0] = floatToHalf(vertex.texCoord.x);
+        out.texCoord[1] = floatToHalf(vertex.texCoord.y);
+        out.normal[0] = toSnorm16(normal.x);
+        out.normal[1] = toSnorm16(normal.y);
+        out.tangent[0] = toSnorm16(tangent.x);
+        out.tangent[1] = toSnorm16(tangent.y);
+        std::memcpy(data.data() + i * sizeof(PackedVertex), &out, sizeof(out));
+    }
+    return data;
+}
@@ -0,0 +1,79 @@
+#include "rendering/VertexFormat.h"
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace {
+    // Inputs declared as float vectors accept any glVertexAttribPointer data; integer inputs would need
+    // glVertexAttribIPointer
+    bool isFloatInput(GLenum type) {
+        switch (type) {
+            case GL_FLOAT:
+            case GL_FLOAT_VEC2:
+            case GL_FLOAT_VEC3:
+            case GL_FLOAT_VEC4:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    size_t componentSize(GLenum type) {
+        switch (type) {
+            case GL_BYTE:
+            case GL_UNSIGNED_BYTE:
+                return 1;
+            case GL_SHORT:
+            case GL_UNSIGNED_SHORT:
+            case GL_HALF_FLOAT:
+                return 2;
+            default:
+                return 4;
+        }
+    }
+}
+
+bool validateVertexLayout(GLuint program, const VertexLayout& layout, const std::string& label) {
+    GLint inputCount = 0;
+    GLint maxNameLength = 0;
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTES, &inputCount);
+    glGetProgramiv(program, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxNameLength);
+
+    bool valid = true;
+    uint32_t readLocations = 0;
+    std::vector<GLchar> name(std::max(maxNameLength, 1));
+    for (GLint i = 0; i < inputCount; ++i) {
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveAttrib(program, (GLuint)i, (GLsizei)name.size(), nullptr, &size, &type, name.data());
+        GLint location = glGetAttribLocation(program, name.data());
+        if (location < 0) {
+            continue;  // Built-ins such as gl_VertexID
+        }
+        readLocations |= 1u << location;
+
+        const VertexAttribute* attribute = layout.find((GLuint)location);
+        if (!attribute) {
+            if (!(layout.derivedLocations & (1u << location))) {
+                std::cerr << "ERROR::VERTEX_LAYOUT::" << label << ": shader input " << name.data() << " (location = "
+                          << location << ") is not provided by the vertex format" << std::endl;
+                valid = false;
+            }
+            continue;
+        }
+        if (!isFloatInput(type)) {
+            std::cerr << "ERROR::VERTEX_LAYOUT::" << label << ": shader input " << name.data() << " (location = "
+                      << location << ") is not a float type" << std::endl;
+            valid = false;
+        }
+    }
+
+    for (const auto& attribute : layout.attributes) {
+        if (!(readLocations & (1u << attribute.location))) {
+            std::cerr << "WARNING::VERTEX_LAYOUT::" << label << ": location " << attribute.location
+                      << " is never read by the shader (" << attribute.components * componentSize(attribute.type)
+                      << " wasted bytes per vertex)" << std::endl;
+        }
+    }
+    return valid;
+}
@@ -1,9 +1,77 @@
 #include "rendering/shader.h"
+#include "rendering/ProgramCache.h"
+#include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <glm/gtc/type_ptr.hpp>
 
-Shader::Shader(const char* vertexPath, const char* fragmentPath){
+namespace {
+	constexpr int unresolvedUniform = -2;
+
+	// GL_KHR_parallel_shader_compile (same values as the ARB extension); not in the GL 4.1 headers
+	constexpr GLenum completionStatus = 0x91B1;
+	typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSPROC)(GLuint count);
+	bool parallelCompile = false;
+
+	bool hasExtension(const char* name) {
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; ++i) {
+			const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (extension && std::strcmp(extension, name) == 0) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Interned uniform names and the types their handles expect; ids index this list
+	std::vector<std::pair<std::string, GLenum>>& internedUniforms() {
+		static std::vector<std::pair<std::string, GLenum>> uniforms;
+		return uniforms;
+	}
+
+	bool isSamplerType(GLenum type) {
+		switch (type) {
+			case GL_SAMPLER_1D: case GL_SAMPLER_2D: case GL_SAMPLER_3D: case GL_SAMPLER_CUBE:
+			case GL_SAMPLER_2D_SHADOW: case GL_SAMPLER_2D_ARRAY: case GL_SAMPLER_2D_ARRAY_SHADOW:
+			case GL_SAMPLER_CUBE_SHADOW: case GL_SAMPLER_BUFFER: case GL_INT_SAMPLER_2D:
+			case GL_INT_SAMPLER_BUFFER: case GL_UNSIGNED_INT_SAMPLER_2D: case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	// Whether a handle expecting `expected` can set a uniform declared as `actual`
+	bool uniformTypeMatches(GLenum actual, GLenum expected) {
+		if (actual == expected) {
+			return true;
+		}
+		return expected == GL_INT && (actual == GL_BOOL || isSamplerType(actual));
+	}
+
+	// Insert the defines after the #version line, which must stay first
+	void insertDefines(std::string& code, const std::vector<std::string>& defines) {
+		if (defines.empty()) {
+			return;
+		}
+		std::string block;
+		for (const std::string& define : defines) {
+			block += "#define " + define + "\n";
+		}
+		size_t version = code.find("#version");
+		size_t lineEnd = version == std::string::npos ? std::string::npos : code.find('\n', version);
+		if (lineEnd == std::string::npos) {
+			code.insert(0, block);
+		} else {
+			code.insert(lineEnd + 1, block);
+		}
+	}
+}
+
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string>& defines){
 	std::ifstream vertexFile(vertexPath);
 	if (!vertexFile.is_open()) {
 		std::cerr << "ERROR::SHADER::VERTEX::FILE_NOT_SUCCESSFULLY_READ" << std::endl;
@@ -20,38 +88,94 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath){
 	std::string fragmentCode((std::istreambuf_iterator<char>(fragmentFile)),
 						 std::istreambuf_iterator<char>());
 
+	insertDefines(vertexCode, defines);
+	insertDefines(fragmentCode, defines);
+
+	// A binary from an earlier run skips compiling and linking altogether
+	id = glCreateProgram();
+	uint64_t cacheKey = programCacheKey(vertexCode, fragmentCode);
+	if (loadCachedProgram(id, cacheKey)) {
+		reflectUniforms();
+		return;
+	}
+	PendingBuild build;
+	build.cacheKey = cacheKey;
+	build.submitted = std::chrono::steady_clock::now();
+
 	const char* vertexSource = vertexCode.c_str();
 	const char* fragmentSource = fragmentCode.c_str();
 
-	GLuint vertexShader = glCreateShader(GL_VERTEX_SHADER);
-	glShaderSource(vertexShader, 1, &vertexSource, NULL);
-	glCompileShader(vertexShader);
-	
-	// Check for vertex shader compilation errors
+	// No status queries here: each one would wait for the driver to finish before the next shader is submitted
+	build.vertexShader = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(build.vertexShader, 1, &vertexSource, NULL);
+	glCompileShader(build.vertexShader);
+
+	build.fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(build.fragmentShader, 1, &fragmentSource, NULL);
+	glCompileShader(build.fragmentShader);
+
+	glAttachShader(id, build.vertexShader);
+	glAttachShader(id, build.fragmentShader);
+	prepareProgramForCache(id);
+	glLinkProgram(id);
+	pending = build;
+}
+
+bool Shader::enableParallelCompile(GLADloadproc getProcAddress) {
+	const char* names[][2] = {{"GL_KHR_parallel_shader_compile", "glMaxShaderCompilerThreadsKHR"},
+							  {"GL_ARB_parallel_shader_compile", "glMaxShaderCompilerThreadsARB"}};
+	for (const auto& [extension, function] : names) {
+		if (!hasExtension(extension)) {
+			continue;
+		}
+		// Let the driver pick how many threads to use
+		auto maxShaderCompilerThreads = (PFNGLMAXSHADERCOMPILERTHREADSPROC)getProcAddress(function);
+		if (maxShaderCompilerThreads) {
+			maxShaderCompilerThreads(0xFFFFFFFF);
+		}
+		parallelCompile = true;
+		std::cout << "Compiling shaders in parallel (" << extension << ")" << std::endl;
+		return true;
+	}
+	return false;
+}
+
+bool Shader::isReady() const {
+	if (!pending || !parallelCompile) {
+		return true;
+	}
+	if (!pending->built) {
+		GLint done = GL_FALSE;
+		glGetProgramiv(id, completionStatus, &done);
+		if (!done) {
+			return false;
+		}
+		pending->built = std::chrono::steady_clock::now();
+	}
+	return true;
+}
+
+void Shader::finishBuild() const {
+	if (!pending) {
+		return;
+	}
+	PendingBuild build = *pending;
+	pending.reset();
+
+	// Check for compilation errors
 	GLint success;
 	GLchar infoLog[512];
-	glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+	glGetShaderiv(build.vertexShader, GL_COMPILE_STATUS, &success);
 	if (!success) {
-		glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
+		glGetShaderInfoLog(build.vertexShader, 512, NULL, infoLog);
 		std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
 	}
-
-	GLuint fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-	glShaderSource(fragmentShader, 1, &fragmentSource, NULL);
-	glCompileShader(fragmentShader);
-	
-	// Check for fragment shader compilation errors
-	glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+	glGetShaderiv(build.fragmentShader, GL_COMPILE_STATUS, &success);
 	if (!success) {
-		glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
+		glGetShaderInfoLog(build.fragmentShader, 512, NULL, infoLog);
 		std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
 	}
 
-	id = glCreateProgram();
-	glAttachShader(id, vertexShader);
-	glAttachShader(id, fragmentShader);
-	glLinkProgram(id);
-	
 	// Check for linking errors
 	glGetProgramiv(id, GL_LINK_STATUS, &success);
 	if (!success) {
@@ -59,51 +183,177 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath){
 		std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
 	}
 
-	glDeleteShader(vertexShader);
-	glDeleteShader(fragmentShader);
+	glDeleteShader(build.vertexShader);
+	glDeleteShader(build.fragmentShader);
+
+	if (success) {
+		// Up to when the build was seen to be done, not to its first use, which may be much later
+		auto built = build.built.value_or(std::chrono::steady_clock::now());
+		double buildMs = std::chrono::duration<double, std::milli>(built - build.submitted).count();
+		storeCachedProgram(id, build.cacheKey, buildMs);
+		reflectUniforms();
+	}
+}
+
+int Shader::internUniform(const char* name, GLenum type) {
+	static std::unordered_map<std::string, int> ids;
+	std::string key = std::string(name) + '#' + std::to_string(type);
+	auto found = ids.find(key);
+	if (found != ids.end()) {
+		return found->second;
+	}
+	int id = (int)internedUniforms().size();
+	internedUniforms().emplace_back(name, type);
+	ids.emplace(key, id);
+	return id;
+}
+
+void Shader::reflectUniforms() const {
+	GLint count = 0;
+	GLint maxLength = 0;
+	glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+	std::vector<GLchar> nameBuffer(std::max(maxLength, 1));
+
+	for (GLuint index = 0; index < (GLuint)count; ++index) {
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(id, index, (GLsizei)nameBuffer.size(), &length, &size, &type, nameBuffer.data());
+		std::string name(nameBuffer.data(), length);
+
+		// Uniform block members have no location; they're set through their buffer
+		GLint location = glGetUniformLocation(id, name.c_str());
+		if (location < 0) {
+			continue;
+		}
+
+		// Arrays are reported once, as "name[0]"; every element gets a slot of its own
+		bool isArray = name.size() > 3 && name.ends_with("[0]");
+		std::string baseName = isArray ? name.substr(0, name.size() - 3) : name;
+		uniformsByName[baseName] = (int)uniforms.size();
+		for (int element = 0; element < size; ++element) {
+			UniformSlot slot;
+			slot.type = type;
+			slot.arraySize = size - element;
+			if (isArray) {
+				std::string elementName = baseName + "[" + std::to_string(element) + "]";
+				slot.location = element == 0 ? location : glGetUniformLocation(id, elementName.c_str());
+				uniformsByName[elementName] = (int)uniforms.size();
+			} else {
+				slot.location = location;
+			}
+			uniforms.push_back(slot);
+		}
+	}
+}
+
+int Shader::slotFor(int uniformId) const {
+	finishBuild();
+	if (uniformId < (int)uniformsById.size() && uniformsById[uniformId] != unresolvedUniform) {
+		return uniformsById[uniformId];
+	}
+	if (uniformId >= (int)uniformsById.size()) {
+		uniformsById.resize(uniformId + 1, unresolvedUniform);
+	}
+
+	const auto& [name, type] = internedUniforms()[uniformId];
+	auto found = uniformsByName.find(name);
+	int slot = found == uniformsByName.end() ? -1 : found->second;
+	if (slot >= 0 && !uniformTypeMatches(uniforms[slot].type, type)) {
+		std::cerr << "ERROR::SHADER::UNIFORM_TYPE_MISMATCH " << name << std::endl;
+		slot = -1;
+	}
+	uniformsById[uniformId] = slot;
+	return slot;
 }
 
 void Shader::use() {
+	finishBuild();
 	glUseProgram(id);
 }
 
 void Shader::destroy() {
+	if (pending) {
+		glDeleteShader(pending->vertexShader);
+		glDeleteShader(pending->fragmentShader);
+		pending.reset();
+	}
 	glDeleteProgram(id);
 }
 
 void Shader::setBool(const std::string& name, bool value) const {
-	glUniform1i(glGetUniformLocation(id, name.c_str()), (int)value);
+	storeByName(name, value);
 }
 
 void Shader::setInt(const std::string& name, int value) const {
-	glUniform1i(glGetUniformLocation(id, name.c_str()), value);
+	storeByName(name, value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const {
-	glUniform1f(glGetUniformLocation(id, name.c_str()), value);
+	storeByName(name, value);
 }
 
 void Shader::setVec2(const std::string& name, const glm::vec2& value) const {
-	glUniform2fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+	storeByName(name, value);
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const {
-	glUniform3fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+	storeByName(name, value);
 }
 
 void Shader::setVec4(const std::string& name, const glm::vec4& value) const {
-	glUniform4fv(glGetUniformLocation(id, name.c_str()), 1, &value[0]);
+	storeByName(name, value);
 }
 
 void Shader::setMat2(const std::string& name, const glm::mat2& value) const {
-	glUniformMatrix2fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, &value[0][0]);
+	storeByName(name, value);
 }
 
 void Shader::setMat3(const std::string& name, const glm::mat3& value) const {
-	glUniformMatrix3fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, &value[0][0]);
+	storeByName(name, value);
 }
 
 void Shader::setMat4(const std::string& name, const glm::mat4& value) const {
-	glUniformMatrix4fv(glGetUniformLocation(id, name.c_str()), 1, GL_FALSE, glm::value_ptr(value));
+	storeByName(name, value);
+}
+
+void Shader::upload(GLint location, bool value) {
+	glUniform1i(location, (int)value);
+}
+
+void Shader::upload(GLint location, int value) {
+	glUniform1i(location, value);
+}
+
+void Shader::upload(GLint location, float value) {
+	glUniform1f(location, value);
+}
+
+void Shader::upload(GLint location, const glm::ivec3& value) {
+	glUniform3iv(location, 1, &value[0]);
+}
+
+void Shader::upload(GLint location, const glm::vec2& value) {
+	glUniform2fv(location, 1, &value[0]);
+}
+
+void Shader::upload(GLint location, const glm::vec3& value) {
+	glUniform3fv(location, 1, &value[0]);
+}
+
+void Shader::upload(GLint location, const glm::vec4& value) {
+	glUniform4fv(location, 1, &value[0]);
+}
+
+void Shader::upload(GLint location, const glm::mat2& value) {
+	glUniformMatrix2fv(location, 1, GL_FALSE, &value[0][0]);
+}
+
+void Shader::upload(GLint location, const glm::mat3& value) {
+	glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
 }
 
+void Shader::upload(GLint location, const glm::mat4& value) {
+	glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+// Offline texture baker: compresses PBR maps to BC formats with precomputed mip chains and writes them as
+// .ktx2 files next to the sources, where Texture picks them up. CPU only, so it runs without a GPU or display.
+//
+//   texture_baker [--threads N] [--albedo bc7|bc1] [--force] <image or directory>...
+//
+// The map type comes from the file name: *_albedo -> BC7/BC1 sRGB, *_normal -> BC5, *_metallic, *_roughness,
+// *_ao -> BC4. Other images are skipped
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include "rendering/KTX2File.h"
+#include "rendering/TextureCompression.h"
+#include "utils/Parallel.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    struct BakeSettings {
+        unsigned threadCount = 0;
+        BlockFormat albedoFormat = BlockFormat::BC7_SRGB;
+        bool force = false;
+    };
+
+    bool endsWith(const std::string& text, const std::string& suffix) {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // Format and filtering for a map, from its name; false for images that aren't PBR maps
+    bool classify(const std::filesystem::path& path, const BakeSettings& settings, BlockFormat& format,
+                  MipContent& content) {
+        std::string stem = path.stem().string();
+        if (endsWith(stem, "_albedo")) {
+            format = settings.albedoFormat;
+            content = MipContent::SRGB;
+        } else if (endsWith(stem, "_normal")) {
+            format = BlockFormat::BC5;
+            content = MipContent::NormalMap;
+        } else if (endsWith(stem, "_metallic") || endsWith(stem, "_roughness") || endsWith(stem, "_ao")) {
+            format = BlockFormat::BC4;
+            content = MipContent::Linear;
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    const char* formatName(BlockFormat format) {
+        switch (format) {
+            case BlockFormat::BC1: return "BC1";
+            case BlockFormat::BC1_SRGB: return "BC1 sRGB";
+            case BlockFormat::BC4: return "BC4";
+            case BlockFormat::BC5: return "BC5";
+            case BlockFormat::BC7: return "BC7";
+            default: return "BC7 sRGB";
+        }
+    }
+
+    // Bake one image; false on failure
+    bool bake(const std::filesystem::path& source, const BakeSettings& settings) {
+        BlockFormat format;
+        MipContent content;
+        if (!classify(source, settings, format, content)) {
+            return true;
+        }
+
+        std::filesystem::path output = source;
+        output.replace_extension(".ktx2");
+        std::error_code error;
+        if (!settings.force && std::filesystem::exists(output, error) &&
+            std::filesystem::last_write_time(output, error) >= std::filesystem::last_write_time(source, error)) {
+            std::cout << output.string() << " is up to date" << std::endl;
+            return true;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        int width, height, channels;
+        unsigned char* pixels = stbi_load(source.string().c_str(), &width, &height, &channels, 0);
+        if (!pixels) {
+            std::cerr << "Failed to load texture: " << source.string() << " (" << stbi_failure_reason() << ")"
+                      << std::endl;
+            return false;
+        }
+
+        try {
+            CompressedTexture texture = compressTexture(pixels, width, height, channels, format, content,
+                                                        settings.threadCount);
+            stbi_image_free(pixels);
+            writeKTX2(output.string(), texture);
+
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            size_t uncompressed = (size_t)width * height * channels * 4 / 3;
+            std::cout << output.string() << ": " << width << "x" << height << " " << formatName(format) << ", "
+                      << texture.levels.size() << " levels, " << uncompressed / 1024 << " KB -> "
+                      << texture.data.size() / 1024 << " KB in " << seconds << " s" << std::endl;
+        } catch (const std::exception& e) {
+            stbi_image_free(pixels);
+            std::cerr << e.what() << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    BakeSettings settings;
+    std::vector<std::filesystem::path> sources;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--threads" && i + 1 < argc) {
+            settings.threadCount = (unsigned)std::stoul(argv[++i]);
+        } else if (argument == "--albedo" && i + 1 < argc) {
+            std::string format = argv[++i];
+            settings.albedoFormat = format == "bc1" ? BlockFormat::BC1_SRGB : BlockFormat::BC7_SRGB;
+        } else if (argument == "--force") {
+            settings.force = true;
+        } else if (std::filesystem::is_directory(argument)) {
+            for (const auto& entry : std::filesystem::directory_iterator(argument)) {
+                std::string extension = entry.path().extension().string();
+                if (entry.is_regular_file() && (extension == ".png" || extension == ".jpg" || extension == ".tga")) {
+                    sources.push_back(entry.path());
+                }
+            }
+        } else {
+            sources.push_back(argument);
+        }
+    }
+
+    if (sources.empty()) {
+        std::cerr << "Usage: texture_baker [--threads N] [--albedo bc7|bc1] [--force] <image or directory>..."
+                  << std::endl;
+        return 1;
+    }
+
+    // Flipped like the renderer loads images, so baked rows are already in GL order
+    stbi_set_flip_vertically_on_load(true);
+
+    std::cout << "Baking with " << (settings.threadCount ? settings.threadCount : defaultThreadCount())
+              << " threads" << std::endl;
+    bool succeeded = true;
+    for (const auto& source : sources) {
+        succeeded = bake(source, settings) && succeeded;
+    }
+    return succeeded ? 0 : 1;
+}